@@ -0,0 +1,190 @@
+// Build-time tool, which packs game assets into single compressed blob.
+// Usage: AssetPacker <output header path> <file with list of input files>.
+// Output header contains index of assets and blob itself and is included by "Assets.cpp".
+//
+// Each asset is compressed separately with simple LZ77 variant, which decompressor in "Assets.cpp" understands.
+// Compressed stream is sequence of blocks:
+//  * token byte: high 4 bits - number of literals, low 4 bits - match length minus 4.
+//    Value 15 of each field means, that it's continued with extra bytes, until byte less than 255 (all bytes are added).
+//  * literals
+//  * match offset (2 bytes, little-endian). Match is absent for last block, which ends at asset end.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../tools_common/ToolFiles.hpp"
+
+namespace
+{
+
+constexpr const uint32_t c_min_match_length = 4;
+constexpr const uint32_t c_max_match_offset = 65535;
+constexpr const uint32_t c_hash_bits = 16;
+constexpr const uint32_t c_max_chain_length = 256;
+
+void WriteLength(std::vector<uint8_t>& out, uint32_t length)
+{
+	while(length >= 255)
+	{
+		out.push_back(255);
+		length -= 255;
+	}
+	out.push_back(uint8_t(length));
+}
+
+void WriteBlock(
+	std::vector<uint8_t>& out,
+	const uint8_t* const literals,
+	const uint32_t num_literals,
+	const uint32_t match_offset,
+	const uint32_t match_length)
+{
+	const uint32_t match_length_code = match_length == 0 ? 0 : match_length - c_min_match_length;
+	out.push_back(uint8_t((std::min(num_literals, 15u) << 4) | std::min(match_length_code, 15u)));
+	if(num_literals >= 15)
+	{
+		WriteLength(out, num_literals - 15);
+	}
+
+	out.insert(out.end(), literals, literals + num_literals);
+
+	if(match_length > 0)
+	{
+		out.push_back(uint8_t(match_offset & 0xFF));
+		out.push_back(uint8_t(match_offset >> 8));
+		if(match_length_code >= 15)
+		{
+			WriteLength(out, match_length_code - 15);
+		}
+	}
+}
+
+uint32_t Hash(const uint8_t* const data)
+{
+	const uint32_t v = uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+	return (v * 2654435761u) >> (32 - c_hash_bits);
+}
+
+// Greedy compression with hash chains.
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& in)
+{
+	std::vector<uint8_t> out;
+
+	const uint32_t size = uint32_t(in.size());
+	std::vector<int32_t> head(size_t(1) << c_hash_bits, -1);
+	std::vector<int32_t> prev(size, -1);
+
+	uint32_t literals_start = 0;
+	uint32_t pos = 0;
+	while(pos + c_min_match_length <= size)
+	{
+		const uint32_t hash = Hash(in.data() + pos);
+
+		uint32_t best_length = 0;
+		uint32_t best_offset = 0;
+		int32_t candidate = head[hash];
+		for(uint32_t i = 0; i < c_max_chain_length && candidate >= 0 && pos - uint32_t(candidate) <= c_max_match_offset; ++i)
+		{
+			uint32_t length = 0;
+			while(pos + length < size && in[uint32_t(candidate) + length] == in[pos + length])
+			{
+				++length;
+			}
+			if(length > best_length)
+			{
+				best_length = length;
+				best_offset = pos - uint32_t(candidate);
+			}
+			candidate = prev[uint32_t(candidate)];
+		}
+
+		if(best_length < c_min_match_length)
+		{
+			prev[pos] = head[hash];
+			head[hash] = int32_t(pos);
+			++pos;
+			continue;
+		}
+
+		WriteBlock(out, in.data() + literals_start, pos - literals_start, best_offset, best_length);
+
+		for(uint32_t end = pos + best_length; pos < end; ++pos)
+		{
+			if(pos + c_min_match_length <= size)
+			{
+				const uint32_t h = Hash(in.data() + pos);
+				prev[pos] = head[h];
+				head[h] = int32_t(pos);
+			}
+		}
+		literals_start = pos;
+	}
+
+	// Last block contains only literals.
+	WriteBlock(out, in.data() + literals_start, size - literals_start, 0, 0);
+
+	return out;
+}
+
+} // namespace
+
+int main(const int argc, const char* const* const argv)
+{
+	if(argc != 3)
+	{
+		std::fprintf(stderr, "Usage: AssetPacker <output header path> <file with list of input files>\n");
+		return 1;
+	}
+
+	std::vector<std::string> input_paths;
+	if(!ReadListFile(argv[2], input_paths))
+	{
+		std::fprintf(stderr, "Can't read \"%s\"\n", argv[2]);
+		return 1;
+	}
+
+	std::string index;
+	std::vector<uint8_t> blob;
+	size_t total_size = 0;
+	for(const std::string& path : input_paths)
+	{
+		std::vector<uint8_t> content;
+		if(!ReadFile(path, content))
+		{
+			std::fprintf(stderr, "Can't read \"%s\"\n", path.c_str());
+			return 1;
+		}
+
+		const std::vector<uint8_t> compressed = Compress(content);
+		index +=
+			"\t{" + std::to_string(blob.size()) + ", " +
+			std::to_string(compressed.size()) + ", " +
+			std::to_string(content.size()) + "},\n";
+		blob.insert(blob.end(), compressed.begin(), compressed.end());
+		total_size += content.size();
+	}
+
+	std::string out = "// Generated by AssetPacker.\n";
+	out += "// " + std::to_string(input_paths.size()) + " assets, " + std::to_string(total_size) + " bytes compressed into " + std::to_string(blob.size()) + " bytes.\n\n";
+	out += "inline const AssetsBlobEntry c_assets_blob_index[]\n{\n" + index + "};\n\n";
+	out += "inline const uint8_t c_assets_blob[]\n{\n";
+	for(size_t i = 0; i < blob.size(); ++i)
+	{
+		out += (i % 32 == 0 ? "\t" : " ") + std::to_string(blob[i]) + ",";
+		if(i % 32 == 31 || i + 1 == blob.size())
+		{
+			out += "\n";
+		}
+	}
+	out += "};\n";
+
+	if(!WriteFile(argv[1], out))
+	{
+		std::fprintf(stderr, "Can't write \"%s\"\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+// Build-time tool, which generates specialized drawing function for each small sprite in each orientation.
+// Usage: SpriteCompiler <output header path> <file with list of sprite files>.
+// Output header is included by "CompiledSprites.cpp".
+//
+// Each function contains stores of constant palette indices at constant offsets, transparent pixels are just omitted.
+// Functions take pointer to top-left pixel and frame buffer stride and don't perform clipping.
+// Sprites are decoded via "SpriteBMP" and orientations are mapped via "SpriteOrientation.hpp", like in "SpriteAtlas", so pixels match.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/SpriteBMP.hpp"
+#include "../src/SpriteOrientation.hpp"
+#include "../tools_common/ToolFiles.hpp"
+
+namespace
+{
+
+// Same as "SpriteAtlas::c_transparent_color_index".
+constexpr const uint8_t c_transparent_color_index = 0;
+
+const char* const c_orientation_names[]
+{
+	"Identity",
+	"MirrorX",
+	"MirrorY",
+	"Rotate90",
+	"Rotate180",
+	"Rotate270",
+};
+
+static_assert(std::size(c_orientation_names) == size_t(SpriteOrientation::NumOrientations), "Wrong orientation names");
+
+// Sprite, decoded like in "SpriteAtlas". Negative value means transparent pixel.
+struct DecodedSprite
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	// Top-down rows.
+	std::vector<int32_t> pixels;
+};
+
+bool DecodeSprite(const std::vector<uint8_t>& file_data, DecodedSprite& out_sprite)
+{
+	const SpriteBMP bmp(file_data.data());
+	if(!bmp.IsValid(file_data.size()))
+	{
+		return false;
+	}
+
+	out_sprite.width  = bmp.GetWidth ();
+	out_sprite.height = bmp.GetHeight();
+	const uint32_t stride = bmp.GetRowStride();
+	const uint8_t* const data = bmp.GetImageData();
+	const Color32* const palette = bmp.GetPalette();
+
+	out_sprite.pixels.resize(size_t(out_sprite.width) * size_t(out_sprite.height));
+	for(uint32_t y = 0; y < out_sprite.height; ++y)
+	{
+		// BMP rows are stored bottom-up.
+		const uint8_t* const src_line = data + (out_sprite.height - 1 - y) * stride;
+		for(uint32_t x = 0; x < out_sprite.width; ++x)
+		{
+			const uint8_t color_index = src_line[x];
+			int32_t& dst = out_sprite.pixels[x + y * out_sprite.width];
+			if(color_index == c_transparent_color_index)
+			{
+				dst = -1;
+				continue;
+			}
+			if(color_index >= bmp.GetPaletteSize())
+			{
+				return false;
+			}
+
+			// Palette in BMP file isn't aligned.
+			Color32 color = 0;
+			std::memcpy(&color, palette + color_index, sizeof(Color32));
+			dst = FindCGAColorIndex(color);
+			if(dst < 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Returns number of generated stores.
+uint32_t GenerateFunction(
+	const DecodedSprite& sprite,
+	const SpriteOrientation orientation,
+	const std::string& function_name,
+	std::string& out)
+{
+	const bool is_transposed = IsTransposedOrientation(orientation);
+	const uint32_t width  = is_transposed ? sprite.height : sprite.width ;
+	const uint32_t height = is_transposed ? sprite.width  : sprite.height;
+
+	std::string body;
+	uint32_t num_stores = 0;
+	// Rows are skipped lazily, in order to not advance pointer past last non-empty row.
+	uint32_t rows_to_skip = 0;
+	bool stride_is_used = false;
+	for(uint32_t y = 0; y < height; ++y)
+	{
+		std::string row;
+		for(uint32_t x = 0; x < width; ++x)
+		{
+			const int32_t color_index = sprite.pixels[GetSourceTexelOffset(orientation, sprite.width, sprite.height, x, y)];
+			if(color_index >= 0)
+			{
+				row += "\tdst[" + std::to_string(x) + "] = " + std::to_string(color_index) + ";\n";
+				++num_stores;
+			}
+		}
+
+		if(row.empty())
+		{
+			++rows_to_skip;
+			continue;
+		}
+
+		if(rows_to_skip > 0)
+		{
+			body += rows_to_skip == 1 ? "\tdst += stride;\n" : "\tdst += stride * " + std::to_string(rows_to_skip) + ";\n";
+			stride_is_used = true;
+		}
+		body += row;
+		rows_to_skip = 1;
+	}
+
+	out += "void " + function_name + "(ColorIndex* dst, const size_t stride)\n{\n";
+	if(num_stores == 0)
+	{
+		out += "\t(void)dst;\n";
+	}
+	if(!stride_is_used)
+	{
+		out += "\t(void)stride;\n";
+	}
+	out += body;
+	out += "}\n\n";
+
+	return num_stores;
+}
+
+} // namespace
+
+int main(const int argc, const char* const* const argv)
+{
+	if(argc != 3)
+	{
+		std::fprintf(stderr, "Usage: SpriteCompiler <output header path> <file with list of sprite files>\n");
+		return 1;
+	}
+
+	std::vector<std::string> input_paths;
+	if(!ReadListFile(argv[2], input_paths))
+	{
+		std::fprintf(stderr, "Can't read \"%s\"\n", argv[2]);
+		return 1;
+	}
+
+	std::string functions;
+	std::string table;
+	uint32_t num_compiled_sprites = 0;
+	uint32_t total_stores = 0;
+	for(size_t i = 0; i < input_paths.size(); ++i)
+	{
+		const std::string& path = input_paths[i];
+		std::vector<uint8_t> content;
+		if(!ReadFile(path, content))
+		{
+			std::fprintf(stderr, "Can't read \"%s\"\n", path.c_str());
+			return 1;
+		}
+
+		DecodedSprite sprite;
+		if(!DecodeSprite(content, sprite))
+		{
+			std::fprintf(stderr, "Can't decode \"%s\"\n", path.c_str());
+			return 1;
+		}
+
+		if(sprite.width > c_max_small_sprite_size || sprite.height > c_max_small_sprite_size)
+		{
+			table += "\t{},\n";
+			continue;
+		}
+
+		table += "\t{";
+		for(uint32_t o = 0; o < uint32_t(SpriteOrientation::NumOrientations); ++o)
+		{
+			const std::string function_name = "CompiledSprite" + std::to_string(i) + c_orientation_names[o];
+			total_stores += GenerateFunction(sprite, SpriteOrientation(o), function_name, functions);
+			table += (o == 0 ? "" : ", ") + function_name;
+		}
+		table += "},\n";
+		++num_compiled_sprites;
+	}
+
+	std::string out = "// Generated by SpriteCompiler.\n";
+	out +=
+		"// " + std::to_string(num_compiled_sprites) + " of " + std::to_string(input_paths.size()) +
+		" sprites compiled, " + std::to_string(total_stores) + " stores.\n\n";
+	out += functions;
+	out += "const CompiledSpriteFunc c_compiled_sprites[][" + std::to_string(uint32_t(SpriteOrientation::NumOrientations)) + "]\n{\n" + table + "};\n";
+
+	if(!WriteFile(argv[1], out))
+	{
+		std::fprintf(stderr, "Can't write \"%s\"\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
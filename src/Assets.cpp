@@ -0,0 +1,127 @@
+#include "Assets.hpp"
+#include "Trace.hpp"
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+struct AssetsBlobEntry
+{
+	uint32_t offset;
+	uint32_t compressed_size;
+	uint32_t size;
+};
+
+// Generated by "AssetPacker" - defines "c_assets_blob_index" and "c_assets_blob".
+#include "AssetsBlob.hpp"
+
+static_assert(std::size(c_assets_blob_index) == size_t(AssetId::NumAssets), "Wrong assets list");
+
+constexpr const uint32_t c_min_match_length = 4;
+
+std::mutex g_assets_mutex;
+std::unique_ptr<uint8_t[]> g_decompressed_assets[size_t(AssetId::NumAssets)];
+// Number of "GetAssetData" calls without matching "ReleaseAssetData".
+uint32_t g_assets_use_counts[size_t(AssetId::NumAssets)]{};
+
+uint32_t ReadLength(const uint8_t*& src, uint32_t length)
+{
+	uint8_t b;
+	do
+	{
+		b = *src;
+		++src;
+		length += b;
+	} while(b == 255);
+
+	return length;
+}
+
+// Decompress stream produced by "AssetPacker".
+void Decompress(const uint8_t* src, const size_t compressed_size, uint8_t* const dst, const size_t size)
+{
+	const uint8_t* const src_end = src + compressed_size;
+	uint8_t* out = dst;
+	while(src < src_end)
+	{
+		const uint8_t token = *src;
+		++src;
+
+		uint32_t num_literals = token >> 4;
+		if(num_literals == 15)
+		{
+			num_literals = ReadLength(src, num_literals);
+		}
+
+		assert(out + num_literals <= dst + size);
+		std::memcpy(out, src, num_literals);
+		out += num_literals;
+		src += num_literals;
+
+		if(src == src_end)
+		{
+			// Last block has no match.
+			break;
+		}
+
+		const uint32_t offset = uint32_t(src[0]) | (uint32_t(src[1]) << 8);
+		src += 2;
+
+		uint32_t match_length = token & 15;
+		if(match_length == 15)
+		{
+			match_length = ReadLength(src, match_length);
+		}
+		match_length += c_min_match_length;
+
+		assert(offset > 0 && out - dst >= ptrdiff_t(offset));
+		assert(out + match_length <= dst + size);
+		// Match may overlap output, so copy bytes one by one.
+		const uint8_t* match = out - offset;
+		for(uint32_t i = 0; i < match_length; ++i)
+		{
+			out[i] = match[i];
+		}
+		out += match_length;
+	}
+
+	assert(out == dst + size);
+	(void)size;
+}
+
+} // namespace
+
+AssetData GetAssetData(const AssetId id)
+{
+	const AssetsBlobEntry& entry = c_assets_blob_index[size_t(id)];
+
+	const std::lock_guard<std::mutex> lock(g_assets_mutex);
+
+	std::unique_ptr<uint8_t[]>& decompressed = g_decompressed_assets[size_t(id)];
+	if(decompressed == nullptr)
+	{
+		TRACE_ZONE("DecompressAsset");
+		decompressed.reset(new uint8_t[entry.size]);
+		Decompress(c_assets_blob + entry.offset, entry.compressed_size, decompressed.get(), entry.size);
+	}
+	++g_assets_use_counts[size_t(id)];
+
+	return {decompressed.get(), entry.size};
+}
+
+void ReleaseAssetData(const AssetId id)
+{
+	const std::lock_guard<std::mutex> lock(g_assets_mutex);
+
+	uint32_t& use_count = g_assets_use_counts[size_t(id)];
+	assert(use_count > 0);
+	--use_count;
+	if(use_count == 0)
+	{
+		g_decompressed_assets[size_t(id)].reset();
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Identifiers of all assets packed into compressed blob at build time.
+// Lists are generated from contents of "sprites" and "music" directories.
+enum class AssetId : uint16_t
+{
+#define SPRITE(name) sprite_##name,
+#include "SpritesList.hpp"
+#undef SPRITE
+#define MUSIC(name) music_##name,
+#include "MusicList.hpp"
+#undef MUSIC
+	NumAssets
+};
+
+struct AssetData
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+};
+
+// Asset is decompressed on first access and stays in memory until all users release it.
+// Each call must be paired with "ReleaseAssetData". May be called from any thread.
+AssetData GetAssetData(AssetId id);
+
+// Finish using data, returned by "GetAssetData". Decompressed copy is freed after last user releases it,
+// next access decompresses it again.
+void ReleaseAssetData(AssetId id);
@@ -1,6 +1,7 @@
 #pragma once
 #include <array>
 #include <cstdint>
+#include <iterator>
 
 using Color32 = uint32_t;
 
@@ -24,8 +25,38 @@ inline constexpr const Color32 g_cga_palette[16]
 	0x00FFFFFF,
 };
 
-const constexpr Color32 g_color_black = g_cga_palette[0];
-const constexpr Color32 g_color_white = g_cga_palette[15];
+// Returns index of exactly the same color (alpha is ignored) in CGA palette or -1 if there is no such color.
+constexpr int32_t FindCGAColorIndex(const Color32 color)
+{
+	for(size_t i = 0; i < std::size(g_cga_palette); ++i)
+	{
+		if(g_cga_palette[i] == (color & 0x00FFFFFF))
+		{
+			return int32_t(i);
+		}
+	}
+	return -1;
+}
+
+// Frame buffers store palette indices. They are expanded into colors only during presentation.
+using ColorIndex = uint8_t;
+
+// Has entry for each possible index, so lookups need no range checks.
+using Palette = std::array<Color32, 256>;
+
+// CGA colors, other entries are black.
+constexpr Palette MakeCGAPalette()
+{
+	Palette palette{};
+	for(size_t i = 0; i < std::size(g_cga_palette); ++i)
+	{
+		palette[i] = g_cga_palette[i];
+	}
+	return palette;
+}
+
+const constexpr ColorIndex g_color_black = 0;
+const constexpr ColorIndex g_color_white = 15;
 
 using ColorComponents = std::array<uint32_t, 4>;
 
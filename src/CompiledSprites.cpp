@@ -0,0 +1,18 @@
+#include "CompiledSprites.hpp"
+#include <iterator>
+
+namespace
+{
+
+// Generated by "SpriteCompiler" - defines drawing functions and "c_compiled_sprites" table.
+#include "CompiledSpritesCode.hpp"
+
+static_assert(std::size(c_compiled_sprites) == size_t(SpriteId::NumSprites), "Wrong compiled sprites list");
+static_assert(std::size(c_compiled_sprites[0]) == size_t(SpriteOrientation::NumOrientations), "Wrong orientations list");
+
+} // namespace
+
+CompiledSpriteFunc GetCompiledSprite(const SpriteId id, const SpriteOrientation orientation)
+{
+	return c_compiled_sprites[size_t(id)][size_t(orientation)];
+}
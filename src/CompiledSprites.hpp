@@ -0,0 +1,10 @@
+#pragma once
+#include "SpriteAtlas.hpp"
+#include <cstddef>
+
+// Drawing function, generated at build time for specific sprite in specific orientation.
+// Draws sprite with top-left corner at given pixel, without clipping.
+using CompiledSpriteFunc = void(*)(ColorIndex* dst, size_t stride);
+
+// Returns null if sprite isn't compiled (if it's too large).
+CompiledSpriteFunc GetCompiledSprite(SpriteId id, SpriteOrientation orientation);
@@ -0,0 +1,442 @@
+#include "CrtEffect.hpp"
+#include "SIMD.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Row kernels process colors as arrays of bytes (little-endian, B, G, R, A) with 16-bit intermediate values.
+// Blur weights are 1 2 1 for upper and lower rows and 4 16 4 for middle row (sum is 32), so values never overflow.
+
+namespace
+{
+
+template<uint32_t scale>
+void CopyImageWithCrtEffect(
+	const ColorIndex* src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const uint32_t y_begin,
+	const uint32_t y_end,
+	const Palette& palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	const auto unpack = [&](const ColorIndex* const line, const uint32_t x) { return UnpackColor(palette[line[x]]); };
+
+	for(uint32_t y = y_begin; y < y_end; ++y)
+	{
+		const ColorIndex* const src_line = src + src_stride * y;
+		const ColorIndex* const src_line_minus = src + src_stride * (std::max(1u, y) - 1);
+		const ColorIndex* const src_line_plus  = src + src_stride * (std::min(src_height - 2, y) + 1);
+		Color32* dst_start_line = dst + y * scale * dst_stride;
+		for(uint32_t x = 0; x < src_width ; ++x)
+		{
+			const uint32_t x_minus = std::max(1u, x) - 1;
+			const uint32_t x_plus  = std::min(src_width - 2, x) + 1;
+			ColorComponents components = ColorComponentsShiftLeft(unpack(src_line, x), 4);
+			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(unpack(src_line, x_minus), 2));
+			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(unpack(src_line, x_plus ), 2));
+			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(unpack(src_line_minus, x), 1));
+			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(unpack(src_line_plus , x), 1));
+			components = ColorComponentsAdd(components, unpack(src_line_minus, x_minus));
+			components = ColorComponentsAdd(components, unpack(src_line_minus, x_plus ));
+			components = ColorComponentsAdd(components, unpack(src_line_plus , x_minus));
+			components = ColorComponentsAdd(components, unpack(src_line_plus , x_plus ));
+			components = ColorComponentsShiftRight(components, 5);
+
+			for(uint32_t dx = 0; dx < scale; ++dx)
+			{
+				const uint32_t dst_x = x * scale + dx;
+				ColorComponents components_modified = components;
+				switch(dst_x % 3)
+				{
+				case 0:
+					components_modified[3] = components_modified[3] * 3 / 4;
+					components_modified[2] = components_modified[2] * 3 / 4;
+					break;
+				case 1:
+					components_modified[3] = components_modified[3] * 3 / 4;
+					components_modified[1] = components_modified[1] * 3 / 4;
+					break;
+				case 2:
+					components_modified[2] = components_modified[2] * 3 / 4;
+					components_modified[1] = components_modified[1] * 3 / 4;
+					break;
+				}
+
+				const Color32 color_packed = PackColor(components_modified);
+				for(uint32_t dy = 0; dy < scale; ++dy)
+				{
+					dst_start_line[dst_x + dy * dst_stride] = color_packed;
+				} // for dy
+			} // for dx
+		} // for src x
+	} // for src y
+}
+
+void CopyImageWithCrtEffectReference(
+	const uint32_t scale,
+	const ColorIndex* src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const uint32_t y_begin,
+	const uint32_t y_end,
+	const Palette& palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	auto func = CopyImageWithCrtEffect<1>;
+	switch(scale)
+	{
+	case 1: func = CopyImageWithCrtEffect<1>; break;
+	case 2: func = CopyImageWithCrtEffect<2>; break;
+	case 3: func = CopyImageWithCrtEffect<3>; break;
+	case 4: func = CopyImageWithCrtEffect<4>; break;
+	case 5: func = CopyImageWithCrtEffect<5>; break;
+	case 6: func = CopyImageWithCrtEffect<6>; break;
+	default: func = CopyImageWithCrtEffect<g_max_image_scale>; break;
+	}
+
+	func(src, src_width, src_height, src_stride, y_begin, y_end, palette, dst, dst_stride);
+}
+
+// Multipliers (in quarters) for each component of destination pixel, depending on pixel x % 3.
+const uint16_t g_rgb_mask_multipliers[3][4]
+{
+	{3, 3, 4, 4},
+	{3, 4, 3, 4},
+	{4, 3, 3, 4},
+};
+
+struct RowKernels
+{
+	// Filter source row horizontally. "a" - with weights 1 2 1, "b" - with weights 1 4 1.
+	void (*filter_row)(const Color32* src, uint32_t width, uint16_t* a, uint16_t* b);
+	// Filter vertically and normalize.
+	void (*combine_rows)(const uint16_t* a_minus, const uint16_t* b, const uint16_t* a_plus, uint32_t size, uint16_t* out);
+	// Upscale row, apply RGB mask and pack components. "temp" should have size of upscaled row.
+	void (*write_row)(const uint16_t* src, uint32_t width, uint32_t scale, uint16_t* temp, Color32* dst);
+};
+
+void FilterPixel(
+	const uint8_t* const src,
+	const uint32_t x_minus,
+	const uint32_t x,
+	const uint32_t x_plus,
+	uint16_t* const a,
+	uint16_t* const b)
+{
+	for(uint32_t c = 0; c < 4; ++c)
+	{
+		const uint32_t l = src[x_minus * 4 + c], m = src[x * 4 + c], r = src[x_plus * 4 + c];
+		a[x * 4 + c] = uint16_t(l + (m << 1) + r);
+		b[x * 4 + c] = uint16_t(l + (m << 2) + r);
+	}
+}
+
+void FilterRowGeneric(const Color32* const src, const uint32_t width, uint16_t* const a, uint16_t* const b)
+{
+	const auto s = reinterpret_cast<const uint8_t*>(src);
+
+	FilterPixel(s, 0, 0, 1, a, b);
+	for(uint32_t i = 4; i < (width - 1) * 4; ++i)
+	{
+		a[i] = uint16_t(s[i - 4] + (s[i] << 1) + s[i + 4]);
+		b[i] = uint16_t(s[i - 4] + (s[i] << 2) + s[i + 4]);
+	}
+	FilterPixel(s, width - 2, width - 1, width - 1, a, b);
+}
+
+void CombineRowsGeneric(
+	const uint16_t* const a_minus,
+	const uint16_t* const b,
+	const uint16_t* const a_plus,
+	const uint32_t size,
+	uint16_t* const out)
+{
+	for(uint32_t i = 0; i < size; ++i)
+	{
+		out[i] = uint16_t((a_minus[i] + a_plus[i] + (b[i] << 2)) >> 5);
+	}
+}
+
+void WriteRowPixels(
+	const uint16_t* const src,
+	const uint32_t dst_x_start,
+	const uint32_t dst_x_end,
+	const uint32_t scale,
+	Color32* const dst)
+{
+	for(uint32_t dst_x = dst_x_start; dst_x < dst_x_end; ++dst_x)
+	{
+		const uint16_t* const components = src + dst_x / scale * 4;
+		const uint16_t* const multipliers = g_rgb_mask_multipliers[dst_x % 3];
+		const auto dst_components = reinterpret_cast<uint8_t*>(dst + dst_x);
+		for(uint32_t c = 0; c < 4; ++c)
+		{
+			dst_components[c] = uint8_t(std::min((uint32_t(components[c]) * multipliers[c]) >> 2, 255u));
+		}
+	}
+}
+
+void WriteRowGeneric(
+	const uint16_t* const src,
+	const uint32_t width,
+	const uint32_t scale,
+	uint16_t* const temp,
+	Color32* const dst)
+{
+	(void)temp;
+	WriteRowPixels(src, 0, width * scale, scale, dst);
+}
+
+const RowKernels g_row_kernels_generic{FilterRowGeneric, CombineRowsGeneric, WriteRowGeneric};
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 void FilterRowSSE2(const Color32* const src, const uint32_t width, uint16_t* const a, uint16_t* const b)
+{
+	const auto s = reinterpret_cast<const uint8_t*>(src);
+	const __m128i zero = _mm_setzero_si128();
+
+	FilterPixel(s, 0, 0, 1, a, b);
+
+	const uint32_t end = (width - 1) * 4;
+	uint32_t i = 4;
+	for(; i + 16 <= end; i += 16)
+	{
+		const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i - 4));
+		const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+		const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 4));
+
+		const __m128i lr_lo = _mm_add_epi16(_mm_unpacklo_epi8(l, zero), _mm_unpacklo_epi8(r, zero));
+		const __m128i lr_hi = _mm_add_epi16(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(r, zero));
+		const __m128i m_lo = _mm_unpacklo_epi8(m, zero);
+		const __m128i m_hi = _mm_unpackhi_epi8(m, zero);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(a + i    ), _mm_add_epi16(lr_lo, _mm_slli_epi16(m_lo, 1)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(a + i + 8), _mm_add_epi16(lr_hi, _mm_slli_epi16(m_hi, 1)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(b + i    ), _mm_add_epi16(lr_lo, _mm_slli_epi16(m_lo, 2)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(b + i + 8), _mm_add_epi16(lr_hi, _mm_slli_epi16(m_hi, 2)));
+	}
+	for(; i < end; ++i)
+	{
+		a[i] = uint16_t(s[i - 4] + (s[i] << 1) + s[i + 4]);
+		b[i] = uint16_t(s[i - 4] + (s[i] << 2) + s[i + 4]);
+	}
+
+	FilterPixel(s, width - 2, width - 1, width - 1, a, b);
+}
+
+TARGET_SSE2 void CombineRowsSSE2(
+	const uint16_t* const a_minus,
+	const uint16_t* const b,
+	const uint16_t* const a_plus,
+	const uint32_t size,
+	uint16_t* const out)
+{
+	uint32_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		const __m128i sum =
+			_mm_add_epi16(
+				_mm_add_epi16(
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(a_minus + i)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(a_plus + i))),
+				_mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), 2));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_srli_epi16(sum, 5));
+	}
+	for(; i < size; ++i)
+	{
+		out[i] = uint16_t((a_minus[i] + a_plus[i] + (b[i] << 2)) >> 5);
+	}
+}
+
+// Multipliers for pair of pixels with given x % 3.
+TARGET_SSE2 inline __m128i GetRGBMaskMultipliersSSE2(const uint32_t phase0, const uint32_t phase1)
+{
+	const uint16_t* const m0 = g_rgb_mask_multipliers[phase0];
+	const uint16_t* const m1 = g_rgb_mask_multipliers[phase1];
+	return _mm_setr_epi16(
+		short(m0[0]), short(m0[1]), short(m0[2]), short(m0[3]),
+		short(m1[0]), short(m1[1]), short(m1[2]), short(m1[3]));
+}
+
+TARGET_SSE2 inline __m128i ApplyRGBMaskSSE2(const uint16_t* const src, const __m128i multipliers)
+{
+	return _mm_srli_epi16(_mm_mullo_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), multipliers), 2);
+}
+
+TARGET_SSE2 void WriteRowSSE2(
+	const uint16_t* const src,
+	const uint32_t width,
+	const uint32_t scale,
+	uint16_t* const temp,
+	Color32* const dst)
+{
+	// Upscale row first, than process it by groups of 12 pixels - 4 full periods of RGB mask.
+	for(uint32_t x = 0; x < width; ++x)
+	{
+		uint64_t pixel = 0;
+		std::memcpy(&pixel, src + x * 4, sizeof(pixel));
+		for(uint32_t dx = 0; dx < scale; ++dx)
+		{
+			std::memcpy(temp + (x * scale + dx) * 4, &pixel, sizeof(pixel));
+		}
+	}
+
+	const __m128i m01 = GetRGBMaskMultipliersSSE2(0, 1);
+	const __m128i m20 = GetRGBMaskMultipliersSSE2(2, 0);
+	const __m128i m12 = GetRGBMaskMultipliersSSE2(1, 2);
+
+	const uint32_t dst_width = width * scale;
+	uint32_t dst_x = 0;
+	for(; dst_x + 12 <= dst_width; dst_x += 12)
+	{
+		const uint16_t* const s = temp + dst_x * 4;
+		__m128i* const d = reinterpret_cast<__m128i*>(dst + dst_x);
+		_mm_storeu_si128(d + 0, _mm_packus_epi16(ApplyRGBMaskSSE2(s +  0, m01), ApplyRGBMaskSSE2(s +  8, m20)));
+		_mm_storeu_si128(d + 1, _mm_packus_epi16(ApplyRGBMaskSSE2(s + 16, m12), ApplyRGBMaskSSE2(s + 24, m01)));
+		_mm_storeu_si128(d + 2, _mm_packus_epi16(ApplyRGBMaskSSE2(s + 32, m20), ApplyRGBMaskSSE2(s + 40, m12)));
+	}
+
+	WriteRowPixels(src, dst_x, dst_width, scale, dst);
+}
+
+const RowKernels g_row_kernels_sse2{FilterRowSSE2, CombineRowsSSE2, WriteRowSSE2};
+
+#endif // SIMD_X86
+
+const RowKernels& GetRowKernels(const ImageScalingKernel kernel)
+{
+	switch(kernel)
+	{
+#ifdef SIMD_X86
+	case ImageScalingKernel::SSE2:
+	case ImageScalingKernel::AVX2:
+		return g_row_kernels_sse2;
+#endif
+	default:
+		// Simple loops, which are vectorized by compiler.
+		return g_row_kernels_generic;
+	}
+}
+
+} // namespace
+
+void CrtEffect::Apply(
+	const ImageScalingKernel kernel,
+	const uint32_t scale,
+	const ColorIndex* const src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const uint32_t y_begin,
+	const uint32_t y_end,
+	const Palette& palette,
+	Color32* const dst,
+	const uint32_t dst_stride,
+	WorkerPool& worker_pool)
+{
+	// Allocate buffers before starting parallel work.
+	band_buffers_.resize(worker_pool.GetConcurrency());
+
+	worker_pool.ParallelForBands(
+		y_end - y_begin,
+		[&](const uint32_t band_index, const uint32_t band_y_begin, const uint32_t band_y_end)
+		{
+			TRACE_ZONE("CrtEffectBand");
+			ApplyToRows(
+				kernel,
+				scale,
+				src,
+				src_width,
+				src_height,
+				src_stride,
+				y_begin + band_y_begin,
+				y_begin + band_y_end,
+				palette,
+				dst,
+				dst_stride,
+				band_buffers_[band_index]);
+		});
+}
+
+void CrtEffect::ApplyToRows(
+	const ImageScalingKernel kernel,
+	const uint32_t scale,
+	const ColorIndex* const src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const uint32_t y_begin,
+	const uint32_t y_end,
+	const Palette& palette,
+	Color32* const dst,
+	const uint32_t dst_stride,
+	BandBuffers& buffers)
+{
+	if(kernel == ImageScalingKernel::Scalar)
+	{
+		CopyImageWithCrtEffectReference(scale, src, src_width, src_height, src_stride, y_begin, y_end, palette, dst, dst_stride);
+		return;
+	}
+
+	const RowKernels& row_kernels = GetRowKernels(kernel);
+
+	const uint32_t scale_clamped = scale >= 1 && scale <= g_max_image_scale ? scale : g_max_image_scale;
+	const uint32_t row_size = src_width * 4;
+	std::vector<uint16_t>& row_buffers = buffers.row_buffers;
+	row_buffers.resize(size_t(row_size) * (3 + 3 + 1 + scale_clamped));
+	buffers.expanded_row.resize(src_width);
+
+	uint16_t* const a_rows = row_buffers.data();
+	Color32* const expanded_row = buffers.expanded_row.data();
+	uint16_t* const b_rows = a_rows + row_size * 3;
+	uint16_t* const combined_row = b_rows + row_size * 3;
+	uint16_t* const upscaled_row = combined_row + row_size;
+
+	// Each source row is filtered horizontally only once and is reused for 3 destination rows.
+	// Rows outside of the band (one row above and one row below) are filtered too.
+	uint32_t num_filtered_rows = std::max(1u, y_begin) - 1;
+	const auto filter_next_row =
+	[&]
+	{
+		// Palette is applied to each source row only once, just before filtering, so expanded row stays in cache.
+		const ColorIndex* const src_line = src + num_filtered_rows * src_stride;
+		for(uint32_t x = 0; x < src_width; ++x)
+		{
+			expanded_row[x] = palette[src_line[x]];
+		}
+
+		const uint32_t offset = num_filtered_rows % 3 * row_size;
+		row_kernels.filter_row(expanded_row, src_width, a_rows + offset, b_rows + offset);
+		++num_filtered_rows;
+	};
+
+	for(uint32_t y = y_begin; y < y_end; ++y)
+	{
+		const uint32_t y_minus = std::max(1u, y) - 1;
+		const uint32_t y_plus  = std::min(src_height - 2, y) + 1;
+		while(num_filtered_rows <= y_plus)
+		{
+			filter_next_row();
+		}
+
+		row_kernels.combine_rows(
+			a_rows + y_minus % 3 * row_size,
+			b_rows + y % 3 * row_size,
+			a_rows + y_plus % 3 * row_size,
+			row_size,
+			combined_row);
+
+		Color32* const dst_line = dst + y * scale_clamped * dst_stride;
+		row_kernels.write_row(combined_row, src_width, scale_clamped, upscaled_row, dst_line);
+		for(uint32_t dy = 1; dy < scale_clamped; ++dy)
+		{
+			std::memcpy(dst_line + dy * dst_stride, dst_line, src_width * scale_clamped * sizeof(Color32));
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "ImageScaling.hpp"
+#include "WorkerPool.hpp"
+#include <vector>
+
+// CRT-like post-processing: blur, RGB mask and integer upscaling.
+class CrtEffect
+{
+public:
+	// Result is identical for all kernels. Scalar kernel is the reference, others process whole rows with 16-bit lanes.
+	// Scale should be in range [1; g_max_image_scale].
+	// Source image consists of palette indices and should be at least 2x2.
+	// Strides are in pixels.
+	// Only source rows [y_begin; y_end) are processed, split into horizontal bands, processed in parallel.
+	void Apply(
+		ImageScalingKernel kernel,
+		uint32_t scale,
+		const ColorIndex* src,
+		uint32_t src_width,
+		uint32_t src_height,
+		uint32_t src_stride,
+		uint32_t y_begin,
+		uint32_t y_end,
+		const Palette& palette,
+		Color32* dst,
+		uint32_t dst_stride,
+		WorkerPool& worker_pool);
+
+private:
+	struct BandBuffers
+	{
+		// Horizontally filtered source rows (ring buffer of 3 rows for each filter), vertically filtered row, upscaled row.
+		std::vector<uint16_t> row_buffers;
+		// Source row with palette applied.
+		std::vector<Color32> expanded_row;
+	};
+
+	// Process source rows [y_begin; y_end). Neighbor rows outside this range are read too.
+	void ApplyToRows(
+		ImageScalingKernel kernel,
+		uint32_t scale,
+		const ColorIndex* src,
+		uint32_t src_width,
+		uint32_t src_height,
+		uint32_t src_stride,
+		uint32_t y_begin,
+		uint32_t y_end,
+		const Palette& palette,
+		Color32* dst,
+		uint32_t dst_stride,
+		BandBuffers& buffers);
+
+private:
+	// Reused between frames in order to avoid allocations. One set of buffers for each band.
+	std::vector<BandBuffers> band_buffers_;
+};
@@ -1,6 +1,14 @@
 #include "Draw.hpp"
+#include "CompiledSprites.hpp"
+#include "LayerCache.hpp"
 #include "String.hpp"
+#include "Trace.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace
 {
@@ -27,16 +35,669 @@ namespace
 #pragma warning(pop)
 #endif
 
+int64_t DivFloor(const int64_t n, const int64_t d)
+{
+	assert(d > 0);
+	return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+int64_t DivCeil(const int64_t n, const int64_t d)
+{
+	return -DivFloor(-n, d);
+}
+
+// Narrow range [x_begin, x_end) to values of x for which 0 <= c + a * x < limit.
+void ClipLinearFunctionRange(const int64_t c, const int64_t a, const int64_t limit, int32_t& x_begin, int32_t& x_end)
+{
+	int64_t range_begin = x_begin;
+	int64_t range_end = x_end;
+	if(a > 0)
+	{
+		range_begin = std::max(range_begin, DivCeil(-c, a));
+		range_end = std::min(range_end, DivFloor(limit - 1 - c, a) + 1);
+	}
+	else if(a < 0)
+	{
+		range_begin = std::max(range_begin, DivCeil(c - (limit - 1), -a));
+		range_end = std::min(range_end, DivFloor(c, -a) + 1);
+	}
+	else if(c < 0 || c >= limit)
+	{
+		range_end = range_begin;
+	}
+
+	x_begin = int32_t(range_begin);
+	x_end = int32_t(std::max(range_begin, range_end));
+}
+
+void RasterizeText(
+	const FrameBuffer frame_buffer,
+	const ColorIndex color,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const char* text)
+{
+	uint32_t x = start_x;
+	uint32_t y = start_y;
+	while(*text != '\0')
+	{
+		if(*text == '\n')
+		{
+			++text;
+			x = start_x;
+			y += g_glyph_height;
+			continue;
+		}
+
+		const uint32_t code_point = ExtractUTF8CodePoint(text);
+
+		auto glyph = &font8x8_basic[uint32_t('?')];
+		if (code_point < 0x80)
+		{
+			glyph = &font8x8_basic[code_point];
+		}
+		else if(code_point < 0x100)
+		{
+			glyph = &font8x8_ext_latin[code_point - 0xA0];
+		}
+		else if(code_point >= 0x2500 && code_point <= 0x257F)
+		{
+			glyph = &font8x8_box[code_point - 0x2500];
+		}
+		else if(code_point >= 0x2580 && code_point <= 0x259F)
+		{
+			glyph = &font8x8_block[code_point - 0x259F];
+		}
+
+		for(uint32_t dy = 0; dy < g_glyph_height; ++dy)
+		{
+			const uint32_t dst_y = y + dy;
+			const char glyph_line_byte = (*glyph)[dy];
+
+			for(uint32_t dx = 0; dx < g_glyph_width; ++dx)
+			{
+				if((glyph_line_byte & (1 << dx)) != 0)
+				{
+					const uint32_t dst_x = x + dx;
+					frame_buffer.GetRow(dst_y)[dst_x] = color;
+				}
+			}
+		}
+
+		x+= g_glyph_width;
+	}
+}
+
+enum class TextStyle : uint8_t
+{
+	Plain,
+	LightShadow,
+	FullShadow,
+	Outline,
+};
+
+// Draw text and its shadow/outline with given colors.
+void RasterizeStyledText(
+	const FrameBuffer frame_buffer,
+	const TextStyle style,
+	const ColorIndex color,
+	const ColorIndex secondary_color,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const char* const text)
+{
+	switch(style)
+	{
+	case TextStyle::Plain:
+		break;
+	case TextStyle::LightShadow:
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y + 1, text);
+		break;
+	case TextStyle::FullShadow:
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y, text);
+		RasterizeText(frame_buffer, secondary_color, start_x, start_y + 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y + 1, text);
+		break;
+	case TextStyle::Outline:
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y, text);
+		RasterizeText(frame_buffer, secondary_color, start_x - 1, start_y, text);
+		RasterizeText(frame_buffer, secondary_color, start_x, start_y + 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x, start_y - 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y + 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x + 1, start_y - 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x - 1, start_y + 1, text);
+		RasterizeText(frame_buffer, secondary_color, start_x - 1, start_y - 1, text);
+		break;
+	}
+
+	RasterizeText(frame_buffer, color, start_x, start_y, text);
+}
+
+struct TextLayout
+{
+	// Trailing line break doesn't start new line.
+	uint32_t num_lines = 1;
+	uint32_t max_symbols_in_line = 0;
+	// Number of rows of glyphs, including empty last row.
+	uint32_t num_glyph_rows = 1;
+};
+
+TextLayout GetTextLayout(const char* const text)
+{
+	TextLayout layout;
+	uint32_t symbols_in_current_line = 0;
+	const char* t = text;
+	while(*t != '\0')
+	{
+		if(*t == '\n')
+		{
+			layout.max_symbols_in_line = std::max(layout.max_symbols_in_line, symbols_in_current_line);
+			++t;
+			++layout.num_glyph_rows;
+			if(*t != '\0')
+			{
+				++layout.num_lines;
+			}
+			symbols_in_current_line = 0;
+			continue;
+		}
+
+		++symbols_in_current_line;
+		ExtractUTF8CodePoint(t);
+	}
+	layout.max_symbols_in_line = std::max(layout.max_symbols_in_line, symbols_in_current_line);
+
+	return layout;
+}
+
+// Text of given style rasterized once into list of horizontal spans of the same color.
+struct CachedText
+{
+	// Pixel is covered by text itself or by its shadow/outline.
+	enum class Layer : uint8_t
+	{
+		Text,
+		Secondary,
+	};
+
+	// Coordinates are relative to text start minus one pixel, since outline may be at left/top of text.
+	struct Span
+	{
+		uint16_t x = 0;
+		uint16_t y = 0;
+		uint16_t length = 0;
+		Layer layer = Layer::Text;
+	};
+
+	std::string text;
+	TextStyle style = TextStyle::Plain;
+	TextLayout layout;
+	std::vector<Span> spans;
+};
+
+void RasterizeCachedText(CachedText& cached_text)
+{
+	TRACE_ZONE("RasterizeCachedText");
+
+	// Leave one pixel at each side for shadow/outline.
+	const uint32_t width = cached_text.layout.max_symbols_in_line * g_glyph_width + 2;
+	const uint32_t height = cached_text.layout.num_glyph_rows * g_glyph_height + 2;
+
+	constexpr ColorIndex c_empty_color = 0;
+	constexpr ColorIndex c_secondary_color = 1;
+	constexpr ColorIndex c_text_color = 2;
+
+	std::vector<ColorIndex> data(width * height, c_empty_color);
+	const FrameBuffer frame_buffer = MakeFrameBuffer(data.data(), width, height);
+	RasterizeStyledText(frame_buffer, cached_text.style, c_text_color, c_secondary_color, 1, 1, cached_text.text.c_str());
+
+	cached_text.spans.clear();
+	for(uint32_t y = 0; y < frame_buffer.height; ++y)
+	{
+		const ColorIndex* const line = data.data() + y * frame_buffer.width;
+		uint32_t x = 0;
+		while(x < frame_buffer.width)
+		{
+			const ColorIndex color = line[x];
+			const uint32_t span_start = x;
+			while(x < frame_buffer.width && line[x] == color)
+			{
+				++x;
+			}
+
+			if(color != c_empty_color)
+			{
+				CachedText::Span span;
+				span.x = uint16_t(span_start);
+				span.y = uint16_t(y);
+				span.length = uint16_t(x - span_start);
+				span.layer = color == c_text_color ? CachedText::Layer::Text : CachedText::Layer::Secondary;
+				cached_text.spans.push_back(span);
+			}
+		}
+	}
+}
+
+// Cache of rasterized texts, keyed by text content and style.
+// Mostly the same static strings are drawn each frame, so cache is just cleared if it grows too large.
+class TextCache
+{
+public:
+	const CachedText& Get(const TextStyle style, const char* const text)
+	{
+		const size_t text_length = std::strlen(text);
+
+		// FNV-1a.
+		uint64_t key = 14695981039346656037ull ^ uint64_t(style);
+		for(size_t i = 0; i < text_length; ++i)
+		{
+			key = (key ^ uint8_t(text[i])) * 1099511628211ull;
+		}
+
+		const auto it = texts_.find(key);
+		if(it != texts_.end() && it->second.style == style && it->second.text.compare(0, std::string::npos, text, text_length) == 0)
+		{
+			return it->second;
+		}
+
+		if(texts_.size() >= c_max_texts)
+		{
+			texts_.clear();
+		}
+
+		CachedText& cached_text = texts_[key];
+		cached_text.text.assign(text, text_length);
+		cached_text.style = style;
+		cached_text.layout = GetTextLayout(text);
+		RasterizeCachedText(cached_text);
+		return cached_text;
+	}
+
+private:
+	static constexpr size_t c_max_texts = 512;
+
+private:
+	std::unordered_map<uint64_t, CachedText> texts_;
+};
+
+const CachedText& GetCachedText(const TextStyle style, const char* const text)
+{
+	// Drawing may be performed from different threads.
+	thread_local TextCache cache;
+	return cache.Get(style, text);
+}
+
+// Part of frame buffer, which text may modify.
+ClipRect GetCachedTextBounds(
+	const FrameBuffer frame_buffer,
+	const CachedText& cached_text,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	int64_t x_begin = int32_t(start_x - 1);
+	int64_t y_begin = int32_t(start_y - 1);
+	int64_t x_end = x_begin + int64_t(cached_text.layout.max_symbols_in_line * g_glyph_width + 2);
+	int64_t y_end = y_begin + int64_t(cached_text.layout.num_glyph_rows * g_glyph_height + 2);
+
+	// Text crossing left or right border continues in neighbor row.
+	if(x_begin < 0)
+	{
+		x_begin = 0;
+		x_end = frame_buffer.width;
+		--y_begin;
+	}
+	if(x_end > int64_t(frame_buffer.width))
+	{
+		x_begin = 0;
+		x_end = frame_buffer.width;
+		++y_end;
+	}
+
+	return ClipRect
+	{
+		uint32_t(std::clamp(x_begin, int64_t(0), int64_t(frame_buffer.width ))),
+		uint32_t(std::clamp(y_begin, int64_t(0), int64_t(frame_buffer.height))),
+		uint32_t(std::clamp(x_end  , int64_t(0), int64_t(frame_buffer.width ))),
+		uint32_t(std::clamp(y_end  , int64_t(0), int64_t(frame_buffer.height))),
+	};
+}
+
+void DrawCachedText(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const CachedText& cached_text,
+	const ColorIndex color,
+	const ColorIndex secondary_color,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	const auto fill_span =
+	[&](const int64_t y, const int64_t x_begin, const int64_t x_end, const ColorIndex span_color)
+	{
+		if(y < int64_t(clip.y_begin) || y >= int64_t(clip.y_end))
+		{
+			return;
+		}
+
+		const int64_t x_begin_clipped = std::max(x_begin, int64_t(clip.x_begin));
+		const int64_t x_end_clipped = std::min(x_end, int64_t(clip.x_end));
+		if(x_begin_clipped < x_end_clipped)
+		{
+			std::fill_n(frame_buffer.GetRow(uint32_t(y)) + x_begin_clipped, x_end_clipped - x_begin_clipped, span_color);
+		}
+	};
+
+	// Use the same unsigned arithmetic as glyphs drawing, including wrapping for text starting at left border.
+	const uint32_t origin_x = start_x - 1;
+	const uint32_t origin_y = start_y - 1;
+	const int64_t stride = frame_buffer.stride;
+	for(const CachedText::Span& span : cached_text.spans)
+	{
+		const ColorIndex span_color = span.layer == CachedText::Layer::Text ? color : secondary_color;
+		const int64_t x = int32_t(origin_x + span.x);
+		const int64_t y = int32_t(origin_y + span.y);
+		if(x >= 0 && x + span.length <= int64_t(frame_buffer.width))
+		{
+			fill_span(y, x, x + span.length, span_color);
+			continue;
+		}
+
+		// Span crosses frame buffer border - split it into rows as with linear addressing of pixels.
+		const int64_t begin = y * stride + x;
+		const int64_t end = begin + span.length;
+		for(int64_t row = DivFloor(begin, stride); row * stride < end; ++row)
+		{
+			fill_span(row, std::max(begin, row * stride) - row * stride, std::min(end, row * stride + stride) - row * stride, span_color);
+		}
+	}
+}
+
+// Record text drawing or draw it immediately.
+void DrawStyledText(
+	const FrameBuffer frame_buffer,
+	const TextStyle style,
+	const ColorIndex color,
+	const ColorIndex secondary_color,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const CachedText& cached_text)
+{
+	if(frame_buffer.command_buffer != nullptr)
+	{
+		DrawCommand command;
+		command.bounds = GetCachedTextBounds(frame_buffer, cached_text, start_x, start_y);
+		command.type = DrawCommandType::Text;
+		command.color = color;
+		command.secondary_color = secondary_color;
+		command.mode = uint8_t(style);
+		command.x = start_x;
+		command.y = start_y;
+		command.payload = frame_buffer.command_buffer->AddText(cached_text.text.c_str());
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
+	}
+
+	DrawCachedText(frame_buffer, frame_buffer.GetRect(), cached_text, color, secondary_color, start_x, start_y);
+}
+
+void FillRectClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const ColorIndex color,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const uint32_t w,
+	const uint32_t h)
+{
+	const uint32_t x_begin = std::max(start_x, clip.x_begin);
+	const uint32_t x_end = std::min(start_x + w, clip.x_end);
+	const uint32_t y_begin = std::max(start_y, clip.y_begin);
+	const uint32_t y_end = std::min(start_y + h, clip.y_end);
+	if(x_begin >= x_end)
+	{
+		return;
+	}
+
+	for(uint32_t y = y_begin; y < y_end; ++y)
+	{
+		std::memset(frame_buffer.GetRow(y) + x_begin, color, x_end - x_begin);
+	}
+}
+
+void DrawSpriteRectClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const uint32_t sprite_start_x,
+	const uint32_t sprite_start_y,
+	const uint32_t sprite_rect_width,
+	const uint32_t sprite_rect_height)
+{
+	const SpriteAtlas& atlas = SpriteAtlas::GetInstance();
+	const SpriteAtlas::SpriteInfo& info = atlas.GetSpriteInfo(sprite.GetId());
+	const ColorIndex* const pixels = atlas.GetPixels(info);
+
+	const uint32_t x_begin = std::max(start_x, clip.x_begin);
+	const uint32_t x_end = std::min(start_x + sprite_rect_width, clip.x_end);
+	const uint32_t y_begin = std::max(start_y, clip.y_begin);
+	const uint32_t y_end = std::min(start_y + sprite_rect_height, clip.y_end);
+	if(x_begin >= x_end)
+	{
+		return;
+	}
+
+	for(uint32_t y = y_begin; y < y_end; ++y)
+	{
+		const auto src_line = pixels + (sprite_start_y + (y - start_y)) * info.width + sprite_start_x + (x_begin - start_x);
+		const auto dst_line = frame_buffer.GetRow(y) + x_begin;
+		std::memcpy(dst_line, src_line, (x_end - x_begin) * sizeof(ColorIndex));
+	}
+}
+
+// Part of frame buffer, which sprite with given size and texture coordinates matrix may modify.
+ClipRect GetTransformedSpriteBounds(const FrameBuffer frame_buffer, const uint32_t w, const uint32_t h, const Matrix3& tc_matrix)
+{
+	const Matrix3 tc_matrix_inverse = tc_matrix.GetInverse();
+
+	const int32_t corner_points[4][2]=
+	{
+		{0, 0}, {0, int32_t(h)}, {int32_t(w), 0}, {int32_t(w), int32_t(h)},
+	};
+
+	const fixed16_t tc_inf = 32767 * g_fixed16_one;
+	fixed16_t min_coord[2] = {  tc_inf,  tc_inf };
+	fixed16_t max_coord[2] = { -tc_inf, -tc_inf };
+
+	for(const auto& point : corner_points)
+	{
+		const int32_t x = point[0] * tc_matrix_inverse.x[0] + point[1] * tc_matrix_inverse.x[1] + tc_matrix_inverse.x[2];
+		const int32_t y = point[0] * tc_matrix_inverse.y[0] + point[1] * tc_matrix_inverse.y[1] + tc_matrix_inverse.y[2];
+		min_coord[0] = std::min(min_coord[0], x);
+		min_coord[1] = std::min(min_coord[1], y);
+		max_coord[0] = std::max(max_coord[0], x);
+		max_coord[1] = std::max(max_coord[1], y);
+	}
+
+	return ClipRect
+	{
+		std::min(uint32_t(std::max(Fixed16FloorToInt(min_coord[0]) - 1, 0)), frame_buffer.width ),
+		std::min(uint32_t(std::max(Fixed16FloorToInt(min_coord[1]) - 1, 0)), frame_buffer.height),
+		std::min(uint32_t(std::max(Fixed16FloorToInt(max_coord[0]) + 1, 0)), frame_buffer.width ),
+		std::min(uint32_t(std::max(Fixed16FloorToInt(max_coord[1]) + 1, 0)), frame_buffer.height),
+	};
+}
+
+// Used for orientations of large sprites, which aren't stored in atlas - each texel is fetched from identity orientation.
+void DrawSpriteWithAlphaNotStoredOrientationClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const SpriteHandle sprite,
+	const SpriteOrientation orientation,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	const SpriteAtlas& atlas = SpriteAtlas::GetInstance();
+	const SpriteAtlas::SpriteInfo& info = atlas.GetSpriteInfo(sprite.GetId(), orientation);
+	const SpriteAtlas::SpriteInfo& src_info = atlas.GetSpriteInfo(sprite.GetId());
+	const ColorIndex* const pixels = atlas.GetPixels(src_info);
+	const uint8_t* const alpha_mask = atlas.GetAlphaMask(src_info);
+
+	// Coordinates may be "negative".
+	const int32_t x0 = int32_t(start_x);
+	const int32_t y0 = int32_t(start_y);
+
+	const int32_t clip_x_begin = std::max(0, int32_t(clip.x_begin) - x0);
+	const int32_t clip_x_end = std::min(int32_t(info.width), int32_t(clip.x_end) - x0);
+	const int32_t clip_y_begin = std::max(0, int32_t(clip.y_begin) - y0);
+	const int32_t clip_y_end = std::min(int32_t(info.height), int32_t(clip.y_end) - y0);
+
+	for(int32_t y = clip_y_begin; y < clip_y_end; ++y)
+	{
+		ColorIndex* const dst_line = frame_buffer.GetRow(uint32_t(y0 + y));
+		for(int32_t x = clip_x_begin; x < clip_x_end; ++x)
+		{
+			const uint32_t texel_offset =
+				GetSourceTexelOffset(orientation, src_info.width, src_info.height, uint32_t(x), uint32_t(y));
+			if(alpha_mask[texel_offset] != 0)
+			{
+				dst_line[x0 + x] = pixels[texel_offset];
+			}
+		}
+	}
+}
+
+void DrawSpriteWithAlphaSpansClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const SpriteHandle sprite,
+	const SpriteOrientation orientation,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	const SpriteAtlas& atlas = SpriteAtlas::GetInstance();
+	const SpriteAtlas::SpriteInfo& info = atlas.GetSpriteInfo(sprite.GetId(), orientation);
+	if(!info.is_stored)
+	{
+		DrawSpriteWithAlphaNotStoredOrientationClipped(frame_buffer, clip, sprite, orientation, start_x, start_y);
+		return;
+	}
+
+	const ColorIndex* const pixels = atlas.GetPixels(info);
+
+	// Coordinates may be "negative".
+	const int32_t x0 = int32_t(start_x);
+	const int32_t y0 = int32_t(start_y);
+
+	const int32_t clip_x_begin = std::max(0, int32_t(clip.x_begin) - x0);
+	const int32_t clip_x_end = std::min(int32_t(info.width), int32_t(clip.x_end) - x0);
+	const int32_t clip_y_begin = std::max(0, int32_t(clip.y_begin) - y0);
+	const int32_t clip_y_end = std::min(int32_t(info.height), int32_t(clip.y_end) - y0);
+
+	for(int32_t y = clip_y_begin; y < clip_y_end; ++y)
+	{
+		const ColorIndex* const src_line = pixels + uint32_t(y) * info.width;
+		ColorIndex* const dst_line = frame_buffer.GetRow(uint32_t(y0 + y));
+		for(const SpriteAtlas::OpaqueSpan& span : atlas.GetRowSpans(info, uint32_t(y)))
+		{
+			const int32_t x_begin = std::max(int32_t(span.start), clip_x_begin);
+			const int32_t x_end = std::min(int32_t(span.start + span.length), clip_x_end);
+			if(x_begin < x_end)
+			{
+				std::memcpy(dst_line + (x0 + x_begin), src_line + x_begin, uint32_t(x_end - x_begin) * sizeof(ColorIndex));
+			}
+		}
+	}
+}
+
+void DrawSpriteWithAlphaClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const SpriteHandle sprite,
+	const SpriteOrientation orientation,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	// Compiled sprites have no clipping, so they are used only for sprites entirely inside clip rect.
+	const CompiledSpriteFunc compiled_sprite = GetCompiledSprite(sprite.GetId(), orientation);
+	if(compiled_sprite != nullptr && start_x >= clip.x_begin && start_y >= clip.y_begin)
+	{
+		const SpriteAtlas::SpriteInfo& info = SpriteAtlas::GetInstance().GetSpriteInfo(sprite.GetId(), orientation);
+		// Coordinates may be "negative", so avoid overflow.
+		if(uint64_t(start_x) + info.width <= clip.x_end && uint64_t(start_y) + info.height <= clip.y_end)
+		{
+			compiled_sprite(frame_buffer.GetRow(start_y) + start_x, frame_buffer.stride);
+			return;
+		}
+	}
+
+	DrawSpriteWithAlphaSpansClipped(frame_buffer, clip, sprite, orientation, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaTransformedClipped(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const SpriteHandle sprite,
+	const Matrix3& tc_matrix)
+{
+	const SpriteAtlas& atlas = SpriteAtlas::GetInstance();
+	const SpriteAtlas::SpriteInfo& info = atlas.GetSpriteInfo(sprite.GetId());
+	const ColorIndex* const pixels = atlas.GetPixels(info);
+	const uint8_t* const alpha_mask = atlas.GetAlphaMask(info);
+	const uint32_t w = info.width;
+	const uint32_t h = info.height;
+
+	const ClipRect bounds = GetTransformedSpriteBounds(frame_buffer, w, h, tc_matrix);
+	const uint32_t start_x = std::max(bounds.x_begin, clip.x_begin);
+	const uint32_t end_x   = std::min(bounds.x_end  , clip.x_end  );
+	const uint32_t start_y = std::max(bounds.y_begin, clip.y_begin);
+	const uint32_t end_y   = std::min(bounds.y_end  , clip.y_end  );
+	if(start_x >= end_x)
+	{
+		return;
+	}
+
+	const int32_t w_fixed = IntToFixed16(int32_t(w));
+	const int32_t h_fixed = IntToFixed16(int32_t(h));
+	for(uint32_t y = start_y; y < end_y; ++y)
+	{
+		// Texture coordinates are linear along row, so find exact range where they are inside sprite
+		// and step them with constant increments.
+		const int32_t tc_x_row = int32_t(y) * tc_matrix.x[1] + tc_matrix.x[2];
+		const int32_t tc_y_row = int32_t(y) * tc_matrix.y[1] + tc_matrix.y[2];
+		int32_t x_begin = int32_t(start_x);
+		int32_t x_end = int32_t(end_x);
+		ClipLinearFunctionRange(tc_x_row, tc_matrix.x[0], w_fixed, x_begin, x_end);
+		ClipLinearFunctionRange(tc_y_row, tc_matrix.y[0], h_fixed, x_begin, x_end);
+		if(x_begin >= x_end)
+		{
+			continue;
+		}
+
+		const auto dst_line = frame_buffer.GetRow(y);
+		fixed16_t tc_x = tc_x_row + x_begin * tc_matrix.x[0];
+		fixed16_t tc_y = tc_y_row + x_begin * tc_matrix.y[0];
+		for(int32_t x = x_begin; x < x_end; ++x, tc_x += tc_matrix.x[0], tc_y += tc_matrix.y[0])
+		{
+			const uint32_t texel_offset = uint32_t(Fixed16FloorToInt(tc_x)) + uint32_t(Fixed16FloorToInt(tc_y)) * w;
+			// Select without branches using 0xFF/0x00 mask.
+			const uint32_t mask = alpha_mask[texel_offset];
+			dst_line[x] = ColorIndex((pixels[texel_offset] & mask) | (dst_line[x] & ~mask));
+		}
+	}
+}
+
 } // namespace
 
-void FillWholeFrameBuffer(const FrameBuffer frame_buffer, const Color32 color)
+void FillWholeFrameBuffer(const FrameBuffer frame_buffer, const ColorIndex color)
 {
 	FillRect(frame_buffer, color, 0, 0, frame_buffer.width, frame_buffer.height);
 }
 
 void FillRect(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
+	const ColorIndex color,
 	const uint32_t start_x,
 	const uint32_t start_y,
 	const uint32_t w,
@@ -45,14 +706,17 @@ void FillRect(
 	assert(start_x + w <= frame_buffer.width);
 	assert(start_y + h <= frame_buffer.height);
 
-	for(uint32_t y = 0; y < h; ++y)
+	if(frame_buffer.command_buffer != nullptr)
 	{
-		const auto dst_line = frame_buffer.data + (y + start_y) * frame_buffer.width;
-		for(uint32_t x = 0; x < w; ++x)
-		{
-			dst_line[start_x + x] = color;
-		}
+		DrawCommand command;
+		command.bounds = {start_x, start_y, start_x + w, start_y + h};
+		command.type = DrawCommandType::FillRect;
+		command.color = color;
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
 	}
+
+	FillRectClipped(frame_buffer, frame_buffer.GetRect(), color, start_x, start_y, w, h);
 }
 
 void DrawSprite(
@@ -64,8 +728,8 @@ void DrawSprite(
 	const auto w = sprite.GetWidth();
 	const auto h = sprite.GetHeight();
 	const auto stride = sprite.GetRowStride();
-	const auto palette = sprite.GetPalette();
 	const auto data = sprite.GetImageData();
+	assert(frame_buffer.command_buffer == nullptr);
 
 	assert(start_x + w <= frame_buffer.width);
 	assert(start_y + h <= frame_buffer.height);
@@ -73,11 +737,11 @@ void DrawSprite(
 	for(uint32_t y = 0; y < h; ++y)
 	{
 		const auto src_line = data + (h - 1 - y) * stride;
-		const auto dst_line = frame_buffer.data + (y + start_y) * frame_buffer.width;
+		const auto dst_line = frame_buffer.GetRow(y + start_y);
 		for(uint32_t x = 0; x < w; ++x)
 		{
 			const auto color_index = src_line[x];
-			dst_line[start_x + x] = palette[color_index];
+			dst_line[start_x + x] = color_index;
 		}
 	}
 }
@@ -94,8 +758,8 @@ void DrawSpriteRect(
 {
 	const auto h = sprite.GetHeight();
 	const auto stride = sprite.GetRowStride();
-	const auto palette = sprite.GetPalette();
 	const auto data = sprite.GetImageData();
+	assert(frame_buffer.command_buffer == nullptr);
 
 	assert(start_x + sprite_rect_width  <= frame_buffer.width );
 	assert(start_y + sprite_rect_height <= frame_buffer.height);
@@ -106,11 +770,11 @@ void DrawSpriteRect(
 	for(uint32_t y = 0; y < sprite_rect_height; ++y)
 	{
 		const auto src_line = data + (h - 1 - (sprite_start_y + y)) * stride;
-		const auto dst_line = frame_buffer.data + (y + start_y) * frame_buffer.width;
+		const auto dst_line = frame_buffer.GetRow(y + start_y);
 		for(uint32_t x = 0; x < sprite_rect_width ; ++x)
 		{
 			const auto color_index = src_line[sprite_start_x + x];
-			dst_line[start_x + x] = palette[color_index];
+			dst_line[start_x + x] = color_index;
 		}
 	}
 }
@@ -125,8 +789,8 @@ void DrawSpriteWithAlpha(
 	const auto w = sprite.GetWidth();
 	const auto h = sprite.GetHeight();
 	const auto stride = sprite.GetRowStride();
-	const auto palette = sprite.GetPalette();
 	const auto data = sprite.GetImageData();
+	assert(frame_buffer.command_buffer == nullptr);
 
 	assert(start_x + w <= frame_buffer.width);
 	assert(start_y + h <= frame_buffer.height);
@@ -134,13 +798,13 @@ void DrawSpriteWithAlpha(
 	for(uint32_t y = 0; y < h; ++y)
 	{
 		const auto src_line = data + (h - 1 - y) * stride;
-		const auto dst_line = frame_buffer.data + (y + start_y) * frame_buffer.width;
+		const auto dst_line = frame_buffer.GetRow(y + start_y);
 		for(uint32_t x = 0; x < w; ++x)
 		{
 			const auto color_index = src_line[x];
 			if(color_index != transparent_color_index)
 			{
-				dst_line[start_x + x] = palette[color_index];
+				dst_line[start_x + x] = color_index;
 			}
 		}
 	}
@@ -155,8 +819,8 @@ void DrawSpriteWithAlphaTransformed(
 	const auto w = sprite.GetWidth();
 	const auto h = sprite.GetHeight();
 	const auto stride = sprite.GetRowStride();
-	const auto palette = sprite.GetPalette();
 	const auto data = sprite.GetImageData();
+	assert(frame_buffer.command_buffer == nullptr);
 
 	const Matrix3 tc_matrix_inverse = tc_matrix.GetInverse();
 
@@ -186,7 +850,7 @@ void DrawSpriteWithAlphaTransformed(
 
 	for(uint32_t y = start_y; y < end_y; ++y)
 	{
-		const auto dst_line = frame_buffer.data + y * frame_buffer.width;
+		const auto dst_line = frame_buffer.GetRow(y);
 		for(uint32_t x = start_x; x < end_x; ++x)
 		{
 			const int32_t tc_x = Fixed16FloorToInt(int32_t(x) * tc_matrix.x[0] + int32_t(y) * tc_matrix.x[1] + tc_matrix.x[2]);
@@ -196,7 +860,7 @@ void DrawSpriteWithAlphaTransformed(
 				const auto color_index = data[uint32_t(tc_x) + uint32_t(tc_y) * stride];
 				if(color_index != transparent_color_index)
 				{
-					dst_line[x] = palette[color_index];
+					dst_line[x] = color_index;
 				}
 			}
 		}
@@ -281,160 +945,320 @@ void DrawSpriteWithAlphaRotate270(
 	DrawSpriteWithAlphaTransformed(frame_buffer, sprite, transparent_color_index, matrix);
 }
 
-void DrawText(
+void DrawSprite(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteRect(frame_buffer, sprite, start_x, start_y, 0, 0, sprite.GetWidth(), sprite.GetHeight());
+}
+
+void DrawSpriteRect(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
 	const uint32_t start_x,
 	const uint32_t start_y,
-	const char* text)
+	const uint32_t sprite_start_x,
+	const uint32_t sprite_start_y,
+	const uint32_t sprite_rect_width,
+	const uint32_t sprite_rect_height)
 {
-	uint32_t x = start_x;
-	uint32_t y = start_y;
-	while(*text != '\0')
+	assert(start_x + sprite_rect_width  <= frame_buffer.width );
+	assert(start_y + sprite_rect_height <= frame_buffer.height);
+
+	assert(sprite_start_x + sprite_rect_width  <= sprite.GetWidth ());
+	assert(sprite_start_y + sprite_rect_height <= sprite.GetHeight());
+
+	if(frame_buffer.command_buffer != nullptr)
 	{
-		if(*text == '\n')
-		{
-			++text;
-			x = start_x;
-			y += g_glyph_height;
-			continue;
-		}
+		DrawCommand command;
+		command.bounds = {start_x, start_y, start_x + sprite_rect_width, start_y + sprite_rect_height};
+		command.type = DrawCommandType::SpriteRect;
+		command.sprite = sprite.GetId();
+		command.sprite_start_x = uint16_t(sprite_start_x);
+		command.sprite_start_y = uint16_t(sprite_start_y);
+		command.x = start_x;
+		command.y = start_y;
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
+	}
 
-		const uint32_t code_point = ExtractUTF8CodePoint(text);
+	DrawSpriteRectClipped(
+		frame_buffer,
+		frame_buffer.GetRect(),
+		sprite,
+		start_x,
+		start_y,
+		sprite_start_x,
+		sprite_start_y,
+		sprite_rect_width,
+		sprite_rect_height);
+}
 
-		auto glyph = &font8x8_basic[uint32_t('?')];
-		if (code_point < 0x80)
-		{
-			glyph = &font8x8_basic[code_point];
-		}
-		else if(code_point < 0x100)
-		{
-			glyph = &font8x8_ext_latin[code_point - 0xA0];
-		}
-		else if(code_point >= 0x2500 && code_point <= 0x257F)
-		{
-			glyph = &font8x8_box[code_point - 0x2500];
-		}
-		else if(code_point >= 0x2580 && code_point <= 0x259F)
-		{
-			glyph = &font8x8_block[code_point - 0x259F];
-		}
+void DrawSpriteWithAlpha(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	assert(start_x + sprite.GetWidth () <= frame_buffer.width);
+	assert(start_y + sprite.GetHeight() <= frame_buffer.height);
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::Identity, start_x, start_y);
+}
 
-		for(uint32_t dy = 0; dy < g_glyph_height; ++dy)
+void DrawSpriteWithAlpha(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const SpriteOrientation orientation,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	if(frame_buffer.command_buffer != nullptr)
+	{
+		const SpriteAtlas::SpriteInfo& info = SpriteAtlas::GetInstance().GetSpriteInfo(sprite.GetId(), orientation);
+
+		// Coordinates may be "negative".
+		const int64_t x0 = int32_t(start_x);
+		const int64_t y0 = int32_t(start_y);
+
+		DrawCommand command;
+		command.bounds =
 		{
-			const uint32_t dst_y = y + dy;
-			const char glyph_line_byte = (*glyph)[dy];
+			uint32_t(std::clamp(x0, int64_t(0), int64_t(frame_buffer.width ))),
+			uint32_t(std::clamp(y0, int64_t(0), int64_t(frame_buffer.height))),
+			uint32_t(std::clamp(x0 + info.width , int64_t(0), int64_t(frame_buffer.width ))),
+			uint32_t(std::clamp(y0 + info.height, int64_t(0), int64_t(frame_buffer.height))),
+		};
+		command.type = DrawCommandType::SpriteWithAlpha;
+		command.mode = uint8_t(orientation);
+		command.sprite = sprite.GetId();
+		command.x = start_x;
+		command.y = start_y;
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
+	}
 
-			for(uint32_t dx = 0; dx < g_glyph_width; ++dx)
-			{
-				if((glyph_line_byte & (1 << dx)) != 0)
-				{
-					const uint32_t dst_x = x + dx;
-					frame_buffer.data[ dst_x + dst_y * frame_buffer.width ] = color;
-				}
-			}
-		}
+	DrawSpriteWithAlphaClipped(frame_buffer, frame_buffer.GetRect(), sprite, orientation, start_x, start_y);
+}
 
-		x+= g_glyph_width;
+void DrawSpriteWithAlphaSpans(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const SpriteOrientation orientation,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	assert(frame_buffer.command_buffer == nullptr);
+	DrawSpriteWithAlphaSpansClipped(frame_buffer, frame_buffer.GetRect(), sprite, orientation, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaTransformed(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const Matrix3& tc_matrix)
+{
+	if(frame_buffer.command_buffer != nullptr)
+	{
+		DrawCommand command;
+		command.bounds = GetTransformedSpriteBounds(frame_buffer, sprite.GetWidth(), sprite.GetHeight(), tc_matrix);
+		command.type = DrawCommandType::SpriteWithAlphaTransformed;
+		command.sprite = sprite.GetId();
+		command.payload = frame_buffer.command_buffer->AddMatrix(tc_matrix);
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
 	}
+
+	DrawSpriteWithAlphaTransformedClipped(frame_buffer, frame_buffer.GetRect(), sprite, tc_matrix);
+}
+
+void DrawSpriteWithAlphaIdentityTransform(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::Identity, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaMirrorX(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::MirrorX, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaMirrorY(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::MirrorY, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaRotate90(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::Rotate90, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaRotate180(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::Rotate180, start_x, start_y);
+}
+
+void DrawSpriteWithAlphaRotate270(
+	const FrameBuffer frame_buffer,
+	const SpriteHandle sprite,
+	const uint32_t start_x,
+	const uint32_t start_y)
+{
+	DrawSpriteWithAlpha(frame_buffer, sprite, SpriteOrientation::Rotate270, start_x, start_y);
+}
+
+void DrawText(
+	const FrameBuffer frame_buffer,
+	const ColorIndex color,
+	const uint32_t start_x,
+	const uint32_t start_y,
+	const char* const text)
+{
+	DrawStyledText(frame_buffer, TextStyle::Plain, color, 0, start_x, start_y, GetCachedText(TextStyle::Plain, text));
 }
 
 void DrawTextWithLightShadow(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
-	const Color32 shadow_color,
+	const ColorIndex color,
+	const ColorIndex shadow_color,
 	const uint32_t start_x,
 	const uint32_t start_y,
 	const char* const text)
 {
-	DrawText(frame_buffer, shadow_color, start_x + 1, start_y + 1, text);
-	DrawText(frame_buffer, color, start_x, start_y, text);
+	DrawStyledText(frame_buffer, TextStyle::LightShadow, color, shadow_color, start_x, start_y, GetCachedText(TextStyle::LightShadow, text));
 }
 
 void DrawTextWithFullShadow(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
-	const Color32 shadow_color,
+	const ColorIndex color,
+	const ColorIndex shadow_color,
 	const uint32_t start_x,
 	const uint32_t start_y,
 	const char* const text)
 {
-	DrawText(frame_buffer, shadow_color, start_x + 1, start_y, text);
-	DrawText(frame_buffer, shadow_color, start_x, start_y + 1, text);
-	DrawText(frame_buffer, shadow_color, start_x + 1, start_y + 1, text);
-	DrawText(frame_buffer, color, start_x, start_y, text);
+	DrawStyledText(frame_buffer, TextStyle::FullShadow, color, shadow_color, start_x, start_y, GetCachedText(TextStyle::FullShadow, text));
 }
 
 void DrawTextWithOutline(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
-	const Color32 outline_color,
+	const ColorIndex color,
+	const ColorIndex outline_color,
 	const uint32_t start_x,
 	const uint32_t start_y,
 	const char* const text)
 {
-	DrawText(frame_buffer, outline_color, start_x + 1, start_y, text);
-	DrawText(frame_buffer, outline_color, start_x - 1, start_y, text);
-	DrawText(frame_buffer, outline_color, start_x, start_y + 1, text);
-	DrawText(frame_buffer, outline_color, start_x, start_y - 1, text);
-	DrawText(frame_buffer, outline_color, start_x + 1, start_y + 1, text);
-	DrawText(frame_buffer, outline_color, start_x + 1, start_y - 1, text);
-	DrawText(frame_buffer, outline_color, start_x - 1, start_y + 1, text);
-	DrawText(frame_buffer, outline_color, start_x - 1, start_y - 1, text);
-	DrawText(frame_buffer, color, start_x, start_y, text);
+	DrawStyledText(frame_buffer, TextStyle::Outline, color, outline_color, start_x, start_y, GetCachedText(TextStyle::Outline, text));
 }
 
 void DrawTextCentered(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
+	const ColorIndex color,
 	const uint32_t center_x,
 	const uint32_t center_y,
 	const char* const text)
 {
-	uint32_t num_lines = 1;
-	uint32_t max_symbols_in_line = 0;
-	uint32_t symbols_in_current_line = 0;
-	const char* t = text;
-	while(*t != '\0')
-	{
-		if(*t == '\n')
-		{
-			max_symbols_in_line = std::max(max_symbols_in_line, symbols_in_current_line);
-			++t;
-			if(*t != '\0')
-			{
-				++num_lines;
-			}
-			symbols_in_current_line = 0;
-			continue;
-		}
-
-		++symbols_in_current_line;
-		ExtractUTF8CodePoint(t);
-	}
-	max_symbols_in_line = std::max(max_symbols_in_line, symbols_in_current_line);
-
-	DrawText(
+	const CachedText& cached_text = GetCachedText(TextStyle::Plain, text);
+	DrawStyledText(
 		frame_buffer,
+		TextStyle::Plain,
 		color,
-		center_x - max_symbols_in_line * g_glyph_width / 2,
-		center_y - num_lines * g_glyph_height / 2,
-		text);
+		0,
+		center_x - cached_text.layout.max_symbols_in_line * g_glyph_width / 2,
+		center_y - cached_text.layout.num_lines * g_glyph_height / 2,
+		cached_text);
 }
 
 void DrawTextCenteredWithOutline(
 	const FrameBuffer frame_buffer,
-	const Color32 color,
-	const Color32 outline_color,
+	const ColorIndex color,
+	const ColorIndex outline_color,
 	const uint32_t center_x,
 	const uint32_t center_y,
 	const char* const text)
 {
-	for(uint32_t dx = 0; dx < 3; ++dx)
-	for(uint32_t dy = 0; dy < 3; ++dy)
+	// Outline drawn with 3x3 offsets is the same as regular outline.
+	const CachedText& cached_text = GetCachedText(TextStyle::Outline, text);
+	DrawStyledText(
+		frame_buffer,
+		TextStyle::Outline,
+		color,
+		outline_color,
+		center_x - cached_text.layout.max_symbols_in_line * g_glyph_width / 2,
+		center_y - cached_text.layout.num_lines * g_glyph_height / 2,
+		cached_text);
+}
+
+void RasterizeDrawCommand(
+	const FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const DrawCommand& command,
+	const DrawCommandBuffer& command_buffer)
+{
+	switch(command.type)
 	{
-		DrawTextCentered(frame_buffer, outline_color, center_x + dx - 1, center_y + dy - 1, text);
+	case DrawCommandType::FillRect:
+		FillRectClipped(
+			frame_buffer,
+			clip,
+			command.color,
+			command.bounds.x_begin,
+			command.bounds.y_begin,
+			command.bounds.x_end - command.bounds.x_begin,
+			command.bounds.y_end - command.bounds.y_begin);
+		break;
+	case DrawCommandType::SpriteRect:
+		DrawSpriteRectClipped(
+			frame_buffer,
+			clip,
+			command.sprite,
+			command.x,
+			command.y,
+			command.sprite_start_x,
+			command.sprite_start_y,
+			command.bounds.x_end - command.bounds.x_begin,
+			command.bounds.y_end - command.bounds.y_begin);
+		break;
+	case DrawCommandType::SpriteWithAlpha:
+		DrawSpriteWithAlphaClipped(frame_buffer, clip, command.sprite, SpriteOrientation(command.mode), command.x, command.y);
+		break;
+	case DrawCommandType::SpriteWithAlphaTransformed:
+		DrawSpriteWithAlphaTransformedClipped(frame_buffer, clip, command.sprite, command_buffer.GetMatrix(command.payload));
+		break;
+	case DrawCommandType::Text:
+		{
+			// Each thread has its own cache, so text is rasterized again if it isn't cached by this thread.
+			const TextStyle style = TextStyle(command.mode);
+			DrawCachedText(
+				frame_buffer,
+				clip,
+				GetCachedText(style, command_buffer.GetText(command.payload)),
+				command.color,
+				command.secondary_color,
+				command.x,
+				command.y);
+		}
+		break;
+	case DrawCommandType::Layer:
+		command_buffer.GetLayer(command.payload).CopyTo(frame_buffer, clip);
+		break;
 	}
-
-	DrawTextCentered(frame_buffer, color, center_x, center_y, text);
 }
@@ -1,18 +1,23 @@
 #pragma once
+#include "DrawCommandBuffer.hpp"
 #include "FrameBuffer.hpp"
 #include "Matrix.hpp"
+#include "SpriteAtlas.hpp"
 #include "SpriteBMP.hpp"
 
-void FillWholeFrameBuffer(FrameBuffer frame_buffer, Color32 color);
+void FillWholeFrameBuffer(FrameBuffer frame_buffer, ColorIndex color);
 
 void FillRect(
 	FrameBuffer frame_buffer,
-	Color32 color,
+	ColorIndex color,
 	uint32_t start_x,
 	uint32_t start_y,
 	uint32_t w,
 	uint32_t h);
 
+// BMP sprite palettes consist of CGA colors in CGA order, so pixel values are written as palette indices.
+// Drawing of BMP sprites can't be recorded into command buffer.
+
 // Draw whole sprite without borders check.
 void DrawSprite(
 	FrameBuffer frame_buffer,
@@ -86,51 +91,147 @@ void DrawSpriteWithAlphaRotate270(
 	uint32_t start_x,
 	uint32_t start_y);
 
+// Versions of sprite functions above for sprites from atlas.
+// Alpha versions reject texels with transparent color according to atlas alpha mask.
+// These functions and functions below are recorded if frame buffer has command buffer.
+
+void DrawSprite(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteRect(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y,
+	uint32_t sprite_start_x,
+	uint32_t sprite_start_y,
+	uint32_t sprite_rect_width,
+	uint32_t sprite_rect_height);
+
+void DrawSpriteWithAlpha(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+// Draw pre-transformed sprite variant. Result is clipped against frame buffer, like for transformed drawing.
+void DrawSpriteWithAlpha(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	SpriteOrientation orientation,
+	uint32_t start_x,
+	uint32_t start_y);
+
+// Generic blitter of opaque spans, which is used for sprites without compiled drawing function.
+// Exposed for comparison with compiled sprites. Can't be recorded.
+void DrawSpriteWithAlphaSpans(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	SpriteOrientation orientation,
+	uint32_t start_x,
+	uint32_t start_y);
+
+// Texture coordinates are top-down, unlike BMP version.
+void DrawSpriteWithAlphaTransformed(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	const Matrix3& tc_matrix);
+
+// Common signature of functions below, used to select one of them at runtime.
+using SpriteWithAlphaDrawFunc = void(*)(FrameBuffer frame_buffer, SpriteHandle sprite, uint32_t start_x, uint32_t start_y);
+
+void DrawSpriteWithAlphaIdentityTransform(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteWithAlphaMirrorX(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteWithAlphaMirrorY(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteWithAlphaRotate90(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteWithAlphaRotate180(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
+void DrawSpriteWithAlphaRotate270(
+	FrameBuffer frame_buffer,
+	SpriteHandle sprite,
+	uint32_t start_x,
+	uint32_t start_y);
+
 constexpr const uint32_t g_glyph_width  = 8;
 constexpr const uint32_t g_glyph_height = 8;
 
 void DrawText(
 	FrameBuffer frame_buffer,
-	Color32 color,
+	ColorIndex color,
 	uint32_t start_x,
 	uint32_t start_y,
 	const char* text);
 
 void DrawTextWithLightShadow(
 	FrameBuffer frame_buffer,
-	Color32 color,
-	Color32 shadow_color,
+	ColorIndex color,
+	ColorIndex shadow_color,
 	uint32_t start_x,
 	uint32_t start_y,
 	const char* text);
 
 void DrawTextWithFullShadow(
 	FrameBuffer frame_buffer,
-	Color32 color,
-	Color32 shadow_color,
+	ColorIndex color,
+	ColorIndex shadow_color,
 	uint32_t start_x,
 	uint32_t start_y,
 	const char* text);
 
 void DrawTextWithOutline(
 	FrameBuffer frame_buffer,
-	Color32 color,
-	Color32 outline_color,
+	ColorIndex color,
+	ColorIndex outline_color,
 	uint32_t start_x,
 	uint32_t start_y,
 	const char* text);
 
 void DrawTextCentered(
 	FrameBuffer frame_buffer,
-	Color32 color,
+	ColorIndex color,
 	uint32_t center_x,
 	uint32_t center_y,
 	const char* text);
 
 void DrawTextCenteredWithOutline(
 	FrameBuffer frame_buffer,
-	Color32 color,
-	Color32 outline_color,
+	ColorIndex color,
+	ColorIndex outline_color,
 	uint32_t center_x,
 	uint32_t center_y,
 	const char* text);
+
+// Execute recorded command, modifying only pixels inside clip rect.
+// Result inside clip rect is the same as of immediate drawing.
+void RasterizeDrawCommand(
+	FrameBuffer frame_buffer,
+	const ClipRect& clip,
+	const DrawCommand& command,
+	const DrawCommandBuffer& command_buffer);
@@ -0,0 +1,104 @@
+#include "DrawCommandBuffer.hpp"
+#include "Draw.hpp"
+#include "Trace.hpp"
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <cstring>
+
+FrameBuffer DrawCommandBuffer::BeginRecording(const FrameBuffer frame_buffer)
+{
+	frame_buffer_ = frame_buffer;
+	frame_buffer_.command_buffer = nullptr;
+
+	commands_.clear();
+	matrices_.clear();
+	texts_.clear();
+	layers_.clear();
+
+	FrameBuffer recording_frame_buffer = frame_buffer;
+	recording_frame_buffer.command_buffer = this;
+	return recording_frame_buffer;
+}
+
+void DrawCommandBuffer::Execute(WorkerPool& worker_pool)
+{
+	TRACE_ZONE("DrawCommandBuffer::Execute");
+
+	const uint32_t num_tiles_x = (frame_buffer_.width  + (c_tile_width  - 1)) / c_tile_width;
+	const uint32_t num_tiles_y = (frame_buffer_.height + (c_tile_height - 1)) / c_tile_height;
+	const uint32_t num_tiles = num_tiles_x * num_tiles_y;
+
+	tiles_commands_.resize(num_tiles);
+	for(std::vector<uint32_t>& tile_commands : tiles_commands_)
+	{
+		tile_commands.clear();
+	}
+
+	{
+		TRACE_ZONE("DrawCommandBuffer::Bin");
+
+		// Commands are added in recording order, so lists of tiles stay sorted by layer.
+		for(uint32_t i = 0; i < uint32_t(commands_.size()); ++i)
+		{
+			const ClipRect& bounds = commands_[i].bounds;
+			const uint32_t x_end = std::min(bounds.x_end, frame_buffer_.width);
+			const uint32_t y_end = std::min(bounds.y_end, frame_buffer_.height);
+			if(bounds.x_begin >= x_end || bounds.y_begin >= y_end)
+			{
+				continue;
+			}
+
+			for(uint32_t tile_y = bounds.y_begin / c_tile_height; tile_y <= (y_end - 1) / c_tile_height; ++tile_y)
+			{
+				for(uint32_t tile_x = bounds.x_begin / c_tile_width; tile_x <= (x_end - 1) / c_tile_width; ++tile_x)
+				{
+					tiles_commands_[tile_x + tile_y * num_tiles_x].push_back(i);
+				}
+			}
+		}
+	}
+
+	worker_pool.ParallelForBands(
+		num_tiles,
+		[&](const uint32_t band_index, const uint32_t tile_begin, const uint32_t tile_end)
+		{
+			(void)band_index;
+			TRACE_ZONE("DrawCommandBuffer::RasterizeTiles");
+			for(uint32_t tile_index = tile_begin; tile_index < tile_end; ++tile_index)
+			{
+				const uint32_t tile_x = tile_index % num_tiles_x * c_tile_width;
+				const uint32_t tile_y = tile_index / num_tiles_x * c_tile_height;
+				const ClipRect clip
+				{
+					tile_x,
+					tile_y,
+					std::min(tile_x + c_tile_width, frame_buffer_.width),
+					std::min(tile_y + c_tile_height, frame_buffer_.height),
+				};
+
+				for(const uint32_t command_index : tiles_commands_[tile_index])
+				{
+					RasterizeDrawCommand(frame_buffer_, clip, commands_[command_index], *this);
+				}
+			}
+		});
+}
+
+uint32_t DrawCommandBuffer::AddMatrix(const Matrix3& matrix)
+{
+	matrices_.push_back(matrix);
+	return uint32_t(matrices_.size() - 1);
+}
+
+uint32_t DrawCommandBuffer::AddText(const char* const text)
+{
+	const uint32_t offset = uint32_t(texts_.size());
+	texts_.insert(texts_.end(), text, text + std::strlen(text) + 1);
+	return offset;
+}
+
+uint32_t DrawCommandBuffer::AddLayer(const LayerCache& layer)
+{
+	layers_.push_back(&layer);
+	return uint32_t(layers_.size() - 1);
+}
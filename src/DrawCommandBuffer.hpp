@@ -0,0 +1,76 @@
+#pragma once
+#include "FrameBuffer.hpp"
+#include "Matrix.hpp"
+#include "SpriteAtlas.hpp"
+#include <vector>
+
+class LayerCache;
+class WorkerPool;
+
+enum class DrawCommandType : uint8_t
+{
+	FillRect,
+	SpriteRect,
+	SpriteWithAlpha,
+	SpriteWithAlphaTransformed,
+	Text,
+	Layer,
+};
+
+// Recorded call of drawing function. Meaning of fields depends on type.
+struct DrawCommand
+{
+	// Part of frame buffer, which command may modify.
+	ClipRect bounds;
+	DrawCommandType type = DrawCommandType::FillRect;
+	ColorIndex color = 0;
+	ColorIndex secondary_color = 0;
+	// Sprite orientation or text style.
+	uint8_t mode = 0;
+	SpriteId sprite = SpriteId(0);
+	// Source rect for sprite rect.
+	uint16_t sprite_start_x = 0;
+	uint16_t sprite_start_y = 0;
+	// Start position, as passed to drawing function.
+	uint32_t x = 0;
+	uint32_t y = 0;
+	// Index of matrix, text offset or layer index.
+	uint32_t payload = 0;
+};
+
+// Deferred drawing. Commands recorded during frame are binned into screen tiles
+// and tiles are rasterized in parallel. Result is identical to immediate drawing.
+class DrawCommandBuffer
+{
+public:
+	static constexpr uint32_t c_tile_width = 64;
+	static constexpr uint32_t c_tile_height = 32;
+
+public:
+	// Returns frame buffer, drawing into which records commands. Previously recorded commands are dropped.
+	FrameBuffer BeginRecording(FrameBuffer frame_buffer);
+
+	// Rasterize recorded commands into frame buffer, passed into "BeginRecording".
+	void Execute(WorkerPool& worker_pool);
+
+	// Recording. Payloads are stored in per-frame arenas and are referenced by index.
+	void AddCommand(const DrawCommand& command) { commands_.push_back(command); }
+	uint32_t AddMatrix(const Matrix3& matrix);
+	uint32_t AddText(const char* text);
+	uint32_t AddLayer(const LayerCache& layer);
+
+	const Matrix3& GetMatrix(const uint32_t index) const { return matrices_[index]; }
+	const char* GetText(const uint32_t offset) const { return texts_.data() + offset; }
+	const LayerCache& GetLayer(const uint32_t index) const { return *layers_[index]; }
+
+private:
+	FrameBuffer frame_buffer_;
+	// Commands in recording order, which is also their layer order.
+	std::vector<DrawCommand> commands_;
+	std::vector<Matrix3> matrices_;
+	// Null-terminated strings.
+	std::vector<char> texts_;
+	std::vector<const LayerCache*> layers_;
+	// Indices of commands touching each tile, sorted by layer. Reused between frames.
+	std::vector<std::vector<uint32_t>> tiles_commands_;
+};
@@ -58,6 +58,12 @@ inline fixed16_t Fixed16MulDiv(const fixed16_t x, const int32_t y, const int32_t
 	return fixed16_t(int64_t(x) * int64_t(y) / int64_t(z));
 }
 
+// Linear interpolation. "alpha" should be in range [0; 1].
+inline fixed16_t Fixed16Lerp(const fixed16_t from, const fixed16_t to, const fixed16_t alpha)
+{
+	return from + Fixed16Mul(to - from, alpha);
+}
+
 inline fixed16_t Fixed16VecDot(const fixed16vec2_t& v0, const fixed16vec2_t& v1)
 {
 	return fixed16_t((int64_t(v0[0]) * int64_t(v1[0]) + int64_t(v0[1]) * int64_t(v1[1])) >> g_fixed16_base);
@@ -1,9 +1,70 @@
 #pragma once
 #include "Color.hpp"
+#include "StateHash.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 
+// This resolution is close to 320x200 from CGA/EGA, but has 1:1 pixel aspect ratio.
+constexpr const uint32_t g_framebuffer_width  = 320;
+constexpr const uint32_t g_framebuffer_height = 240;
+
+class DrawCommandBuffer;
+
+// Rectangle [x_begin; x_end) x [y_begin; y_end) in pixels.
+struct ClipRect
+{
+	uint32_t x_begin = 0;
+	uint32_t y_begin = 0;
+	uint32_t x_end = 0;
+	uint32_t y_end = 0;
+};
+
+// Non-owning view of image. Rows may be not tightly packed, so it may describe part of larger image.
 struct FrameBuffer
 {
 	uint32_t width = 0;
 	uint32_t height = 0;
-	Color32* data = nullptr;
+	// Distance between starts of neighbor rows, in pixels.
+	uint32_t stride = 0;
+	ColorIndex* data = nullptr;
+	// If not null, drawing functions record commands into this buffer instead of modifying pixels.
+	DrawCommandBuffer* command_buffer = nullptr;
+
+	ColorIndex* GetRow(const uint32_t y) const { return data + size_t(y) * size_t(stride); }
+
+	ClipRect GetRect() const { return ClipRect{0, 0, width, height}; }
+
+	// View of rectangle inside this frame buffer, which shares its pixels.
+	// Commands recording isn't supported for sub-views.
+	FrameBuffer GetSubView(const uint32_t x, const uint32_t y, const uint32_t w, const uint32_t h) const
+	{
+		assert(x + w <= width);
+		assert(y + h <= height);
+		assert(command_buffer == nullptr);
+		return FrameBuffer{w, h, stride, GetRow(y) + x, nullptr};
+	}
 };
+
+// Tightly packed frame buffer over given storage.
+inline FrameBuffer MakeFrameBuffer(ColorIndex* const data, const uint32_t width, const uint32_t height)
+{
+	return FrameBuffer{width, height, width, data, nullptr};
+}
+
+// Hash of pixels, independent of stride. Rows are hashed in 8-pixel words, last word of row is padded with zeros.
+inline StateHasher::HashType CalculateFrameHash(const FrameBuffer frame_buffer)
+{
+	StateHasher hasher;
+	for(uint32_t y = 0; y < frame_buffer.height; ++y)
+	{
+		const ColorIndex* const line = frame_buffer.GetRow(y);
+		for(uint32_t x = 0; x < frame_buffer.width; x += 8)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, line + x, std::min(8u, frame_buffer.width - x) * sizeof(ColorIndex));
+			hasher.Add(word);
+		}
+	}
+	return hasher.GetHash();
+}
@@ -0,0 +1,68 @@
+#include "FrameDiff.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+void FrameDiff::Update(const ColorIndex* const frame, const uint32_t width, const uint32_t height, const uint32_t stride)
+{
+	TRACE_ZONE("FrameDiff::Update");
+
+	changed_rects_.clear();
+
+	if(!is_valid_ || width != width_ || height != height_)
+	{
+		// Previous frame is stored tightly packed.
+		previous_frame_.resize(size_t(width) * size_t(height));
+		for(uint32_t y = 0; y < height; ++y)
+		{
+			std::memcpy(previous_frame_.data() + y * width, frame + y * stride, width * sizeof(ColorIndex));
+		}
+		width_ = width;
+		height_ = height;
+		is_valid_ = true;
+
+		for(uint32_t tile_y = 0; tile_y < height; tile_y += c_tile_size)
+		{
+			changed_rects_.push_back({0, tile_y, width, std::min(c_tile_size, height - tile_y)});
+		}
+		return;
+	}
+
+	for(uint32_t tile_y = 0; tile_y < height; tile_y += c_tile_size)
+	{
+		const uint32_t tile_height = std::min(c_tile_size, height - tile_y);
+		for(uint32_t tile_x = 0; tile_x < width; tile_x += c_tile_size)
+		{
+			const uint32_t tile_width = std::min(c_tile_size, width - tile_x);
+			const size_t row_size = tile_width * sizeof(ColorIndex);
+
+			uint32_t y = tile_y;
+			while(y < tile_y + tile_height &&
+				std::memcmp(frame + y * stride + tile_x, previous_frame_.data() + y * width + tile_x, row_size) == 0)
+			{
+				++y;
+			}
+			if(y == tile_y + tile_height)
+			{
+				continue;
+			}
+
+			// Rows above first different row are equal, copy only remaining rows.
+			for(; y < tile_y + tile_height; ++y)
+			{
+				std::memcpy(previous_frame_.data() + y * width + tile_x, frame + y * stride + tile_x, row_size);
+			}
+
+			if(!changed_rects_.empty() &&
+				changed_rects_.back().y == tile_y &&
+				changed_rects_.back().x + changed_rects_.back().width == tile_x)
+			{
+				changed_rects_.back().width += tile_width;
+			}
+			else
+			{
+				changed_rects_.push_back({tile_x, tile_y, tile_width, tile_height});
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Color.hpp"
+#include <vector>
+
+// Finds tiles of frame which were changed since previous frame.
+class FrameDiff
+{
+public:
+	static constexpr uint32_t c_tile_size = 16;
+
+	// In pixels.
+	struct Rect
+	{
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+public:
+	// Compare frame with previous one and remember it.
+	// Whole frame is considered to be changed for first frame, after size change or after "Invalidate" call.
+	// Stride is in pixels.
+	void Update(const ColorIndex* frame, uint32_t width, uint32_t height, uint32_t stride);
+
+	// Mark whole next frame as changed. Call it if results of previous frames were lost.
+	void Invalidate() { is_valid_ = false; }
+
+	// Changed tiles, merged horizontally. Each rect lies within single row of tiles. Rects are ordered by y.
+	const std::vector<Rect>& GetChangedRects() const { return changed_rects_; }
+
+private:
+	std::vector<ColorIndex> previous_frame_;
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	bool is_valid_ = false;
+	std::vector<Rect> changed_rects_;
+};
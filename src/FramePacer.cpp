@@ -0,0 +1,125 @@
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+
+// Sleep is not precise, so spin for last part of wait.
+const auto g_spin_duration = std::chrono::microseconds(1500);
+
+// How long simulation is considered falling behind after dropping ticks.
+const auto g_falling_behind_duration = std::chrono::seconds(1);
+
+} // namespace
+
+FramePacer::FramePacer(const uint32_t max_fps)
+	: prev_deadline_(Clock::now())
+	, last_drop_time_(Clock::time_point::min())
+{
+	SetMaxFPS(max_fps);
+}
+
+void FramePacer::SetMaxFPS(const uint32_t max_fps)
+{
+	max_fps_ = max_fps;
+	frame_duration_ =
+		max_fps == 0
+			? Clock::duration::zero()
+			: std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000ull / max_fps));
+}
+
+bool FramePacer::RegisterTicks(const uint64_t num_performed, const uint64_t num_dropped)
+{
+	num_ticks_ += num_performed;
+	num_dropped_ticks_ += num_dropped;
+
+	const Clock::time_point now = Clock::now();
+	if(num_dropped > 0)
+	{
+		last_drop_time_ = now;
+	}
+
+	const bool was_falling_behind = falling_behind_;
+	falling_behind_ = last_drop_time_ != Clock::time_point::min() && now - last_drop_time_ < g_falling_behind_duration;
+	return falling_behind_ && !was_falling_behind;
+}
+
+void FramePacer::WaitNextFrame()
+{
+	++num_frames_;
+
+	if(max_fps_ == 0)
+	{
+		prev_deadline_ = Clock::now();
+		return;
+	}
+
+	const Clock::time_point deadline = prev_deadline_ + frame_duration_;
+	Clock::time_point now = Clock::now();
+	if(now > deadline)
+	{
+		// Missed deadline - do not try to catch up, start new schedule from now.
+		++num_late_frames_;
+		AddJitterSample(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline).count()));
+		prev_deadline_ = now;
+		return;
+	}
+
+	WaitUntil(deadline);
+	now = Clock::now();
+	AddJitterSample(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline).count()));
+	prev_deadline_ = deadline;
+}
+
+FramePacer::Stats FramePacer::GetStats() const
+{
+	Stats stats;
+	stats.num_frames = num_frames_;
+	stats.num_late_frames = num_late_frames_;
+	stats.num_ticks = num_ticks_;
+	stats.num_dropped_ticks = num_dropped_ticks_;
+	stats.falling_behind = falling_behind_;
+
+	const size_t num_samples = size_t(std::min(num_jitter_samples_, uint64_t(jitter_samples_.size())));
+	if(num_samples > 0)
+	{
+		auto samples = jitter_samples_;
+		const auto begin = samples.begin();
+		const auto end = samples.begin() + std::ptrdiff_t(num_samples);
+		const auto percentile =
+			[&](const size_t p)
+			{
+				const auto it = begin + std::ptrdiff_t(std::min(num_samples - 1, num_samples * p / 100));
+				std::nth_element(begin, it, end);
+				return *it;
+			};
+
+		stats.jitter_p50_ns = percentile(50);
+		stats.jitter_p95_ns = percentile(95);
+		stats.jitter_p99_ns = percentile(99);
+		stats.jitter_max_ns = *std::max_element(begin, end);
+	}
+
+	return stats;
+}
+
+void FramePacer::WaitUntil(const Clock::time_point deadline)
+{
+	const Clock::time_point now = Clock::now();
+	if(deadline - now > g_spin_duration)
+	{
+		std::this_thread::sleep_for(deadline - now - g_spin_duration);
+	}
+
+	while(Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::AddJitterSample(const uint64_t jitter_ns)
+{
+	jitter_samples_[num_jitter_samples_ % jitter_samples_.size()] = jitter_ns;
+	++num_jitter_samples_;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Paces frames with nanosecond precision and collects pacing statistics.
+class FramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t c_default_max_fps = 120;
+
+	struct Stats
+	{
+		uint64_t num_frames = 0;
+		// Frames which were finished after their deadline.
+		uint64_t num_late_frames = 0;
+		uint64_t num_ticks = 0;
+		// Ticks skipped because simulation can't keep up with real time.
+		uint64_t num_dropped_ticks = 0;
+		// Deviation of frame start from its deadline over last frames.
+		uint64_t jitter_p50_ns = 0;
+		uint64_t jitter_p95_ns = 0;
+		uint64_t jitter_p99_ns = 0;
+		uint64_t jitter_max_ns = 0;
+		// True if ticks were dropped recently.
+		bool falling_behind = false;
+	};
+
+public:
+	// Zero FPS means no limit.
+	explicit FramePacer(uint32_t max_fps = c_default_max_fps);
+
+	void SetMaxFPS(uint32_t max_fps);
+	uint32_t GetMaxFPS() const { return max_fps_; }
+
+	// Register ticks of current frame. Returns true if simulation just started falling behind.
+	bool RegisterTicks(uint64_t num_performed, uint64_t num_dropped);
+
+	// Wait until deadline of next frame and register frame end.
+	void WaitNextFrame();
+
+	Stats GetStats() const;
+
+	// Sleep most of time and spin the rest, since sleep precision is limited by system timer resolution.
+	static void WaitUntil(Clock::time_point deadline);
+
+private:
+	void AddJitterSample(uint64_t jitter_ns);
+
+private:
+	uint32_t max_fps_ = 0;
+	Clock::duration frame_duration_{};
+	Clock::time_point prev_deadline_;
+
+	uint64_t num_frames_ = 0;
+	uint64_t num_late_frames_ = 0;
+	uint64_t num_ticks_ = 0;
+	uint64_t num_dropped_ticks_ = 0;
+	Clock::time_point last_drop_time_;
+	bool falling_behind_ = false;
+
+	std::array<uint64_t, 256> jitter_samples_{};
+	uint64_t num_jitter_samples_ = 0;
+};
@@ -0,0 +1,229 @@
+#include "FrameWriter.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+struct YCbCr
+{
+	uint8_t y = 0;
+	uint8_t cb = 0;
+	uint8_t cr = 0;
+};
+
+// BT.601 limited range, which Y4M readers assume by default.
+YCbCr ConvertToYCbCr(const Color32 color)
+{
+	const int32_t r = int32_t((color >> 16) & 0xFF);
+	const int32_t g = int32_t((color >>  8) & 0xFF);
+	const int32_t b = int32_t((color >>  0) & 0xFF);
+
+	YCbCr result;
+	result.y  = uint8_t((( 66 * r + 129 * g +  25 * b + 128) >> 8) +  16);
+	result.cb = uint8_t(((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+	result.cr = uint8_t(((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+	return result;
+}
+
+} // namespace
+
+FrameWriter::FrameWriter(
+	const char* const file_name,
+	const FrameFileFormat format,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t frame_rate)
+	: format_(format)
+	, width_(width)
+	, height_(height)
+	, frame_size_(size_t(width) * size_t(height))
+	, file_(std::fopen(file_name, "wb"))
+{
+	if(file_ == nullptr)
+	{
+		return;
+	}
+
+	if(format_ == FrameFileFormat::Y4M)
+	{
+		const std::string header =
+			"YUV4MPEG2 W" + std::to_string(width_) + " H" + std::to_string(height_) +
+			" F" + std::to_string(frame_rate) + ":1 Ip A1:1 C444\n";
+		Write(header.data(), header.size());
+	}
+
+	slots_.resize(frame_size_ * c_num_slots);
+
+	thread_ = std::thread([this]{ ThreadFunc(); });
+}
+
+FrameWriter::~FrameWriter()
+{
+	Stats stats;
+	Finish(stats);
+}
+
+void FrameWriter::AddFrame(const FrameBuffer frame_buffer)
+{
+	TRACE_ZONE("FrameWriter::AddFrame");
+	assert(frame_buffer.width == width_);
+	assert(frame_buffer.height == height_);
+
+	if(file_ == nullptr)
+	{
+		return;
+	}
+
+	uint32_t slot_index = 0;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if(num_queued_slots_ == c_num_slots)
+		{
+			// Wait until half of ring is free, rather than for each slot, in order to switch threads less often.
+			using Clock = std::chrono::steady_clock;
+			const Clock::time_point wait_start = Clock::now();
+			frame_written_condition_.wait(lock, [&]{ return num_queued_slots_ <= c_num_slots / 2; });
+			++num_stalls_;
+			stalls_duration_ns_ += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - wait_start).count());
+		}
+		slot_index = (first_queued_slot_ + num_queued_slots_) % c_num_slots;
+	}
+
+	// Slot isn't queued yet, so writer thread doesn't access it.
+	ColorIndex* const dst = slots_.data() + slot_index * frame_size_;
+	for(uint32_t y = 0; y < height_; ++y)
+	{
+		std::memcpy(dst + y * width_, frame_buffer.GetRow(y), width_ * sizeof(ColorIndex));
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		++num_queued_slots_;
+	}
+	frame_added_condition_.notify_one();
+}
+
+bool FrameWriter::Finish(Stats& out_stats)
+{
+	if(file_ == nullptr)
+	{
+		out_stats = stats_;
+		return false;
+	}
+
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	frame_added_condition_.notify_one();
+	thread_.join();
+
+	if(std::fclose(file_) != 0)
+	{
+		write_error_ = true;
+	}
+	file_ = nullptr;
+
+	stats_.num_stalls = num_stalls_;
+	stats_.stalls_duration_ns = stalls_duration_ns_;
+	stats_.frames_hash = frames_hasher_.GetHash();
+	out_stats = stats_;
+	return !write_error_;
+}
+
+void FrameWriter::ThreadFunc()
+{
+	while(true)
+	{
+		uint32_t slot_index = 0;
+		uint32_t num_slots = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			frame_added_condition_.wait(lock, [&]{ return num_queued_slots_ > 0 || quit_; });
+			if(num_queued_slots_ == 0)
+			{
+				// Quit only after all queued frames are written.
+				return;
+			}
+			// Take all queued slots up to ring end.
+			slot_index = first_queued_slot_;
+			num_slots = std::min(num_queued_slots_, c_num_slots - slot_index);
+		}
+
+		WriteFrames(slots_.data() + slot_index * frame_size_, num_slots);
+
+		{
+			const std::lock_guard<std::mutex> lock(mutex_);
+			first_queued_slot_ = (first_queued_slot_ + num_slots) % c_num_slots;
+			num_queued_slots_ -= num_slots;
+		}
+		frame_written_condition_.notify_one();
+	}
+}
+
+void FrameWriter::WriteFrames(ColorIndex* const frames, const uint32_t num_frames)
+{
+	TRACE_ZONE("FrameWriter::WriteFrames");
+
+	for(uint32_t i = 0; i < num_frames; ++i)
+	{
+		frames_hasher_.Add(CalculateFrameHash(MakeFrameBuffer(frames + i * frame_size_, width_, height_)));
+	}
+
+	switch(format_)
+	{
+	case FrameFileFormat::RawIndices:
+		Write(frames, frame_size_ * num_frames * sizeof(ColorIndex));
+		break;
+
+	case FrameFileFormat::Y4M:
+		{
+			static const Palette palette = MakeCGAPalette();
+			static const auto palette_ycbcr =
+				[]
+				{
+					std::array<YCbCr, 256> result;
+					for(size_t i = 0; i < palette.size(); ++i)
+					{
+						result[i] = ConvertToYCbCr(palette[i]);
+					}
+					return result;
+				}();
+
+			// Planes are written one after another. Frames are converted one by one, since converted frame is 3 times larger.
+			const char frame_header[] = "FRAME\n";
+			converted_frame_.resize(sizeof(frame_header) - 1 + frame_size_ * 3);
+			std::memcpy(converted_frame_.data(), frame_header, sizeof(frame_header) - 1);
+			uint8_t* const y_plane = converted_frame_.data() + sizeof(frame_header) - 1;
+			uint8_t* const cb_plane = y_plane + frame_size_;
+			uint8_t* const cr_plane = cb_plane + frame_size_;
+			for(uint32_t i = 0; i < num_frames; ++i)
+			{
+				const ColorIndex* const frame = frames + i * frame_size_;
+				for(size_t j = 0; j < frame_size_; ++j)
+				{
+					const YCbCr& c = palette_ycbcr[frame[j]];
+					y_plane[j] = c.y;
+					cb_plane[j] = c.cb;
+					cr_plane[j] = c.cr;
+				}
+				Write(converted_frame_.data(), converted_frame_.size());
+			}
+		}
+		break;
+	}
+
+	stats_.num_frames += num_frames;
+}
+
+void FrameWriter::Write(const void* const data, const size_t size)
+{
+	if(std::fwrite(data, 1, size, file_) != size)
+	{
+		write_error_ = true;
+	}
+	stats_.num_bytes += size;
+}
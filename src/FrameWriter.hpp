@@ -0,0 +1,87 @@
+#pragma once
+#include "FrameBuffer.hpp"
+#include "StateHash.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class FrameFileFormat
+{
+	// Palette indices, one byte per pixel, frames follow each other without headers.
+	RawIndices,
+	// Uncompressed video with CGA colors in Y'CbCr 4:4:4, readable by most video tools.
+	Y4M,
+};
+
+// Writes sequence of frames into file in background thread.
+// Frames are copied into ring of slots, so caller waits only if writing can't keep up with all slots filled.
+// Ring absorbs bursts, but if frames are produced faster than they are written on average, caller is limited by writing speed.
+class FrameWriter
+{
+public:
+	struct Stats
+	{
+		uint64_t num_frames = 0;
+		uint64_t num_bytes = 0;
+		// Number of times caller waited for free slots. After each wait half of ring is free.
+		uint64_t num_stalls = 0;
+		uint64_t stalls_duration_ns = 0;
+		// Hash of contents of all frames.
+		StateHasher::HashType frames_hash = 0;
+	};
+
+public:
+	// All frames must have given size.
+	FrameWriter(const char* file_name, FrameFileFormat format, uint32_t width, uint32_t height, uint32_t frame_rate);
+	~FrameWriter();
+
+	FrameWriter(const FrameWriter&) = delete;
+	FrameWriter& operator=(const FrameWriter&) = delete;
+
+	bool IsOpen() const { return file_ != nullptr; }
+
+	void AddFrame(FrameBuffer frame_buffer);
+
+	// Wait until all added frames are written and close file. Returns false on write error.
+	bool Finish(Stats& out_stats);
+
+private:
+	static constexpr uint32_t c_num_slots = 64;
+
+private:
+	void ThreadFunc();
+	// Write consecutive frames from slots storage.
+	void WriteFrames(ColorIndex* frames, uint32_t num_frames);
+	void Write(const void* data, size_t size);
+
+private:
+	const FrameFileFormat format_;
+	const uint32_t width_;
+	const uint32_t height_;
+	const size_t frame_size_;
+	std::FILE* file_ = nullptr;
+
+	// Slots are stored contiguously, so that consecutive raw frames are written at once.
+	std::vector<ColorIndex> slots_;
+
+	std::mutex mutex_;
+	std::condition_variable frame_added_condition_;
+	std::condition_variable frame_written_condition_;
+	// Protected by mutex.
+	uint32_t first_queued_slot_ = 0;
+	uint32_t num_queued_slots_ = 0;
+	uint64_t num_stalls_ = 0;
+	uint64_t stalls_duration_ns_ = 0;
+	bool quit_ = false;
+
+	// Used only by writer thread until it's joined.
+	std::vector<uint8_t> converted_frame_;
+	StateHasher frames_hasher_;
+	Stats stats_;
+	bool write_error_ = false;
+
+	std::thread thread_;
+};
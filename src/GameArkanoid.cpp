@@ -5,8 +5,8 @@
 #include "GamesDrawCommon.hpp"
 #include "GameTetris.hpp"
 #include "Progress.hpp"
-#include "Sprites.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <cassert>
 #include <cmath>
 
@@ -16,6 +16,7 @@ namespace
 const fixed16_t g_ball_base_speed = g_fixed16_one * 5 / 4;
 const fixed16_t g_bonus_drop_speed = g_fixed16_one / 2;
 const fixed16_t g_laser_beam_speed = g_fixed16_one * 2;
+const fixed16_t g_max_interpolation_distance = g_fixed16_one * 16;
 
 const uint32_t g_bonus_drop_inv_chance = 7;
 const uint32_t g_max_lives = 6;
@@ -37,11 +38,15 @@ GameArkanoid::GameArkanoid(SoundPlayer& sound_player)
 	NextLevel();
 }
 
-void GameArkanoid::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameArkanoid::Tick(const InputFrame& input)
 {
+	TRACE_ZONE("GameArkanoid::Tick");
+
+	SavePrevPositions();
+
 	++tick_;
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && next_game_ == nullptr)
 		{
@@ -63,45 +68,68 @@ void GameArkanoid::Tick(const std::vector<SDL_Event>& events, const std::vector<
 
 	if(tick_ >= level_start_animation_end_tick_ && tick_ >= level_end_animation_end_tick_)
 	{
-		ProcessLogic(events, keyboard_state);
+		ProcessLogic(input);
 	}
 }
 
-void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
+void GameArkanoid::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
-	FillWholeFrameBuffer(frame_buffer, g_color_black);
+	TRACE_ZONE("GameArkanoid::Draw");
 
 	const uint32_t field_offset_x = g_arkanoid_field_offset_x;
 	const uint32_t field_offset_y = g_arkanoid_field_offset_y;
 
-	DrawArkanoidField(frame_buffer, field_);
+	// Field layer replaces frame buffer clearing.
+	StateHasher field_hasher;
+	for(const ArkanoidBlock& block : field_)
+	{
+		field_hasher.Add(block.type);
+	}
+	field_layer_.Draw(
+		frame_buffer,
+		field_hasher.GetHash(),
+		[&](const FrameBuffer layer_frame_buffer)
+		{
+			DrawArkanoidField(layer_frame_buffer, field_);
+		});
 
 	const bool playing_level_start_animation = tick_ < level_start_animation_end_tick_;
 	const bool playing_level_end_animation = tick_ < level_end_animation_end_tick_;
 
+	const auto interpolate =
+	[&](const fixed16vec2_t& prev_position, const fixed16vec2_t& position)
+	{
+		return InterpolatePosition(prev_position, position, interpolation_alpha, g_max_interpolation_distance);
+	};
+
+	std::optional<fixed16vec2_t> ship_position;
+	if(ship_ != std::nullopt)
+	{
+		ship_position = interpolate(ship_->prev_position, ship_->position);
+	}
+
 	if(ship_ != std::nullopt && !playing_level_start_animation && !playing_level_end_animation)
 	{
-		SpriteBMP sprite = Sprites::arkanoid_ship;
+		SpriteHandle sprite = SpriteId::arkanoid_ship;
 		switch(ship_->state)
 		{
 		case ShipState::Normal:
 		case ShipState::Sticky:
-			sprite = Sprites::arkanoid_ship;
+			sprite = SpriteId::arkanoid_ship;
 			break;
 		case ShipState::Large:
-			sprite = Sprites::arkanoid_ship_large;
+			sprite = SpriteId::arkanoid_ship_large;
 			break;
 		case ShipState::Turret:
-			sprite = Sprites::arkanoid_ship_with_turrets;
+			sprite = SpriteId::arkanoid_ship_with_turrets;
 			break;
 		}
 
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
-			field_offset_x + uint32_t(Fixed16FloorToInt(ship_->position[0])) - GetShipHalfWidthForState(ship_->state),
-			field_offset_y + uint32_t(Fixed16FloorToInt(ship_->position[1])) - c_ship_half_height);
+			field_offset_x + uint32_t(Fixed16FloorToInt((*ship_position)[0])) - GetShipHalfWidthForState(ship_->state),
+			field_offset_y + uint32_t(Fixed16FloorToInt((*ship_position)[1])) - c_ship_half_height);
 	}
 	if(death_animation_ != std::nullopt)
 	{
@@ -109,21 +137,19 @@ void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
 		{
 			DrawSpriteWithAlpha(
 				frame_buffer,
-				Sprites::arkanoid_ship,
-				0,
-				field_offset_x + uint32_t(Fixed16FloorToInt(ship_->position[0])) - GetShipHalfWidthForState(ship_->state),
-				field_offset_y + uint32_t(Fixed16FloorToInt(ship_->position[1])) - c_ship_half_height);
+				SpriteId::arkanoid_ship,
+				field_offset_x + uint32_t(Fixed16FloorToInt(death_animation_->ship_position[0])) - GetShipHalfWidthForState(ShipState::Normal),
+				field_offset_y + uint32_t(Fixed16FloorToInt(death_animation_->ship_position[1])) - c_ship_half_height);
 		}
 	}
 
 	for(uint32_t i = 0, ship_life_x = 0; i < lives_; ++i)
 	{
 		const uint32_t padding = 3;
-		const SpriteBMP sprite(Sprites::arkanoid_ship_life);
+		const SpriteHandle sprite(SpriteId::arkanoid_ship_life);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			padding + field_offset_x + ship_life_x,
 			padding + field_offset_y + c_block_height * (c_field_height + 1));
 		ship_life_x += sprite.GetWidth() + padding;
@@ -136,18 +162,21 @@ void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
 			fixed16vec2_t position = ball.position;
 			if(ball.is_attached_to_ship)
 			{
-				if(ship_ == std::nullopt)
+				if(ship_position == std::nullopt)
 				{
 					continue;
 				}
-				position[0] += ship_->position[0];
-				position[1] += ship_->position[1];
+				position[0] += (*ship_position)[0];
+				position[1] += (*ship_position)[1];
+			}
+			else
+			{
+				position = interpolate(ball.prev_position, ball.position);
 			}
 
 			DrawSpriteWithAlpha(
 				frame_buffer,
-				Sprites::arkanoid_ball,
-				0,
+				SpriteId::arkanoid_ball,
 				field_offset_x + uint32_t(Fixed16FloorToInt(position[0])) - c_ball_half_size,
 				field_offset_y + uint32_t(Fixed16FloorToInt(position[1])) - c_ball_half_size);
 		}
@@ -155,36 +184,42 @@ void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
 
 	for(const LaserBeam& laser_beam : laser_beams_)
 	{
+		const fixed16vec2_t position = interpolate(laser_beam.prev_position, laser_beam.position);
 		DrawSpriteWithAlpha(
 			frame_buffer,
-			Sprites::arkanoid_laser_beam,
-			0,
-			field_offset_x + uint32_t(Fixed16FloorToInt(laser_beam.position[0])),
-			field_offset_y + uint32_t(Fixed16FloorToInt(laser_beam.position[1])) - (c_laser_beam_height + 1) / 2);
+			SpriteId::arkanoid_laser_beam,
+			field_offset_x + uint32_t(Fixed16FloorToInt(position[0])),
+			field_offset_y + uint32_t(Fixed16FloorToInt(position[1])) - (c_laser_beam_height + 1) / 2);
 	}
 
-	static constexpr const SpriteBMP bonuses_sprites[]
+	static constexpr const SpriteHandle bonuses_sprites[]
 	{
-		Sprites::arkanoid_bonus_b,
-		Sprites::arkanoid_bonus_c,
-		Sprites::arkanoid_bonus_d,
-		Sprites::arkanoid_bonus_e,
-		Sprites::arkanoid_bonus_l,
-		Sprites::arkanoid_bonus_p,
-		Sprites::arkanoid_bonus_s,
+		SpriteId::arkanoid_bonus_b,
+		SpriteId::arkanoid_bonus_c,
+		SpriteId::arkanoid_bonus_d,
+		SpriteId::arkanoid_bonus_e,
+		SpriteId::arkanoid_bonus_l,
+		SpriteId::arkanoid_bonus_p,
+		SpriteId::arkanoid_bonus_s,
 	};
 
 	for(const Bonus& bonus : bonuses_)
 	{
+		const fixed16vec2_t position = interpolate(bonus.prev_position, bonus.position);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			bonuses_sprites[size_t(bonus.type)],
-			0,
-			field_offset_x + uint32_t(Fixed16FloorToInt(bonus.position[0])) - c_bonus_half_width,
-			field_offset_y + uint32_t(Fixed16FloorToInt(bonus.position[1])) - c_bonus_half_height);
+			field_offset_x + uint32_t(Fixed16FloorToInt(position[0])) - c_bonus_half_width,
+			field_offset_y + uint32_t(Fixed16FloorToInt(position[1])) - c_bonus_half_height);
 	}
 
-	DrawArkanoidFieldBorder(frame_buffer, next_level_exit_is_open_);
+	border_layer_.Draw(
+		frame_buffer,
+		next_level_exit_is_open_,
+		[&](const FrameBuffer layer_frame_buffer)
+		{
+			DrawArkanoidFieldBorder(layer_frame_buffer, next_level_exit_is_open_);
+		});
 
 	DrawArakoindStats(frame_buffer, level_, score_);
 
@@ -197,7 +232,7 @@ void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
 	{
 		DrawTextCentered(
 			frame_buffer,
-			g_cga_palette[9],
+			9,
 			field_offset_x + c_block_width  * c_field_width  / 2,
 			field_offset_y + c_block_height * (c_field_height - 6),
 			Strings::arkanoid_level_completed);
@@ -207,32 +242,103 @@ void GameArkanoid::Draw(const FrameBuffer frame_buffer) const
 	{
 		DrawTextCentered(
 			frame_buffer,
-			g_cga_palette[9],
+			9,
 			field_offset_x + c_block_width  * c_field_width  / 2,
 			field_offset_y + c_block_height * (c_field_height - 5),
 			Strings::arkanoid_game_over);
 	}
 }
 
+void GameArkanoid::HashState(StateHasher& hasher) const
+{
+	hasher.Add(rand_.PeekNext(), tick_);
+
+	for(const ArkanoidBlock& block : field_)
+	{
+		hasher.Add(block.type, block.health);
+	}
+
+	hasher.AddPresence(ship_);
+	if(ship_ != std::nullopt)
+	{
+		hasher.Add(ship_->position, ship_->state, ship_->state_end_tick, ship_->next_shoot_tick);
+	}
+
+	hasher.AddPresence(death_animation_);
+	if(death_animation_ != std::nullopt)
+	{
+		hasher.Add(death_animation_->ship_position, death_animation_->end_tick);
+	}
+
+	hasher.AddSize(balls_);
+	for(const Ball& ball : balls_)
+	{
+		hasher.Add(ball.position, ball.velocity, ball.is_attached_to_ship);
+	}
+
+	hasher.AddSize(bonuses_);
+	for(const Bonus& bonus : bonuses_)
+	{
+		hasher.Add(bonus.type, bonus.position);
+	}
+
+	hasher.AddSize(laser_beams_);
+	for(const LaserBeam& laser_beam : laser_beams_)
+	{
+		hasher.Add(laser_beam.position);
+	}
+
+	hasher.Add(
+		game_over_,
+		prev_bonus_type_,
+		next_level_exit_is_open_,
+		level_start_animation_end_tick_,
+		level_end_animation_end_tick_,
+		level_,
+		lives_,
+		score_,
+		slow_down_end_tick_);
+}
+
 GameInterfacePtr GameArkanoid::AskForNextGameTransition()
 {
 	return std::move(next_game_);
 }
 
-void GameArkanoid::ProcessLogic(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameArkanoid::SavePrevPositions()
+{
+	if(ship_ != std::nullopt)
+	{
+		ship_->prev_position = ship_->position;
+	}
+	for(Ball& ball : balls_)
+	{
+		ball.prev_position = ball.position;
+	}
+	for(Bonus& bonus : bonuses_)
+	{
+		bonus.prev_position = bonus.position;
+	}
+	for(LaserBeam& laser_beam : laser_beams_)
+	{
+		laser_beam.prev_position = laser_beam.position;
+	}
+}
+
+void GameArkanoid::ProcessLogic(const InputFrame& input)
 {
-	if(keyboard_state.size() > SDL_SCANCODE_LEFT  && keyboard_state[SDL_SCANCODE_LEFT ])
+	if(input.IsKeyPressed(SDL_SCANCODE_LEFT))
 	{
 		ship_->position[0] -= g_arkanoid_ship_keyboard_move_sensetivity;
 		CorrectShipPosition();
 	}
-	if(keyboard_state.size() > SDL_SCANCODE_RIGHT && keyboard_state[SDL_SCANCODE_RIGHT])
+	if(input.IsKeyPressed(SDL_SCANCODE_RIGHT))
 	{
 		ship_->position[0] += g_arkanoid_ship_keyboard_move_sensetivity;
 		CorrectShipPosition();
 	}
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_MOUSEMOTION)
 		{
@@ -400,10 +506,12 @@ void GameArkanoid::ProcessShootRequest()
 			LaserBeam beam0;
 			beam0.position = ship_->position;
 			beam0.position[0] += x_delta;
+			beam0.prev_position = beam0.position;
 
 			LaserBeam beam1;
 			beam1.position = ship_->position;
 			beam1.position[0] -= x_delta;
+			beam1.prev_position = beam1.position;
 
 			laser_beams_.push_back(beam0);
 			laser_beams_.push_back(beam1);
@@ -470,6 +578,7 @@ void GameArkanoid::SpawnShip()
 		IntToFixed16(c_field_width * c_block_width / 2),
 		IntToFixed16(c_field_height * c_block_height + c_ship_half_height),
 	};
+	ship.prev_position = ship.position;
 
 	ship.state = ShipState::Sticky;
 	ship.state_end_tick = tick_ + g_ship_modifier_bonus_duration;
@@ -792,6 +901,7 @@ void GameArkanoid::TrySpawnNewBonus(const uint32_t block_x, const uint32_t block
 	bonus.type = bonus_type;
 	bonus.position[0] = IntToFixed16(int32_t(block_x * c_block_width  + c_block_width  / 2));
 	bonus.position[1] = IntToFixed16(int32_t(block_y * c_block_height + c_block_height / 2));
+	bonus.prev_position = bonus.position;
 
 	bonuses_.push_back(bonus);
 
@@ -2,6 +2,7 @@
 #include "Fixed.hpp"
 #include "GameInterface.hpp"
 #include "GamesCommon.hpp"
+#include "LayerCache.hpp"
 #include "Rand.hpp"
 #include "SoundPlayer.hpp"
 #include <optional>
@@ -12,9 +13,11 @@ public:
 	explicit GameArkanoid(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual bool NeedToCaptureMouse() override { return true; }
 
@@ -28,6 +31,8 @@ private:
 	{
 		// Center position.
 		fixed16vec2_t position{};
+		// Position on previous tick, used for drawing interpolation.
+		fixed16vec2_t prev_position{};
 		// In fixed16 pixels / tick.
 		fixed16vec2_t velocity{};
 		// If true - position is relative to the ship.
@@ -46,6 +51,7 @@ private:
 	{
 		// Center position.
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 		ShipState state = ShipState::Normal;
 		uint32_t state_end_tick = 0;
 		uint32_t next_shoot_tick = 0;
@@ -74,12 +80,14 @@ private:
 		BonusType type = BonusType::NextLevel;
 		// Center position.
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 	};
 
 	struct LaserBeam
 	{
 		// Center position.
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 	};
 
 	static const constexpr uint32_t c_field_width  = g_arkanoid_field_width ;
@@ -99,7 +107,8 @@ private:
 	static const constexpr uint32_t c_ship_half_height = 5;
 
 private:
-	void ProcessLogic(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state);
+	void SavePrevPositions();
+	void ProcessLogic(const InputFrame& input);
 	void ProcessShootRequest();
 	void EndLevel();
 	void NextLevel();
@@ -148,4 +157,8 @@ private:
 	uint32_t score_ = 0;
 
 	uint32_t slow_down_end_tick_ = 0;
+
+	// Caches of static parts of frame, not a part of game state.
+	mutable LayerCache field_layer_{LayerCache::Type::Opaque};
+	mutable LayerCache border_layer_{LayerCache::Type::Transparent};
 };
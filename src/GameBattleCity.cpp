@@ -4,10 +4,10 @@
 #include "GameEndScreen.hpp"
 #include "GameMainMenu.hpp"
 #include "GamesDrawCommon.hpp"
-#include "SpriteBMP.hpp"
-#include "Sprites.hpp"
+#include "SpriteAtlas.hpp"
 #include "String.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <cassert>
 #include <cstring>
 
@@ -26,6 +26,9 @@ const fixed16_t g_tank_half_size = g_fixed16_one - 1;
 const fixed16_t g_projectile_half_size = g_fixed16_one / 8;
 const fixed16_t g_snake_bonus_half_size = g_fixed16_one / 2;
 
+// Objects move slower than one block per tick, so longer jumps are teleportations.
+const fixed16_t g_max_interpolation_distance = g_fixed16_one;
+
 const uint32_t g_min_player_reload_interval = GameInterface::c_update_frequency / 3;
 const uint32_t g_explosion_duration = GameInterface::c_update_frequency / 3;
 const uint32_t g_spawn_shield_duration = GameInterface::c_update_frequency * 3;
@@ -72,7 +75,7 @@ uint32_t BlockMaskForCoord(const uint32_t x, const uint32_t y)
 	return 1 << (x | (y << 1));
 }
 
-using DrawFunc = void(*)(FrameBuffer, SpriteBMP, uint8_t, uint32_t, uint32_t);
+using DrawFunc = SpriteWithAlphaDrawFunc;
 DrawFunc GetDrawFuncForDirection(const GridDirection direction)
 {
 	switch(direction)
@@ -104,11 +107,15 @@ GameBattleCity::GameBattleCity(SoundPlayer& sound_player)
 	SpawnSnakeBonus();
 }
 
-void GameBattleCity::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameBattleCity::Tick(const InputFrame& input)
 {
+	TRACE_ZONE("GameBattleCity::Tick");
+
+	SavePrevPositions();
+
 	++tick_;
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && next_game_ == nullptr)
 		{
@@ -136,7 +143,7 @@ void GameBattleCity::Tick(const std::vector<SDL_Event>& events, const std::vecto
 
 		if(player_ != std::nullopt)
 		{
-			ProcessPlayerInput(keyboard_state);
+			ProcessPlayerInput(input);
 			TryToPickUpBonus();
 			TryToPickUpSnakeBonus();
 		}
@@ -216,9 +223,9 @@ void GameBattleCity::Tick(const std::vector<SDL_Event>& events, const std::vecto
 	}
 }
 
-void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
+void GameBattleCity::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
-	FillWholeFrameBuffer(frame_buffer, g_color_black);
+	TRACE_ZONE("GameBattleCity::Draw");
 
 	const uint32_t field_width  = c_field_width  * c_block_size;
 	const uint32_t field_height = c_field_height * c_block_size;
@@ -226,101 +233,128 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 	const uint32_t field_offset_x = c_block_size * 2;
 	const uint32_t field_offset_y = (frame_buffer.height - field_height) / 2;
 
-	static constexpr const SpriteBMP block_sprites[]
-	{
-		Sprites::battle_city_block_bricks,
-		Sprites::battle_city_block_bricks,
-		Sprites::battle_city_block_concrete,
-		Sprites::battle_city_block_foliage,
-		Sprites::battle_city_block_water,
-		Sprites::tetris_block_small_4,
-		Sprites::tetris_block_small_7,
-		Sprites::tetris_block_small_5,
-		Sprites::tetris_block_small_1,
-		Sprites::tetris_block_small_2,
-		Sprites::tetris_block_small_6,
-		Sprites::tetris_block_small_3,
+	const auto interpolate =
+	[&](const fixed16vec2_t& prev_position, const fixed16vec2_t& position)
+	{
+		return InterpolatePosition(prev_position, position, interpolation_alpha, g_max_interpolation_distance);
+	};
+
+	static constexpr const SpriteHandle block_sprites[]
+	{
+		SpriteId::battle_city_block_bricks,
+		SpriteId::battle_city_block_bricks,
+		SpriteId::battle_city_block_concrete,
+		SpriteId::battle_city_block_foliage,
+		SpriteId::battle_city_block_water,
+		SpriteId::tetris_block_small_4,
+		SpriteId::tetris_block_small_7,
+		SpriteId::tetris_block_small_5,
+		SpriteId::tetris_block_small_1,
+		SpriteId::tetris_block_small_2,
+		SpriteId::tetris_block_small_6,
+		SpriteId::tetris_block_small_3,
 	};
 
 	if(tick_ < g_transition_time_show_field)
 	{
+		FillWholeFrameBuffer(frame_buffer, g_color_black);
+
 		// Base.
 		for(uint32_t dy = 0; dy < 2; ++dy)
 		for(uint32_t dx = 0; dx < 2; ++dx)
 		{
-			const SpriteBMP sprite(Sprites::pacman_food);
+			const SpriteHandle sprite(SpriteId::pacman_food);
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				field_offset_x + c_block_size * (c_field_width / 2 - 1 + dx) + c_block_size / 2 - sprite.GetWidth() / 2,
 				field_offset_y + c_block_size * (c_field_height - 2 + dy)  + c_block_size / 2 - sprite.GetHeight() / 2);
 		}
 
-		const uint32_t pacman_field_width  = c_field_width  + 4;
-		const uint32_t pacman_field_height = c_field_height + 4;
-		DrawPacmanField(
+		// Field is constant.
+		pacman_field_layer_.Draw(
 			frame_buffer,
-			battle_city_level_0_pacman_field,
-			pacman_field_width,
-			pacman_field_height,
-			0,
 			0,
-			pacman_field_width,
-			pacman_field_height);
+			[&](const FrameBuffer layer_frame_buffer)
+			{
+				const uint32_t pacman_field_width  = c_field_width  + 4;
+				const uint32_t pacman_field_height = c_field_height + 4;
+				DrawPacmanField(
+					layer_frame_buffer,
+					battle_city_level_0_pacman_field,
+					pacman_field_width,
+					pacman_field_height,
+					0,
+					0,
+					pacman_field_width,
+					pacman_field_height);
+			});
 	}
 	else
 	{
-		// Base.
-		DrawSpriteWithAlpha(
-			frame_buffer,
-			base_is_destroyed_ ? Sprites::battle_city_eagle_destroyed : Sprites::battle_city_eagle,
-			0,
-			field_offset_x + c_block_size * (c_field_width / 2 - 1),
-			field_offset_y + c_block_size * (c_field_height - 2));
-
-		// Draw field except foliage.
-		for(uint32_t y = 0; y < c_field_height; ++y)
-		for(uint32_t x = 0; x < c_field_width ; ++x)
+		// Static part of field replaces frame buffer clearing.
+		StateHasher field_hasher;
+		for(const Block& block : field_)
 		{
-			const Block& block = field_[x + y * c_field_width];
-			if(block.type == BlockType::Empty || block.type == BlockType::Foliage || block.destruction_mask == 0)
-			{
-				continue;
-			}
-
-			const uint32_t sprite_x = field_offset_x + x * c_block_size;
-			const uint32_t sprite_y = field_offset_y + y * c_block_size;
-			const SpriteBMP sprite = block_sprites[size_t(block.type)];
+			field_hasher.Add(block.type, block.destruction_mask);
+		}
+		field_hasher.Add(base_is_destroyed_);
 
-			if(block.destruction_mask == 0xF)
-			{
-				DrawSprite(frame_buffer, sprite, sprite_x, sprite_y);
-			}
-			else
+		field_layer_.Draw(
+			frame_buffer,
+			field_hasher.GetHash(),
+			[&](const FrameBuffer layer_frame_buffer)
 			{
-				const uint32_t segment_size = c_block_size / 2;
-				for(uint32_t dy = 0; dy < 2; ++dy)
-				for(uint32_t dx = 0; dx < 2; ++dx)
+				// Base.
+				DrawSpriteWithAlpha(
+					layer_frame_buffer,
+					base_is_destroyed_ ? SpriteId::battle_city_eagle_destroyed : SpriteId::battle_city_eagle,
+					field_offset_x + c_block_size * (c_field_width / 2 - 1),
+					field_offset_y + c_block_size * (c_field_height - 2));
+
+				// Draw field except foliage.
+				for(uint32_t y = 0; y < c_field_height; ++y)
+				for(uint32_t x = 0; x < c_field_width ; ++x)
 				{
-					if((block.destruction_mask & BlockMaskForCoord(dx, dy)) != 0)
+					const Block& block = field_[x + y * c_field_width];
+					if(block.type == BlockType::Empty || block.type == BlockType::Foliage || block.destruction_mask == 0)
+					{
+						continue;
+					}
+
+					const uint32_t sprite_x = field_offset_x + x * c_block_size;
+					const uint32_t sprite_y = field_offset_y + y * c_block_size;
+					const SpriteHandle sprite = block_sprites[size_t(block.type)];
+
+					if(block.destruction_mask == 0xF)
+					{
+						DrawSprite(layer_frame_buffer, sprite, sprite_x, sprite_y);
+					}
+					else
 					{
-						DrawSpriteRect(
-							frame_buffer,
-							sprite,
-							sprite_x + dx * segment_size,
-							sprite_y + dy * segment_size,
-							dx * segment_size,
-							dy * segment_size,
-							segment_size,
-							segment_size);
+						const uint32_t segment_size = c_block_size / 2;
+						for(uint32_t dy = 0; dy < 2; ++dy)
+						for(uint32_t dx = 0; dx < 2; ++dx)
+						{
+							if((block.destruction_mask & BlockMaskForCoord(dx, dy)) != 0)
+							{
+								DrawSpriteRect(
+									layer_frame_buffer,
+									sprite,
+									sprite_x + dx * segment_size,
+									sprite_y + dy * segment_size,
+									dx * segment_size,
+									dy * segment_size,
+									segment_size,
+									segment_size);
+							}
+						}
 					}
 				}
-			}
-		}
+			});
 	}
 
-	const Color32 border_color = g_cga_palette[8];
+	const ColorIndex border_color = 8;
 	if(tick_ >= g_transition_time_show_field_borders)
 	{
 		const uint32_t field_x_end = field_offset_x + field_width ;
@@ -334,60 +368,60 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 
 	if(snake_bonus_ != std::nullopt)
 	{
-		static constexpr const SpriteBMP bonus_sprites[]
+		static constexpr const SpriteHandle bonus_sprites[]
 		{
-			Sprites::snake_food_small,
-			Sprites::snake_food_medium,
+			SpriteId::snake_food_small,
+			SpriteId::snake_food_medium,
 		};
 
-		const SpriteBMP sprite =
+		const SpriteHandle sprite =
 			tick_ < g_transition_time_show_field
-				? Sprites::pacman_bonus_deadly
+				? SpriteId::pacman_bonus_deadly
 				: bonus_sprites[size_t(snake_bonus_->type)];
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			field_offset_x + uint32_t(Fixed16FloorToInt(snake_bonus_->position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
 			field_offset_y + uint32_t(Fixed16FloorToInt(snake_bonus_->position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	}
 
 	if(player_ != std::nullopt)
 	{
-		const uint32_t x = uint32_t(Fixed16FloorToInt(player_->position[0] * int32_t(c_block_size)));
-		const uint32_t y = uint32_t(Fixed16FloorToInt(player_->position[1] * int32_t(c_block_size)));
+		const fixed16vec2_t position = interpolate(player_->prev_position, player_->position);
+		const uint32_t x = uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size)));
+		const uint32_t y = uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size)));
 
 		if(tick_ < g_transition_time_show_tank)
 		{
-			static constexpr const SpriteBMP sprites[]
+			static constexpr const SpriteHandle sprites[]
 			{
-				Sprites::pacman_0,
-				Sprites::pacman_1,
-				Sprites::pacman_2,
-				Sprites::pacman_3,
-				Sprites::pacman_2,
-				Sprites::pacman_1,
+				SpriteId::pacman_0,
+				SpriteId::pacman_1,
+				SpriteId::pacman_2,
+				SpriteId::pacman_3,
+				SpriteId::pacman_2,
+				SpriteId::pacman_1,
 			};
 
 			const uint32_t num_frames = uint32_t(std::size(sprites));
-			const fixed16_t dist = player_->position[0] + player_->position[1];
+			const fixed16_t dist = position[0] + position[1];
 
-			const SpriteBMP sprite(sprites[((uint32_t(dist) * num_frames) >> g_fixed16_base) % num_frames]);
+			const SpriteHandle sprite(sprites[((uint32_t(dist) * num_frames) >> g_fixed16_base) % num_frames]);
 			const uint32_t pacman_x = field_offset_x + x - sprite.GetWidth () / 2;
 			const uint32_t pacman_y = field_offset_y + y - sprite.GetHeight() / 2;
 			switch(player_->direction)
 			{
 			case GridDirection::XMinus:
-				DrawSpriteWithAlphaRotate180(frame_buffer, sprite, 0, pacman_x, pacman_y);
+				DrawSpriteWithAlphaRotate180(frame_buffer, sprite, pacman_x, pacman_y);
 				break;
 			case GridDirection::XPlus:
-				DrawSpriteWithAlpha         (frame_buffer, sprite, 0, pacman_x, pacman_y);
+				DrawSpriteWithAlpha         (frame_buffer, sprite, pacman_x, pacman_y);
 				break;
 			case GridDirection::YMinus:
-				DrawSpriteWithAlphaRotate270(frame_buffer, sprite, 0, pacman_x, pacman_y);
+				DrawSpriteWithAlphaRotate270(frame_buffer, sprite, pacman_x, pacman_y);
 				break;
 			case GridDirection::YPlus:
-				DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, 0, pacman_x, pacman_y);
+				DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, pacman_x, pacman_y);
 				break;
 			}
 		}
@@ -396,56 +430,54 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 			{
 				const bool use_a = ((x ^ y) & 1) != 0;
 
-				const SpriteBMP sprite(use_a ? Sprites::battle_city_player_0_a : Sprites::battle_city_player_0_b);
+				const SpriteHandle sprite(use_a ? SpriteId::battle_city_player_0_a : SpriteId::battle_city_player_0_b);
 				GetDrawFuncForDirection(player_->direction)(
 					frame_buffer,
 					sprite,
-					0,
 					field_offset_x + x - sprite.GetWidth () / 2,
 					field_offset_y + y - sprite.GetHeight() / 2);
 			}
 
 			if(tick_ < player_->shield_end_tick)
 			{
-				const SpriteBMP sprite(tick_ / 6 % 2 != 0 ? Sprites::battle_city_player_shield_a : Sprites::battle_city_player_shield_b);
+				const SpriteHandle sprite(tick_ / 6 % 2 != 0 ? SpriteId::battle_city_player_shield_a : SpriteId::battle_city_player_shield_b);
 				DrawSpriteWithAlpha(
 					frame_buffer,
 					sprite,
-					0,
 					field_offset_x + x - sprite.GetWidth () / 2,
 					field_offset_y + y - sprite.GetHeight() / 2);
 			}
 		}
 	}
 
-	static constexpr const SpriteBMP spawn_glow_sprites[]
+	static constexpr const SpriteHandle spawn_glow_sprites[]
 	{
-		Sprites::battle_city_tank_spawn_glow_0,
-		Sprites::battle_city_tank_spawn_glow_1,
-		Sprites::battle_city_tank_spawn_glow_2,
-		Sprites::battle_city_tank_spawn_glow_1,
-		Sprites::battle_city_tank_spawn_glow_0,
-		Sprites::battle_city_tank_spawn_glow_1,
-		Sprites::battle_city_tank_spawn_glow_2,
-		Sprites::battle_city_tank_spawn_glow_1,
-		Sprites::battle_city_tank_spawn_glow_0,
+		SpriteId::battle_city_tank_spawn_glow_0,
+		SpriteId::battle_city_tank_spawn_glow_1,
+		SpriteId::battle_city_tank_spawn_glow_2,
+		SpriteId::battle_city_tank_spawn_glow_1,
+		SpriteId::battle_city_tank_spawn_glow_0,
+		SpriteId::battle_city_tank_spawn_glow_1,
+		SpriteId::battle_city_tank_spawn_glow_2,
+		SpriteId::battle_city_tank_spawn_glow_1,
+		SpriteId::battle_city_tank_spawn_glow_0,
 	};
 	const auto num_spawn_glow_sprites = uint32_t(std::size(spawn_glow_sprites));
 
 	for(const Enemy& enemy : enemies_)
 	{
-		const uint32_t x = uint32_t(Fixed16FloorToInt(enemy.position[0] * int32_t(c_block_size)));
-		const uint32_t y = uint32_t(Fixed16FloorToInt(enemy.position[1] * int32_t(c_block_size)));
+		const fixed16vec2_t position = interpolate(enemy.prev_position, enemy.position);
+		const uint32_t x = uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size)));
+		const uint32_t y = uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size)));
 
 		if(tick_ < enemy.spawn_tick + g_enemy_spawn_animation_duration)
 		{
 			uint32_t i = std::min((tick_ - enemy.spawn_tick) * num_spawn_glow_sprites / g_enemy_spawn_animation_duration, num_spawn_glow_sprites - 1);
-			const SpriteBMP sprite = spawn_glow_sprites[i];
+			const SpriteHandle sprite = spawn_glow_sprites[i];
 
 			GetDrawFuncForDirection(enemy.direction)(
 				frame_buffer,
 				sprite,
-				0,
 				field_offset_x + x - sprite.GetWidth () / 2,
 				field_offset_y + y - sprite.GetHeight() / 2);
 		}
@@ -453,20 +485,20 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 		{
 			const bool use_a = ((x ^ y) & 1) != 0;
 
-			SpriteBMP sprite(Sprites::battle_city_enemy_0_a);
+			SpriteHandle sprite(SpriteId::battle_city_enemy_0_a);
 			switch(enemy.type)
 			{
 			case EnemyType::Basic:
-				sprite = use_a ? Sprites::battle_city_enemy_0_a : Sprites::battle_city_enemy_0_b;
+				sprite = use_a ? SpriteId::battle_city_enemy_0_a : SpriteId::battle_city_enemy_0_b;
 				break;
 			case EnemyType::LessRandom:
-				sprite = use_a ? Sprites::battle_city_enemy_1_a : Sprites::battle_city_enemy_1_b;
+				sprite = use_a ? SpriteId::battle_city_enemy_1_a : SpriteId::battle_city_enemy_1_b;
 				break;
 			case EnemyType::Fast:
-				sprite = use_a ? Sprites::battle_city_enemy_2_a : Sprites::battle_city_enemy_2_b;
+				sprite = use_a ? SpriteId::battle_city_enemy_2_a : SpriteId::battle_city_enemy_2_b;
 				break;
 			case EnemyType::Heavy:
-				sprite = use_a ? Sprites::battle_city_enemy_3_a : Sprites::battle_city_enemy_3_b;
+				sprite = use_a ? SpriteId::battle_city_enemy_3_a : SpriteId::battle_city_enemy_3_b;
 				break;
 			case EnemyType::NumTypes:
 				assert(false);
@@ -483,7 +515,7 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 				{
 					FillRect(
 						frame_buffer,
-						g_cga_palette[colors[i]],
+						colors[i],
 						start_x,
 						start_y,
 						sprite.GetWidth(),
@@ -491,31 +523,31 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 				}
 			}
 
-			GetDrawFuncForDirection(enemy.direction)( frame_buffer, sprite, 0, start_x, start_y);
+			GetDrawFuncForDirection(enemy.direction)( frame_buffer, sprite, start_x, start_y);
 		}
 	}
 
 	for(const PacmanGhost& pacman_ghost : pacman_ghosts_)
 	{
-		const SpriteBMP sprite = GetPacmanGhostSprite(pacman_ghost.type, pacman_ghost.direction);
+		const SpriteHandle sprite = GetPacmanGhostSprite(pacman_ghost.type, pacman_ghost.direction);
+		const fixed16vec2_t position = interpolate(pacman_ghost.prev_position, pacman_ghost.position);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
-			field_offset_x + uint32_t(Fixed16FloorToInt(pacman_ghost.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
-			field_offset_y + uint32_t(Fixed16FloorToInt(pacman_ghost.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
+			field_offset_x + uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
+			field_offset_y + uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	}
 
 	const auto draw_projectile =
 	[&](const Projectile& projectile)
 	{
-		const SpriteBMP sprite(projectile.is_armor_piercing ? Sprites::arkanoid_ball : Sprites::battle_city_projectile);
+		const SpriteHandle sprite(projectile.is_armor_piercing ? SpriteId::arkanoid_ball : SpriteId::battle_city_projectile);
+		const fixed16vec2_t position = interpolate(projectile.prev_position, projectile.position);
 		GetDrawFuncForDirection(projectile.direction)(
 			frame_buffer,
 			sprite,
-			0,
-			field_offset_x + uint32_t(Fixed16FloorToInt(projectile.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
-			field_offset_y + uint32_t(Fixed16FloorToInt(projectile.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
+			field_offset_x + uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
+			field_offset_y + uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	};
 
 	if(player_ != std::nullopt)
@@ -533,27 +565,26 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 		}
 	}
 
-	static constexpr const SpriteBMP explosion_sprites[]
+	static constexpr const SpriteHandle explosion_sprites[]
 	{
-		Sprites::battle_city_explosion_0,
-		Sprites::battle_city_explosion_1,
-		Sprites::battle_city_explosion_2,
-		Sprites::battle_city_explosion_2,
-		Sprites::battle_city_explosion_1,
-		Sprites::battle_city_explosion_0
+		SpriteId::battle_city_explosion_0,
+		SpriteId::battle_city_explosion_1,
+		SpriteId::battle_city_explosion_2,
+		SpriteId::battle_city_explosion_2,
+		SpriteId::battle_city_explosion_1,
+		SpriteId::battle_city_explosion_0
 	};
 	const auto num_explosion_sprites = uint32_t(std::size(explosion_sprites));
 
 	for(const Explosion& explosion : explosions_)
 	{
 		uint32_t i = std::min((tick_ - explosion.start_tick) * num_explosion_sprites / g_explosion_duration, num_explosion_sprites - 1);
-		const SpriteBMP sprite = explosion_sprites[i];
+		const SpriteHandle sprite = explosion_sprites[i];
 
 		// Use pseudo-random rotation.
 		GetDrawFuncForDirection(GridDirection(explosion.start_tick % 4))(
 			frame_buffer,
 			sprite,
-			0,
 			field_offset_x + uint32_t(Fixed16FloorToInt(explosion.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
 			field_offset_y + uint32_t(Fixed16FloorToInt(explosion.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	}
@@ -573,7 +604,6 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				block_sprites[size_t(BlockType::Foliage)],
-				0,
 				field_offset_x + x * c_block_size,
 				field_offset_y + y * c_block_size);
 		}
@@ -581,21 +611,20 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 
 	if(bonus_ != std::nullopt)
 	{
-		static constexpr const SpriteBMP bonus_sprites[]
+		static constexpr const SpriteHandle bonus_sprites[]
 		{
-			Sprites::battle_city_bonus_tank,
-			Sprites::battle_city_bonus_star,
-			Sprites::battle_city_bonus_helmet,
-			Sprites::battle_city_bonus_shovel,
-			Sprites::battle_city_bonus_grenade,
-			Sprites::battle_city_bonus_clock,
+			SpriteId::battle_city_bonus_tank,
+			SpriteId::battle_city_bonus_star,
+			SpriteId::battle_city_bonus_helmet,
+			SpriteId::battle_city_bonus_shovel,
+			SpriteId::battle_city_bonus_grenade,
+			SpriteId::battle_city_bonus_clock,
 		};
 
-		const SpriteBMP sprite = bonus_sprites[size_t(bonus_->type)];
+		const SpriteHandle sprite = bonus_sprites[size_t(bonus_->type)];
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			field_offset_x + uint32_t(Fixed16FloorToInt(bonus_->position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
 			field_offset_y + uint32_t(Fixed16FloorToInt(bonus_->position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	}
@@ -604,13 +633,12 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 
 	if(tick_ < g_transition_time_hide_pacman_ui)
 	{
-		const SpriteBMP life_spirte(Sprites::pacman_life);
+		const SpriteHandle life_spirte(SpriteId::pacman_life);
 		for(uint32_t i = 0; i < lives_; ++i)
 		{
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				life_spirte,
-				0,
 				field_offset_x + (c_field_width + 1) * c_block_size + i % 3 * (life_spirte.GetWidth() + 2),
 				c_block_size * 2 + i / 3 * (life_spirte.GetHeight() + 3));
 		}
@@ -618,13 +646,13 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 		const uint32_t texts_offset_x = field_offset_x + (c_field_width + 1) * c_block_size;
 		const uint32_t texts_offset_y = 8 * g_glyph_height;
 
-		DrawText(frame_buffer, g_cga_palette[10], texts_offset_x, texts_offset_y + 0 * g_glyph_height, Strings::pacman_level);
+		DrawText(frame_buffer, 10, texts_offset_x, texts_offset_y + 0 * g_glyph_height, Strings::pacman_level);
 
 		char text[64];
 		NumToString(text, sizeof(text), level_, 5);
 		DrawText(frame_buffer, g_color_white, texts_offset_x, texts_offset_y + 2 * g_glyph_height, text);
 
-		DrawText(frame_buffer, g_cga_palette[10], texts_offset_x, texts_offset_y + 5 * g_glyph_height, Strings::pacman_score);
+		DrawText(frame_buffer, 10, texts_offset_x, texts_offset_y + 5 * g_glyph_height, Strings::pacman_score);
 		DrawText(frame_buffer, g_color_white, texts_offset_x, texts_offset_y + 7 * g_glyph_height, "    ß");
 	}
 
@@ -632,7 +660,7 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 	{
 		for(uint32_t i = 0; i < enemies_left_; ++i)
 		{
-			const SpriteBMP sprite(Sprites::battle_city_remaining_enemy);
+			const SpriteHandle sprite(SpriteId::battle_city_remaining_enemy);
 			DrawSprite(
 				frame_buffer,
 				sprite,
@@ -644,7 +672,7 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 		{
 			for(uint32_t i = 0; i < player_->armor_piercing_shells; ++i)
 			{
-				const SpriteBMP sprite(Sprites::arkanoid_ball);
+				const SpriteHandle sprite(SpriteId::arkanoid_ball);
 				DrawSprite(
 					frame_buffer,
 					sprite,
@@ -659,20 +687,20 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 
 		DrawText(frame_buffer, g_color_black, texts_offset_x, texts_offset_y, "IP");
 		NumToString(text, sizeof(text), lives_, 2);
-		DrawSprite(frame_buffer, Sprites::battle_city_player_lives_symbol, texts_offset_x, texts_offset_y + g_glyph_height);
+		DrawSprite(frame_buffer, SpriteId::battle_city_player_lives_symbol, texts_offset_x, texts_offset_y + g_glyph_height);
 		DrawText(frame_buffer, g_color_black, texts_offset_x, texts_offset_y + g_glyph_height, text);
 
 		NumToString(text, sizeof(text), level_, 2);
 		DrawText(frame_buffer, g_color_black, texts_offset_x, texts_offset_y + g_glyph_height * 8, text);
-		DrawSprite(frame_buffer, Sprites::battle_city_level_symbol, texts_offset_x, texts_offset_y + g_glyph_height * 6);
+		DrawSprite(frame_buffer, SpriteId::battle_city_level_symbol, texts_offset_x, texts_offset_y + g_glyph_height * 6);
 	}
 
 	if(game_over_)
 	{
 		DrawTextCenteredWithOutline(
 			frame_buffer,
-			g_cga_palette[4],
-			g_cga_palette[15],
+			4,
+			15,
 			field_offset_x + c_field_width  * c_block_size / 2,
 			field_offset_y + c_field_height * c_block_size / 2,
 			Strings::battle_city_game_over);
@@ -702,7 +730,7 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 
 			DrawTextCentered(
 				frame_buffer,
-				g_cga_palette[0],
+				0,
 				field_offset_x + c_field_width  * c_block_size / 2,
 				field_offset_y + c_field_height * c_block_size / 2,
 				text);
@@ -710,11 +738,119 @@ void GameBattleCity::Draw(const FrameBuffer frame_buffer) const
 	}
 }
 
+void GameBattleCity::HashState(StateHasher& hasher) const
+{
+	hasher.Add(rand_.PeekNext(), tick_);
+
+	for(const Block& block : field_)
+	{
+		hasher.Add(block.type, block.destruction_mask);
+	}
+
+	hasher.Add(base_is_destroyed_);
+
+	const auto hash_projectile =
+		[&](const Projectile& projectile)
+		{
+			hasher.Add(projectile.position, projectile.direction, projectile.is_armor_piercing);
+		};
+
+	hasher.AddPresence(player_);
+	if(player_ != std::nullopt)
+	{
+		hasher.Add(
+			player_->position,
+			player_->direction,
+			player_->next_shot_tick,
+			player_->shield_end_tick,
+			player_->armor_piercing_shells);
+
+		hasher.AddSize(player_->projectiles);
+		for(const Projectile& projectile : player_->projectiles)
+		{
+			hash_projectile(projectile);
+		}
+	}
+
+	hasher.Add(player_level_);
+
+	hasher.AddSize(enemies_);
+	for(const Enemy& enemy : enemies_)
+	{
+		hasher.Add(enemy.type, enemy.health, enemy.gives_bonus, enemy.position, enemy.direction, enemy.spawn_tick);
+		hasher.AddPresence(enemy.projectile);
+		if(enemy.projectile != std::nullopt)
+		{
+			hash_projectile(*enemy.projectile);
+		}
+	}
+
+	hasher.Add(enemies_left_);
+
+	hasher.AddSize(pacman_ghosts_);
+	for(const PacmanGhost& pacman_ghost : pacman_ghosts_)
+	{
+		hasher.Add(pacman_ghost.position, pacman_ghost.direction, pacman_ghost.type);
+	}
+
+	hasher.AddSize(explosions_);
+	for(const Explosion& explosion : explosions_)
+	{
+		hasher.Add(explosion.position, explosion.start_tick);
+	}
+
+	hasher.AddPresence(bonus_);
+	if(bonus_ != std::nullopt)
+	{
+		hasher.Add(bonus_->type, bonus_->position);
+	}
+
+	hasher.AddPresence(snake_bonus_);
+	if(snake_bonus_ != std::nullopt)
+	{
+		hasher.Add(snake_bonus_->type, snake_bonus_->position);
+	}
+
+	hasher.Add(
+		extra_elements_spawn_points_,
+		enemies_freezee_bonus_end_tick_,
+		base_protection_bonus_end_tick_,
+		level_start_animation_end_tick_,
+		level_end_animation_end_tick_,
+		lives_,
+		level_,
+		game_over_);
+}
+
 GameInterfacePtr GameBattleCity::AskForNextGameTransition()
 {
 	return std::move(next_game_);
 }
 
+void GameBattleCity::SavePrevPositions()
+{
+	if(player_ != std::nullopt)
+	{
+		player_->prev_position = player_->position;
+		for(Projectile& projectile : player_->projectiles)
+		{
+			projectile.prev_position = projectile.position;
+		}
+	}
+	for(Enemy& enemy : enemies_)
+	{
+		enemy.prev_position = enemy.position;
+		if(enemy.projectile != std::nullopt)
+		{
+			enemy.projectile->prev_position = enemy.projectile->position;
+		}
+	}
+	for(PacmanGhost& pacman_ghost : pacman_ghosts_)
+	{
+		pacman_ghost.prev_position = pacman_ghost.position;
+	}
+}
+
 void GameBattleCity::EndLevel()
 {
 	if(tick_ < level_end_animation_end_tick_)
@@ -762,12 +898,12 @@ void GameBattleCity::NextLevel()
 	SpawnPlayer();
 }
 
-void GameBattleCity::ProcessPlayerInput(const std::vector<bool>& keyboard_state)
+void GameBattleCity::ProcessPlayerInput(const InputFrame& input)
 {
-	const bool left_pressed = keyboard_state.size() > size_t(SDL_SCANCODE_LEFT) && keyboard_state[size_t(SDL_SCANCODE_LEFT)];
-	const bool right_pressed = keyboard_state.size() > size_t(SDL_SCANCODE_RIGHT) && keyboard_state[size_t(SDL_SCANCODE_RIGHT)];
-	const bool up_pressed = keyboard_state.size() > size_t(SDL_SCANCODE_UP) && keyboard_state[size_t(SDL_SCANCODE_UP)];
-	const bool down_pressed = keyboard_state.size() > size_t(SDL_SCANCODE_DOWN) && keyboard_state[size_t(SDL_SCANCODE_DOWN)];
+	const bool left_pressed = input.IsKeyPressed(SDL_SCANCODE_LEFT);
+	const bool right_pressed = input.IsKeyPressed(SDL_SCANCODE_RIGHT);
+	const bool up_pressed = input.IsKeyPressed(SDL_SCANCODE_UP);
+	const bool down_pressed = input.IsKeyPressed(SDL_SCANCODE_DOWN);
 
 	if(tick_ >= g_transition_time_show_tank)
 	{
@@ -894,9 +1030,9 @@ void GameBattleCity::ProcessPlayerInput(const std::vector<bool>& keyboard_state)
 	}
 
 	// Shoot.
-	if(((keyboard_state.size() > size_t(SDL_SCANCODE_LCTRL) && keyboard_state[size_t(SDL_SCANCODE_LCTRL)]) ||
-		(keyboard_state.size() > size_t(SDL_SCANCODE_RCTRL) && keyboard_state[size_t(SDL_SCANCODE_RCTRL)]) ||
-		(keyboard_state.size() > size_t(SDL_SCANCODE_SPACE) && keyboard_state[size_t(SDL_SCANCODE_SPACE)])) &&
+	if((input.IsKeyPressed(SDL_SCANCODE_LCTRL) ||
+		input.IsKeyPressed(SDL_SCANCODE_RCTRL) ||
+		input.IsKeyPressed(SDL_SCANCODE_SPACE)) &&
 		tick_ >= g_transition_time_show_tank)
 	{
 		const size_t max_active_projectiles = player_level_;
@@ -1691,6 +1827,7 @@ void GameBattleCity::SpawnPlayer()
 {
 	Player player;
 	player.position = {IntToFixed16(int32_t(c_field_width / 2 - 4)), IntToFixed16(int32_t(c_field_height - 1))};
+	player.prev_position = player.position;
 	player.direction = GridDirection::YMinus;
 	player.shield_end_tick = tick_ + g_spawn_shield_duration;
 
@@ -1745,6 +1882,7 @@ void GameBattleCity::SpawnNewEnemy()
 		enemy.type = EnemyType(rand_.Next() % uint32_t(EnemyType::NumTypes));
 		enemy.health = enemy.type == EnemyType::Heavy ? 3 : 1;
 		enemy.position = position;
+		enemy.prev_position = position;
 		enemy.direction = GridDirection::YPlus;
 		enemy.spawn_tick = tick_;
 
@@ -1826,6 +1964,7 @@ void GameBattleCity::SpawnPacmanGhost()
 
 		PacmanGhost pacman_ghost;
 		pacman_ghost.position = position;
+		pacman_ghost.prev_position = position;
 		pacman_ghost.direction = GridDirection::YPlus;
 		pacman_ghost.type = ghost_type;
 
@@ -2133,11 +2272,8 @@ void GameBattleCity::FillField(const char* field_data)
 		{
 			Block& block = field_[x + y * c_field_width];
 			block.type = GetBlockTypeForLevelDataByte(*field_data);
-
-			if(block.type != BlockType::Empty)
-			{
-				block.destruction_mask = 0xF;
-			}
+			// Reset mask for empty blocks too, in order to avoid leaving garbage from previous level or uninitialized memory.
+			block.destruction_mask = block.type == BlockType::Empty ? 0 : 0xF;
 		}
 		assert(*field_data == '\n');
 		++field_data;
@@ -2183,6 +2319,7 @@ GameBattleCity::Projectile GameBattleCity::MakeProjectile(
 		projectile.position[1] -= offset;
 		break;
 	}
+	projectile.prev_position = projectile.position;
 
 	return projectile;
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "GameInterface.hpp"
 #include "GamesCommon.hpp"
+#include "LayerCache.hpp"
 #include "Rand.hpp"
 #include "SoundPlayer.hpp"
 #include <optional>
@@ -11,9 +12,11 @@ public:
 	explicit GameBattleCity(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual GameInterfacePtr AskForNextGameTransition() override;
 
@@ -44,6 +47,8 @@ private:
 	struct Projectile
 	{
 		fixed16vec2_t position{};
+		// Position on previous tick, used for drawing interpolation.
+		fixed16vec2_t prev_position{};
 		GridDirection direction = GridDirection::YMinus;
 		bool is_armor_piercing = false;
 	};
@@ -51,6 +56,7 @@ private:
 	struct Player
 	{
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 		GridDirection direction = GridDirection::YMinus;
 		uint32_t next_shot_tick = 0;
 		uint32_t shield_end_tick = 0;
@@ -73,6 +79,7 @@ private:
 		uint8_t health = 0;
 		bool gives_bonus = false;
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 		GridDirection direction = GridDirection::YPlus;
 		uint32_t spawn_tick = 0;
 		std::optional<Projectile> projectile;
@@ -81,6 +88,7 @@ private:
 	struct PacmanGhost
 	{
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 		GridDirection direction = GridDirection::YPlus;
 		PacmanGhostType type = PacmanGhostType::Blinky;
 	};
@@ -145,9 +153,10 @@ private:
 	};
 
 private:
+	void SavePrevPositions();
 	void EndLevel();
 	void NextLevel();
-	void ProcessPlayerInput(const std::vector<bool>& keyboard_state);
+	void ProcessPlayerInput(const InputFrame& input);
 	void TryToPickUpBonus();
 	void TryToPickUpSnakeBonus();
 
@@ -213,4 +222,8 @@ private:
 	uint32_t lives_ = 0;
 	uint32_t level_ = 0;
 	bool game_over_ = false;
+
+	// Caches of static parts of field, not a part of game state.
+	mutable LayerCache field_layer_{LayerCache::Type::Opaque};
+	mutable LayerCache pacman_field_layer_{LayerCache::Type::Transparent};
 };
@@ -1,8 +1,8 @@
 #include "GameEndScreen.hpp"
 #include "Draw.hpp"
 #include "GameMainMenu.hpp"
-#include "Sprites.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 
 GameEndScreen::GameEndScreen(SoundPlayer& sound_player)
 	: sound_player_(sound_player)
@@ -10,11 +10,11 @@ GameEndScreen::GameEndScreen(SoundPlayer& sound_player)
 	OpenGame(GameId::EndScreen);
 }
 
-void GameEndScreen::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameEndScreen::Tick(const InputFrame& input)
 {
-	(void) keyboard_state;
+	TRACE_ZONE("GameEndScreen::Tick");
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && next_game_ == nullptr)
 		{
@@ -29,35 +29,44 @@ void GameEndScreen::Tick(const std::vector<SDL_Event>& events, const std::vector
 	}
 }
 
-void GameEndScreen::Draw(const FrameBuffer frame_buffer) const
+void GameEndScreen::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
-	DrawSprite(frame_buffer, Sprites::dresdner_zwinger_in_der_nacht, 0, 0);
+	TRACE_ZONE("GameEndScreen::Draw");
+
+	(void)interpolation_alpha;
+
+	DrawSprite(frame_buffer, SpriteId::dresdner_zwinger_in_der_nacht, 0, 0);
 
 	DrawTextWithOutline(
 		frame_buffer,
-		g_cga_palette[11],
-		g_cga_palette[0],
+		11,
+		0,
 		g_glyph_width / 2,
 		g_glyph_height * 1,
 		Strings::end_screen_congratulations);
 
 	DrawTextWithOutline(
 		frame_buffer,
-		g_cga_palette[15],
-		g_cga_palette[0],
+		15,
+		0,
 		g_glyph_width / 2,
 		g_glyph_height * 10,
 		Strings::end_screen_authors);
 
 	DrawTextWithFullShadow(
 		frame_buffer,
-		g_cga_palette[14],
-		g_cga_palette[8],
+		14,
+		8,
 		frame_buffer.width - 20 * g_glyph_width,
 		frame_buffer.height - g_glyph_height * 4 - g_glyph_height / 2,
 		Strings::end_screen_peace_text);
 }
 
+void GameEndScreen::HashState(StateHasher& hasher) const
+{
+	hasher.Add(music_started_);
+}
+
 GameInterfacePtr GameEndScreen::AskForNextGameTransition()
 {
 	return std::move(next_game_);
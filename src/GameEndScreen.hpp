@@ -8,9 +8,11 @@ public:
 	explicit GameEndScreen(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual GameInterfacePtr AskForNextGameTransition() override;
 
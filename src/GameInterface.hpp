@@ -1,8 +1,9 @@
 #pragma once
+#include "Fixed.hpp"
 #include "FrameBuffer.hpp"
-#include <SDL_events.h>
+#include "InputFrame.hpp"
+#include "StateHash.hpp"
 #include <memory>
-#include <vector>
 
 class GameInterface;
 using GameInterfacePtr = std::unique_ptr<GameInterface>;
@@ -12,11 +13,14 @@ class GameInterface
 public:
 	virtual ~GameInterface() = default;
 
-	virtual void Tick(
-		const std::vector<SDL_Event>& events,
-		const std::vector<bool>& keyboard_state) = 0;
+	virtual void Tick(const InputFrame& input) = 0;
 
-	virtual void Draw(FrameBuffer frame_buffer) const = 0;
+	// "interpolation_alpha" is position between previous and current ticks in range [0; 1].
+	// Games may use it to draw moving objects smoothly if display rate differs from ticks rate.
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const = 0;
+
+	// Add all state affecting simulation into given hasher. Used for desync detection.
+	virtual void HashState(StateHasher& hasher) const = 0;
 
 	virtual bool NeedToCaptureMouse() { return false; }
 
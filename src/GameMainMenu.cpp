@@ -6,15 +6,12 @@
 #include "GamePacman.hpp"
 #include "GameSnake.hpp"
 #include "GameTetris.hpp"
-#include "Sprites.hpp"
-#include "SpriteBMP.hpp"
+#include "SpriteAtlas.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <SDL_keyboard.h>
 #include <cassert>
 
-namespace
-{
-
 GameInterfacePtr CreateGameById(const GameId id, SoundPlayer& sound_player)
 {
 	switch(id)
@@ -32,6 +29,9 @@ GameInterfacePtr CreateGameById(const GameId id, SoundPlayer& sound_player)
 	return nullptr;
 }
 
+namespace
+{
+
 GameInterfacePtr CreateGameByIndex(const uint32_t index, SoundPlayer& sound_player)
 {
 	return CreateGameById(GameId(index), sound_player);
@@ -44,11 +44,11 @@ GameMainMenu::GameMainMenu(SoundPlayer& sound_player)
 {
 }
 
-void GameMainMenu::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameMainMenu::Tick(const InputFrame& input)
 {
-	(void)keyboard_state;
+	TRACE_ZONE("GameMainMenu::Tick");
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN)
 		{
@@ -152,21 +152,25 @@ void GameMainMenu::Tick(const std::vector<SDL_Event>& events, const std::vector<
 	++tick_;
 }
 
-void GameMainMenu::Draw(const FrameBuffer frame_buffer) const
+void GameMainMenu::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
-	DrawSprite(frame_buffer, Sprites::kloster_unser_lieben_frauen_magdeburg, 0, 0);
+	TRACE_ZONE("GameMainMenu::Draw");
+
+	(void)interpolation_alpha;
 
-	const SpriteBMP game_name_sprite(Sprites::game_name);
-	DrawSpriteWithAlpha(frame_buffer, game_name_sprite, 0, (frame_buffer.width - game_name_sprite.GetWidth()) / 2, 4);
+	DrawSprite(frame_buffer, SpriteId::kloster_unser_lieben_frauen_magdeburg, 0, 0);
+
+	const SpriteHandle game_name_sprite(SpriteId::game_name);
+	DrawSpriteWithAlpha(frame_buffer, game_name_sprite, (frame_buffer.width - game_name_sprite.GetWidth()) / 2, 4);
 
 	const uint32_t offset_x = 80;
 	const uint32_t offset_y = 96;
 	const uint32_t row_step = 3 * g_glyph_height;
 	const uint32_t cursor_offset = 3 * g_glyph_width;
 
-	const Color32 texts_color = g_cga_palette[11];
-	const Color32 cursor_color = g_cga_palette[10];
-	const Color32 shadow_color = g_cga_palette[0];
+	const ColorIndex texts_color = 11;
+	const ColorIndex cursor_color = 10;
+	const ColorIndex shadow_color = 0;
 	const bool draw_cursor = tick_ / 32 % 2 != 0;
 
 	const char* const selet_symbol = ">>";
@@ -242,6 +246,19 @@ void GameMainMenu::Draw(const FrameBuffer frame_buffer) const
 	}
 }
 
+void GameMainMenu::HashState(StateHasher& hasher) const
+{
+	hasher.Add(tick_, current_row_.index(), quit_triggered_);
+	if(const auto main_menu_row = std::get_if<MenuRow>(&current_row_))
+	{
+		hasher.Add(*main_menu_row);
+	}
+	if(const auto select_game_row = std::get_if<SelectGameMenuRow>(&current_row_))
+	{
+		hasher.Add(*select_game_row);
+	}
+}
+
 GameInterfacePtr GameMainMenu::AskForNextGameTransition()
 {
 	return std::move(next_game_);
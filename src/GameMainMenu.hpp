@@ -4,16 +4,18 @@
 #include "SoundPlayer.hpp"
 #include <variant>
 
+GameInterfacePtr CreateGameById(GameId id, SoundPlayer& sound_player);
+
 class GameMainMenu final : public GameInterface
 {
 public:
 	explicit GameMainMenu(SoundPlayer& sound_player);
 
-	virtual void Tick(
-		const std::vector<SDL_Event>& events,
-		const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
+
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual GameInterfacePtr AskForNextGameTransition() override;
 
@@ -4,9 +4,9 @@
 #include "GameMainMenu.hpp"
 #include "GamesDrawCommon.hpp"
 #include "Progress.hpp"
-#include "Sprites.hpp"
 #include "String.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <cassert>
 
 namespace
@@ -61,6 +61,9 @@ const fixed16_t g_laser_beam_speed = g_base_move_speed * 400 / 100;
 
 const fixed16_t g_character_half_size = g_fixed16_one + 1;
 
+// Characters move slower than one block per tick, so longer jumps are teleportations.
+const fixed16_t g_max_interpolation_distance = g_fixed16_one;
+
 const uint32_t g_frightened_mode_duration = GameInterface::c_update_frequency * 10;
 const uint32_t g_death_animation_duration = GameInterface::c_update_frequency * 3 / 2;
 const uint32_t g_spawn_animation_duration = GameInterface::c_update_frequency * 3;
@@ -93,22 +96,22 @@ const uint32_t g_transition_time_show_pacman_stats = g_transition_time_end_show_
 
 const uint32_t g_transition_time_change_end = g_transition_time_start_show_pacman_field;
 
-constexpr const SpriteBMP g_bonus_sprites[]
+constexpr const SpriteHandle g_bonus_sprites[]
 {
-	Sprites::pacman_food,
-	Sprites::pacman_food,
-	Sprites::pacman_bonus_deadly,
-	Sprites::tetris_block_small_4,
-	Sprites::tetris_block_small_7,
-	Sprites::tetris_block_small_5,
-	Sprites::tetris_block_small_1,
-	Sprites::tetris_block_small_2,
-	Sprites::tetris_block_small_6,
-	Sprites::tetris_block_small_3,
-	Sprites::snake_food_small,
-	Sprites::snake_food_medium,
-	Sprites::snake_food_large,
-	Sprites::snake_extra_life,
+	SpriteId::pacman_food,
+	SpriteId::pacman_food,
+	SpriteId::pacman_bonus_deadly,
+	SpriteId::tetris_block_small_4,
+	SpriteId::tetris_block_small_7,
+	SpriteId::tetris_block_small_5,
+	SpriteId::tetris_block_small_1,
+	SpriteId::tetris_block_small_2,
+	SpriteId::tetris_block_small_6,
+	SpriteId::tetris_block_small_3,
+	SpriteId::snake_food_small,
+	SpriteId::snake_food_medium,
+	SpriteId::snake_food_large,
+	SpriteId::snake_extra_life,
 };
 
 } // namespace
@@ -133,11 +136,13 @@ GamePacman::GamePacman(SoundPlayer& sound_player)
 		{{temp_snake_position_[0] + bonus_step * 4, temp_snake_position_[1]}, Bonus::SnakeFoodSmall});
 }
 
-void GamePacman::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GamePacman::Tick(const InputFrame& input)
 {
-	(void)keyboard_state;
+	TRACE_ZONE("GamePacman::Tick");
+
+	SavePrevPositions();
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && next_game_ == nullptr)
 		{
@@ -232,8 +237,10 @@ void GamePacman::Tick(const std::vector<SDL_Event>& events, const std::vector<bo
 	}
 }
 
-void GamePacman::Draw(const FrameBuffer frame_buffer) const
+void GamePacman::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
+	TRACE_ZONE("GamePacman::Draw");
+
 	static_assert(std::size(g_game_field) == c_field_width * c_field_height + 1, "Wrong field size");
 
 	FillWholeFrameBuffer(frame_buffer, g_color_black);
@@ -243,7 +250,7 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 		DrawSnakeStats(frame_buffer, 4, lives_, level_, score_);
 	}
 
-	const SpriteBMP snake_border_sprite( Sprites::snake_field_border);
+	const SpriteHandle snake_border_sprite( SpriteId::snake_field_border);
 	if(tick_ < g_transition_time_change_field_border)
 	{
 		for(uint32_t x = 0; x < frame_buffer.width / snake_border_sprite.GetWidth(); ++x)
@@ -295,11 +302,10 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 	{
 		for(const SnakeTransitionBonus& bonus : snake_transition_bonuses_)
 		{
-			const SpriteBMP sprite = g_bonus_sprites[uint32_t(bonus.type)];
+			const SpriteHandle sprite = g_bonus_sprites[uint32_t(bonus.type)];
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				uint32_t(Fixed16FloorToInt(bonus.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
 				uint32_t(Fixed16FloorToInt(bonus.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 		}
@@ -315,11 +321,10 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 				continue;
 			}
 
-			const SpriteBMP sprite = g_bonus_sprites[uint32_t(bonus)];
+			const SpriteHandle sprite = g_bonus_sprites[uint32_t(bonus)];
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				x * c_block_size + c_block_size / 2 - sprite.GetWidth () / 2,
 				y * c_block_size + c_block_size / 2 - sprite.GetHeight() / 2);
 		}
@@ -331,7 +336,7 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 		{
 			if(ghost.mode == GhostMode::Frightened || ghost.mode == GhostMode::Eaten)
 			{
-				DrawGhost(frame_buffer, ghost);
+				DrawGhost(frame_buffer, ghost, interpolation_alpha);
 			}
 		}
 	}
@@ -343,16 +348,16 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 		const uint32_t num_snake_segments = 4;
 		const uint32_t offset_x = uint32_t(Fixed16FloorToInt(temp_snake_position_[0] * int32_t(c_block_size))) - half_snake_segment_size - (num_snake_segments - 1) * snake_segment_size;
 		const uint32_t offset_y = uint32_t(Fixed16FloorToInt(temp_snake_position_[1] * int32_t(c_block_size))) - half_snake_segment_size;
-		DrawSpriteWithAlphaRotate270(frame_buffer, Sprites::snake_tail, 0, offset_x, offset_y);
+		DrawSpriteWithAlphaRotate270(frame_buffer, SpriteId::snake_tail, offset_x, offset_y);
 		for(uint32_t i = 1; i + 1 < num_snake_segments; ++i)
 		{
-			DrawSpriteWithAlphaRotate270(frame_buffer, Sprites::snake_body_segment, 0, offset_x + snake_segment_size * i, offset_y);
+			DrawSpriteWithAlphaRotate270(frame_buffer, SpriteId::snake_body_segment, offset_x + snake_segment_size * i, offset_y);
 		}
-		DrawSpriteWithAlphaRotate270(frame_buffer, Sprites::snake_head, 0, offset_x + snake_segment_size * (num_snake_segments - 1), offset_y);
+		DrawSpriteWithAlphaRotate270(frame_buffer, SpriteId::snake_head, offset_x + snake_segment_size * (num_snake_segments - 1), offset_y);
 	}
 	else
 	{
-		DrawPacman(frame_buffer);
+		DrawPacman(frame_buffer, interpolation_alpha);
 	}
 
 	if(tick_ >= g_transition_time_end_show_pacman_field)
@@ -361,47 +366,46 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 		{
 			if(!(ghost.mode == GhostMode::Frightened || ghost.mode == GhostMode::Eaten))
 			{
-				DrawGhost(frame_buffer, ghost);
+				DrawGhost(frame_buffer, ghost, interpolation_alpha);
 			}
 		}
 	}
 
 	for(const LaserBeam& laser_beam : laser_beams_)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_laser_beam);
+		const SpriteHandle sprite(SpriteId::arkanoid_laser_beam);
 		const uint32_t x = uint32_t(Fixed16FloorToInt(laser_beam.position[0] * int32_t(c_block_size)));
 		const uint32_t y = uint32_t(Fixed16FloorToInt(laser_beam.position[1] * int32_t(c_block_size)));
 		const uint32_t half_height = sprite.GetHeight() / 2;
 		switch(laser_beam.direction)
 		{
 		case GridDirection::XMinus:
-			DrawSpriteWithAlphaRotate270(frame_buffer, sprite, 0, x - half_height, y - 2);
-			DrawSpriteWithAlphaRotate270(frame_buffer, sprite, 0, x - half_height, y + 1);
+			DrawSpriteWithAlphaRotate270(frame_buffer, sprite, x - half_height, y - 2);
+			DrawSpriteWithAlphaRotate270(frame_buffer, sprite, x - half_height, y + 1);
 			break;
 		case GridDirection::XPlus:
-			DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, 0, x - half_height, y - 2);
-			DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, 0, x - half_height, y + 1);
+			DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, x - half_height, y - 2);
+			DrawSpriteWithAlphaRotate90 (frame_buffer, sprite, x - half_height, y + 1);
 			break;
 		case GridDirection::YMinus:
-			DrawSpriteWithAlphaRotate180(frame_buffer, sprite, 0, x - 2, y - half_height);
-			DrawSpriteWithAlphaRotate180(frame_buffer, sprite, 0, x + 1, y - half_height);
+			DrawSpriteWithAlphaRotate180(frame_buffer, sprite, x - 2, y - half_height);
+			DrawSpriteWithAlphaRotate180(frame_buffer, sprite, x + 1, y - half_height);
 			break;
 		case GridDirection::YPlus:
-			DrawSpriteWithAlpha         (frame_buffer, sprite, 0, x - 2, y - half_height);
-			DrawSpriteWithAlpha         (frame_buffer, sprite, 0, x + 1, y - half_height);
+			DrawSpriteWithAlpha         (frame_buffer, sprite, x - 2, y - half_height);
+			DrawSpriteWithAlpha         (frame_buffer, sprite, x + 1, y - half_height);
 			break;
 		}
 	}
 
 	if(tick_ >= g_transition_time_show_pacman_stats)
 	{
-		const SpriteBMP life_spirte(Sprites::pacman_life);
+		const SpriteHandle life_spirte(SpriteId::pacman_life);
 		for(uint32_t i = 0; i < lives_; ++i)
 		{
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				life_spirte,
-				0,
 				c_field_width * c_block_size - c_block_size / 2 + i % 4 * (life_spirte.GetWidth() + 2),
 				c_block_size * 2 + i / 4 * (life_spirte.GetHeight() + 3));
 		}
@@ -410,8 +414,8 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 		{
 			const uint32_t offset_x = c_field_width * c_block_size - c_block_size / 2 + i * 12;
 			const uint32_t offset_y = frame_buffer.height - 20;
-			DrawSpriteWithAlpha(frame_buffer, Sprites::arkanoid_laser_beam, 0, offset_x, offset_y);
-			DrawSpriteWithAlpha(frame_buffer, Sprites::arkanoid_laser_beam, 0, offset_x + 3, offset_y);
+			DrawSpriteWithAlpha(frame_buffer, SpriteId::arkanoid_laser_beam, offset_x, offset_y);
+			DrawSpriteWithAlpha(frame_buffer, SpriteId::arkanoid_laser_beam, offset_x + 3, offset_y);
 		}
 
 		const uint32_t texts_offset_x = c_field_width * c_block_size - c_block_size / 2;
@@ -419,17 +423,17 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 
 		char text[64];
 
-		DrawText(frame_buffer, g_cga_palette[10], texts_offset_x, texts_offset_y + 0 * g_glyph_height, Strings::pacman_level);
+		DrawText(frame_buffer, 10, texts_offset_x, texts_offset_y + 0 * g_glyph_height, Strings::pacman_level);
 
 		NumToString(text, sizeof(text), level_, 7);
 		DrawText(frame_buffer, g_color_white, texts_offset_x, texts_offset_y + 2 * g_glyph_height, text);
 
-		DrawText(frame_buffer, g_cga_palette[10], texts_offset_x, texts_offset_y + 5 * g_glyph_height, Strings::pacman_score);
+		DrawText(frame_buffer, 10, texts_offset_x, texts_offset_y + 5 * g_glyph_height, Strings::pacman_score);
 
 		NumToString(text, sizeof(text), score_, 7);
 		DrawText(frame_buffer, g_color_white, texts_offset_x, texts_offset_y + 7 * g_glyph_height, text);
 
-		const Color32 center_text_color = g_cga_palette[9 + tick_ / 16 % 7];
+		const ColorIndex center_text_color = ColorIndex(9 + tick_ / 16 % 7);
 		if(tick_ < spawn_animation_end_tick_)
 		{
 			DrawTextCentered(
@@ -454,7 +458,7 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 			{
 				DrawTextCentered(
 					frame_buffer,
-					g_cga_palette[14],
+					14,
 					c_field_width  * c_block_size / 2,
 					c_field_height * c_block_size / 2,
 					Strings::pacman_game_over);
@@ -463,6 +467,64 @@ void GamePacman::Draw(const FrameBuffer frame_buffer) const
 	}
 }
 
+void GamePacman::HashState(StateHasher& hasher) const
+{
+	hasher.Add(rand_.PeekNext(), tick_);
+
+	hasher.Add(
+		pacman_.position,
+		pacman_.direction,
+		pacman_.next_direction,
+		pacman_.target_position,
+		pacman_.dead_animation_end_tick,
+		pacman_.turret_shots_left,
+		pacman_.next_shoot_tick);
+	hasher.AddPresence(pacman_.arkanoid_ball);
+	if(pacman_.arkanoid_ball != std::nullopt)
+	{
+		hasher.Add(pacman_.arkanoid_ball->velocity, pacman_.arkanoid_ball->end_tick);
+	}
+
+	for(const Ghost& ghost : ghosts_)
+	{
+		hasher.Add(
+			ghost.type,
+			ghost.position,
+			ghost.direction,
+			ghost.target_position,
+			ghost.mode,
+			ghost.frightened_mode_end_tick);
+	}
+
+	hasher.Add(bonuses_);
+
+	hasher.AddSize(laser_beams_);
+	for(const LaserBeam& laser_beam : laser_beams_)
+	{
+		hasher.Add(laser_beam.position, laser_beam.direction);
+	}
+
+	hasher.Add(
+		spawn_animation_end_tick_,
+		level_end_animation_end_tick_,
+		bonuses_left_,
+		bonuses_eaten_,
+		level_,
+		lives_,
+		score_,
+		game_over_,
+		current_ghosts_mode_,
+		ghosts_mode_switches_left_,
+		next_ghosts_mode_swith_tick_,
+		temp_snake_position_);
+
+	hasher.AddSize(snake_transition_bonuses_);
+	for(const SnakeTransitionBonus& bonus : snake_transition_bonuses_)
+	{
+		hasher.Add(bonus.position, bonus.type);
+	}
+}
+
 GameInterfacePtr GamePacman::AskForNextGameTransition()
 {
 	return std::move(next_game_);
@@ -489,7 +551,17 @@ void GamePacman::DrawFieldAndBonuses(const FrameBuffer frame_buffer) const
 		y_end = std::min(c_field_height / 2 + y_delta, c_field_height);
 	}
 
-	DrawPacmanField(frame_buffer, g_game_field, c_field_width, c_field_height, x_start, y_start, x_end, y_end);
+	// Walls are constant, only visible area changes during transition.
+	StateHasher walls_hasher;
+	walls_hasher.Add(x_start, y_start, x_end, y_end);
+	walls_layer_.Draw(
+		frame_buffer,
+		walls_hasher.GetHash(),
+		[&](const FrameBuffer layer_frame_buffer)
+		{
+			DrawPacmanField(
+				layer_frame_buffer, g_game_field, c_field_width, c_field_height, x_start, y_start, x_end, y_end);
+		});
 
 	for(uint32_t y = y_start; y < y_end; ++y)
 	for(uint32_t x = x_start; x < x_end; ++x)
@@ -500,40 +572,41 @@ void GamePacman::DrawFieldAndBonuses(const FrameBuffer frame_buffer) const
 			continue;
 		}
 
-		const SpriteBMP sprite = g_bonus_sprites[uint32_t(bonus)];
+		const SpriteHandle sprite = g_bonus_sprites[uint32_t(bonus)];
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			x * c_block_size + c_block_size / 2 - sprite.GetWidth () / 2,
 			y * c_block_size + c_block_size / 2 - sprite.GetHeight() / 2);
 	}
 }
 
-void GamePacman::DrawPacman(const FrameBuffer frame_buffer) const
+void GamePacman::DrawPacman(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
+	const fixed16vec2_t position =
+		InterpolatePosition(pacman_.prev_position, pacman_.position, interpolation_alpha, g_max_interpolation_distance);
+
 	if(pacman_.arkanoid_ball != std::nullopt)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_ball);
+		const SpriteHandle sprite(SpriteId::arkanoid_ball);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
-			uint32_t(Fixed16FloorToInt(pacman_.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
-			uint32_t(Fixed16FloorToInt(pacman_.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
+			uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
+			uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 	}
 	else if(pacman_.dead_animation_end_tick != std::nullopt)
 	{
-		static constexpr const SpriteBMP sprites[]
+		static constexpr const SpriteHandle sprites[]
 		{
-			Sprites::pacman_0,
-			Sprites::pacman_1,
-			Sprites::pacman_2,
-			Sprites::pacman_3,
-			Sprites::pacman_4,
-			Sprites::pacman_5,
-			Sprites::pacman_6,
-			Sprites::pacman_7,
+			SpriteId::pacman_0,
+			SpriteId::pacman_1,
+			SpriteId::pacman_2,
+			SpriteId::pacman_3,
+			SpriteId::pacman_4,
+			SpriteId::pacman_5,
+			SpriteId::pacman_6,
+			SpriteId::pacman_7,
 		};
 
 		const uint32_t num_frames = uint32_t(std::size(sprites));
@@ -543,37 +616,37 @@ void GamePacman::DrawPacman(const FrameBuffer frame_buffer) const
 			num_frames /
 			g_death_animation_duration;
 
-		const SpriteBMP current_sprite = sprites[std::min(frame, num_frames - 1)];
+		const SpriteHandle current_sprite = sprites[std::min(frame, num_frames - 1)];
 		const uint32_t pacman_x =
-			uint32_t(Fixed16FloorToInt(pacman_.position[0] * int32_t(c_block_size))) - current_sprite.GetWidth () / 2;
+			uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - current_sprite.GetWidth () / 2;
 		const uint32_t pacman_y =
-			uint32_t(Fixed16FloorToInt(pacman_.position[1] * int32_t(c_block_size))) - current_sprite.GetHeight() / 2;
+			uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - current_sprite.GetHeight() / 2;
 		switch(pacman_.direction)
 		{
 		case GridDirection::XMinus:
-			DrawSpriteWithAlphaRotate180(frame_buffer, current_sprite, 0, pacman_x, pacman_y);
+			DrawSpriteWithAlphaRotate180(frame_buffer, current_sprite, pacman_x, pacman_y);
 			break;
 		case GridDirection::XPlus:
-			DrawSpriteWithAlpha         (frame_buffer, current_sprite, 0, pacman_x, pacman_y);
+			DrawSpriteWithAlpha         (frame_buffer, current_sprite, pacman_x, pacman_y);
 			break;
 		case GridDirection::YMinus:
-			DrawSpriteWithAlphaRotate270(frame_buffer, current_sprite, 0, pacman_x, pacman_y);
+			DrawSpriteWithAlphaRotate270(frame_buffer, current_sprite, pacman_x, pacman_y);
 			break;
 		case GridDirection::YPlus:
-			DrawSpriteWithAlphaRotate90 (frame_buffer, current_sprite, 0, pacman_x, pacman_y);
+			DrawSpriteWithAlphaRotate90 (frame_buffer, current_sprite, pacman_x, pacman_y);
 			break;
 		}
 	}
 	else
 	{
-		static constexpr const SpriteBMP sprites[]
+		static constexpr const SpriteHandle sprites[]
 		{
-			Sprites::pacman_0,
-			Sprites::pacman_1,
-			Sprites::pacman_2,
-			Sprites::pacman_3,
-			Sprites::pacman_2,
-			Sprites::pacman_1,
+			SpriteId::pacman_0,
+			SpriteId::pacman_1,
+			SpriteId::pacman_2,
+			SpriteId::pacman_3,
+			SpriteId::pacman_2,
+			SpriteId::pacman_1,
 		};
 
 		const uint32_t num_frames = uint32_t(std::size(sprites));
@@ -587,14 +660,14 @@ void GamePacman::DrawPacman(const FrameBuffer frame_buffer) const
 				(uint32_t(std::max(g_fixed16_one - dist, 0)) * num_frames) >> g_fixed16_base,
 				num_frames - 1);
 
-		const SpriteBMP current_sprite =
+		const SpriteHandle current_sprite =
 			tick_ < spawn_animation_end_tick_ ? sprites[1] : sprites[frame];
 		const uint32_t pacman_x =
-			uint32_t(Fixed16FloorToInt(pacman_.position[0] * int32_t(c_block_size))) - current_sprite.GetWidth() / 2;
+			uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - current_sprite.GetWidth() / 2;
 		const uint32_t pacman_y =
-			uint32_t(Fixed16FloorToInt(pacman_.position[1] * int32_t(c_block_size))) - current_sprite.GetHeight() / 2;
+			uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - current_sprite.GetHeight() / 2;
 
-		auto func = DrawSpriteWithAlpha;
+		SpriteWithAlphaDrawFunc func = DrawSpriteWithAlpha;
 		switch(pacman_.direction)
 		{
 		case GridDirection::XMinus:
@@ -613,23 +686,23 @@ void GamePacman::DrawPacman(const FrameBuffer frame_buffer) const
 
 		if(pacman_.turret_shots_left > 0)
 		{
-			func(frame_buffer, Sprites::pacman_turret, 0, pacman_x, pacman_y);
+			func(frame_buffer, SpriteId::pacman_turret, pacman_x, pacman_y);
 		}
-		func(frame_buffer, current_sprite, 0, pacman_x, pacman_y);
+		func(frame_buffer, current_sprite, pacman_x, pacman_y);
 	}
 }
 
-void GamePacman::DrawGhost(const FrameBuffer frame_buffer, const Ghost& ghost) const
+void GamePacman::DrawGhost(const FrameBuffer frame_buffer, const Ghost& ghost, const fixed16_t interpolation_alpha) const
 {
-	static constexpr const SpriteBMP sprites_dead[4]
+	static constexpr const SpriteHandle sprites_dead[4]
 	{
-		Sprites::pacman_ghost_dead_right,
-		Sprites::pacman_ghost_dead_left ,
-		Sprites::pacman_ghost_dead_down ,
-		Sprites::pacman_ghost_dead_up   ,
+		SpriteId::pacman_ghost_dead_right,
+		SpriteId::pacman_ghost_dead_left ,
+		SpriteId::pacman_ghost_dead_down ,
+		SpriteId::pacman_ghost_dead_up   ,
 	};
 
-	SpriteBMP sprite = GetPacmanGhostSprite(ghost.type, ghost.direction);
+	SpriteHandle sprite = GetPacmanGhostSprite(ghost.type, ghost.direction);
 	if(ghost.mode == GhostMode::Eaten)
 	{
 		sprite = sprites_dead[uint32_t(ghost.direction)];
@@ -642,17 +715,19 @@ void GamePacman::DrawGhost(const FrameBuffer frame_buffer, const Ghost& ghost) c
 			const uint32_t flicker_duration = 2 * GameInterface::c_update_frequency;
 			if(time_left >= flicker_duration || tick_ / 16 % 2 == 0)
 			{
-				sprite = Sprites::pacman_ghost_vulnerable;
+				sprite = SpriteId::pacman_ghost_vulnerable;
 			}
 		}
 	}
 
+	const fixed16vec2_t position =
+		InterpolatePosition(ghost.prev_position, ghost.position, interpolation_alpha, g_max_interpolation_distance);
+
 	DrawSpriteWithAlpha(
 		frame_buffer,
 		sprite,
-		0,
-		uint32_t(Fixed16FloorToInt(ghost.position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
-		uint32_t(Fixed16FloorToInt(ghost.position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
+		uint32_t(Fixed16FloorToInt(position[0] * int32_t(c_block_size))) - sprite.GetWidth () / 2,
+		uint32_t(Fixed16FloorToInt(position[1] * int32_t(c_block_size))) - sprite.GetHeight() / 2);
 }
 
 void GamePacman::EndLevel()
@@ -714,6 +789,7 @@ void GamePacman::SpawnPacmanAndGhosts()
 {
 	pacman_.target_position = {IntToFixed16(8) + g_fixed16_one / 2, IntToFixed16(12) + g_fixed16_one / 2};
 	pacman_.position = pacman_.target_position;
+	pacman_.prev_position = pacman_.position;
 	pacman_.direction = GridDirection::YPlus;
 	pacman_.next_direction = pacman_.direction;
 	pacman_.dead_animation_end_tick = std::nullopt;
@@ -745,6 +821,7 @@ void GamePacman::SpawnPacmanAndGhosts()
 				IntToFixed16(10 + int32_t(index_wrapped * 2)) + g_fixed16_one / 2};
 		}
 		ghost.position = ghost.target_position;
+		ghost.prev_position = ghost.position;
 
 		ghost.mode = current_ghosts_mode_;
 	}
@@ -752,6 +829,15 @@ void GamePacman::SpawnPacmanAndGhosts()
 	spawn_animation_end_tick_ = tick_ + g_spawn_animation_duration;
 }
 
+void GamePacman::SavePrevPositions()
+{
+	pacman_.prev_position = pacman_.position;
+	for(Ghost& ghost : ghosts_)
+	{
+		ghost.prev_position = ghost.position;
+	}
+}
+
 void GamePacman::ProcessShootRequest()
 {
 	if(pacman_.turret_shots_left == 0)
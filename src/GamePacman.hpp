@@ -2,6 +2,7 @@
 #include "GameInterface.hpp"
 #include "GamesCommon.hpp"
 #include "GamesDrawCommon.hpp"
+#include "LayerCache.hpp"
 #include "Fixed.hpp"
 #include "Rand.hpp"
 #include "SoundPlayer.hpp"
@@ -13,11 +14,11 @@ public:
 	GamePacman(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(
-		const std::vector<SDL_Event>& events,
-		const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual GameInterfacePtr AskForNextGameTransition() override;
 
@@ -31,6 +32,8 @@ private:
 	struct Pacman
 	{
 		fixed16vec2_t position{};
+		// Position on previous tick, used for drawing interpolation.
+		fixed16vec2_t prev_position{};
 		// Current moving direction.
 		GridDirection direction = GridDirection::XPlus;
 		GridDirection next_direction = GridDirection::XPlus;
@@ -58,6 +61,7 @@ private:
 	{
 		PacmanGhostType type = PacmanGhostType::Blinky;
 		fixed16vec2_t position{};
+		fixed16vec2_t prev_position{};
 		GridDirection direction = GridDirection::XPlus;
 		fixed16vec2_t target_position{};
 		GhostMode mode = GhostMode::Chase;
@@ -103,8 +107,10 @@ private:
 
 private:
 	void DrawFieldAndBonuses(FrameBuffer frame_buffer) const;
-	void DrawPacman(FrameBuffer frame_buffer) const;
-	void DrawGhost(FrameBuffer frame_buffer, const Ghost& ghost) const;
+	void DrawPacman(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const;
+	void DrawGhost(FrameBuffer frame_buffer, const Ghost& ghost, fixed16_t interpolation_alpha) const;
+
+	void SavePrevPositions();
 
 	void EndLevel();
 	void NextLevel();
@@ -165,4 +171,7 @@ private:
 	std::vector<SnakeTransitionBonus> snake_transition_bonuses_;
 
 	GameInterfacePtr next_game_;
+
+	// Cache of walls image, not a part of game state.
+	mutable LayerCache walls_layer_{LayerCache::Type::Transparent};
 };
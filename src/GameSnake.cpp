@@ -4,10 +4,10 @@
 #include "GamePacman.hpp"
 #include "GamesDrawCommon.hpp"
 #include "Progress.hpp"
-#include "SpriteBMP.hpp"
-#include "Sprites.hpp"
+#include "SpriteAtlas.hpp"
 #include "String.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <cassert>
 #include <cstring>
 
@@ -58,17 +58,17 @@ GameSnake::GameSnake(SoundPlayer& sound_player)
 	NextLevel();
 }
 
-void GameSnake::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameSnake::Tick(const InputFrame& input)
 {
-	(void) keyboard_state;
+	TRACE_ZONE("GameSnake::Tick");
 
 	if(tick_ < g_transition_time_snake_visual_change &&
 		field_start_animation_end_tick_ == std::nullopt && level_end_animation_end_tick_ == std::nullopt)
 	{
-		ManipulateSnakeAsTetrisPiece(events);
+		ManipulateSnakeAsTetrisPiece(input);
 	}
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && next_game_ == nullptr)
 		{
@@ -185,8 +185,12 @@ void GameSnake::Tick(const std::vector<SDL_Event>& events, const std::vector<boo
 	}
 }
 
-void GameSnake::Draw(const FrameBuffer frame_buffer) const
+void GameSnake::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
+	TRACE_ZONE("GameSnake::Draw");
+
+	(void)interpolation_alpha;
+
 	FillWholeFrameBuffer(frame_buffer, g_color_black);
 
 	const uint32_t field_offset_x = c_block_size;
@@ -204,10 +208,10 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 	}
 	else
 	{
-		const SpriteBMP border_sprite(
+		const SpriteHandle border_sprite(
 				tick_ >= g_transition_time_field_border_tile_change
-					? Sprites::snake_field_border
-					: Sprites::tetris_block_8);
+					? SpriteId::snake_field_border
+					: SpriteId::tetris_block_8);
 
 		for(uint32_t x = 0; x < c_field_width; ++x)
 		{
@@ -237,15 +241,15 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 		}
 	}
 
-	static constexpr const SpriteBMP tetris_blocks_sprites[g_tetris_num_piece_types]
+	static constexpr const SpriteHandle tetris_blocks_sprites[g_tetris_num_piece_types]
 	{
-		Sprites::tetris_block_4,
-		Sprites::tetris_block_7,
-		Sprites::tetris_block_5,
-		Sprites::tetris_block_1,
-		Sprites::tetris_block_2,
-		Sprites::tetris_block_6,
-		Sprites::tetris_block_3,
+		SpriteId::tetris_block_4,
+		SpriteId::tetris_block_7,
+		SpriteId::tetris_block_5,
+		SpriteId::tetris_block_1,
+		SpriteId::tetris_block_2,
+		SpriteId::tetris_block_6,
+		SpriteId::tetris_block_3,
 	};
 
 	DrawTetrisField(frame_buffer, field_offset_x, field_offset_y, tetris_field_, c_field_width, c_field_height);
@@ -260,7 +264,6 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 				DrawSpriteWithAlpha(
 					frame_buffer,
 					tetris_blocks_sprites[uint32_t(tetris_active_piece_->type) - 1],
-					0,
 					field_offset_x + uint32_t(piece_block[0]) * c_block_size,
 					uint32_t(int32_t(field_offset_y) + piece_block[1] * int32_t(c_block_size)));
 			}
@@ -269,12 +272,12 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 
 	if(tick_ >= g_transition_time_bonuses_show)
 	{
-		static constexpr const SpriteBMP bonus_sprites[]
+		static constexpr const SpriteHandle bonus_sprites[]
 		{
-			Sprites::snake_food_small,
-			Sprites::snake_food_medium,
-			Sprites::snake_food_large,
-			Sprites::snake_extra_life,
+			SpriteId::snake_food_small,
+			SpriteId::snake_food_medium,
+			SpriteId::snake_food_large,
+			SpriteId::snake_extra_life,
 		};
 
 		for(const Bonus& bonus : bonuses_)
@@ -282,7 +285,6 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				bonus_sprites[size_t(bonus.type)],
-				0,
 				field_offset_x + bonus.position[0] * c_block_size,
 				field_offset_y + bonus.position[1] * c_block_size);
 		}
@@ -294,7 +296,7 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 		{
 			DrawSprite(
 				frame_buffer,
-				Sprites::tetris_block_4,
+				SpriteId::tetris_block_4,
 				field_offset_x + segment.position[0] * c_block_size,
 				field_offset_y + segment.position[1] * c_block_size);
 		}
@@ -305,18 +307,18 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 		(death_animation_end_tick_ == std::nullopt || (tick_ / g_death_animation_flicker_duration) % 2 == 0) &&
 		tick_ >= g_transition_time_snake_visual_change)
 	{
-		const SpriteBMP head_sprite(Sprites::snake_head);
-		const SpriteBMP body_segment_sprite(Sprites::snake_body_segment);
-		const SpriteBMP body_segment_angle_sprite(Sprites::snake_body_segment_angle);
+		const SpriteHandle head_sprite(SpriteId::snake_head);
+		const SpriteHandle body_segment_sprite(SpriteId::snake_body_segment);
+		const SpriteHandle body_segment_angle_sprite(SpriteId::snake_body_segment_angle);
 
-		const SpriteBMP tail_sprite(Sprites::snake_tail);
+		const SpriteHandle tail_sprite(SpriteId::snake_tail);
 
 		for(size_t i = snake_->segments.size() - 1; ;)
 		{
 			const SnakeSegment& segment = snake_->segments[i];
 
-			SpriteBMP sprite = body_segment_sprite;
-			auto draw_fn = DrawSpriteWithAlpha;
+			SpriteHandle sprite = body_segment_sprite;
+			SpriteWithAlphaDrawFunc draw_fn = DrawSpriteWithAlpha;
 			int32_t sprite_offset_x = 0;
 			int32_t sprite_offset_y = 0;
 
@@ -448,7 +450,6 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 			draw_fn(
 				frame_buffer,
 				sprite,
-				0,
 				uint32_t(int32_t(field_offset_x + segment.position[0] * c_block_size) + sprite_offset_x),
 				uint32_t(int32_t(field_offset_y + segment.position[1] * c_block_size) + sprite_offset_y));
 
@@ -462,11 +463,10 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 
 	for(const ArkanoidBall& arkanoid_ball: arkanoid_balls_)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_ball);
+		const SpriteHandle sprite(SpriteId::arkanoid_ball);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			field_offset_x + uint32_t(Fixed16FloorToInt(int32_t(c_block_size) * arkanoid_ball.position[0])) - sprite.GetWidth () / 2,
 			field_offset_y + uint32_t(Fixed16FloorToInt(int32_t(c_block_size) * arkanoid_ball.position[1])) - sprite.GetHeight() / 2);
 	}
@@ -517,6 +517,50 @@ void GameSnake::Draw(const FrameBuffer frame_buffer) const
 	}
 }
 
+void GameSnake::HashState(StateHasher& hasher) const
+{
+	hasher.Add(rand_.PeekNext(), tick_);
+
+	hasher.AddPresence(snake_);
+	if(snake_ != std::nullopt)
+	{
+		hasher.AddSize(snake_->segments);
+		for(const SnakeSegment& segment : snake_->segments)
+		{
+			hasher.Add(segment.position);
+		}
+		hasher.Add(snake_->direction, snake_->grow_points_);
+	}
+
+	for(const Bonus& bonus : bonuses_)
+	{
+		hasher.Add(bonus.position, bonus.type);
+	}
+
+	hasher.Add(
+		death_animation_end_tick_,
+		field_start_animation_end_tick_,
+		level_end_animation_end_tick_,
+		lives_,
+		level_,
+		score_,
+		game_over_);
+
+	hasher.Add(tetris_field_);
+
+	hasher.AddPresence(tetris_active_piece_);
+	if(tetris_active_piece_ != std::nullopt)
+	{
+		hasher.Add(tetris_active_piece_->type, tetris_active_piece_->blocks);
+	}
+
+	hasher.AddSize(arkanoid_balls_);
+	for(const ArkanoidBall& arkanoid_ball : arkanoid_balls_)
+	{
+		hasher.Add(arkanoid_ball.position, arkanoid_ball.velocity, arkanoid_ball.bounces_left);
+	}
+}
+
 GameInterfacePtr GameSnake::AskForNextGameTransition()
 {
 	return std::move(next_game_);
@@ -748,7 +792,7 @@ void GameSnake::MoveSnakeAsTetrisPiece()
 	}
 }
 
-void GameSnake::ManipulateSnakeAsTetrisPiece(const std::vector<SDL_Event>& events)
+void GameSnake::ManipulateSnakeAsTetrisPiece(const InputFrame& input)
 {
 	if (snake_ == std::nullopt)
 	{
@@ -759,7 +803,7 @@ void GameSnake::ManipulateSnakeAsTetrisPiece(const std::vector<SDL_Event>& event
 	bool has_move_right = false;
 	bool has_move_down = false;
 	bool has_rotate = false;
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN)
 		{
@@ -13,11 +13,11 @@ public:
 	GameSnake(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(
-		const std::vector<SDL_Event>& events,
-		const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual GameInterfacePtr AskForNextGameTransition() override;
 
@@ -73,7 +73,7 @@ private:
 	void SpawnSnake();
 	void MoveSnake();
 	void MoveSnakeAsTetrisPiece();
-	void ManipulateSnakeAsTetrisPiece(const std::vector<SDL_Event>& events);
+	void ManipulateSnakeAsTetrisPiece(const InputFrame& input);
 	void OnSnakeDeath();
 	void MoveTetrisPieceDown();
 	// Returns true if need to kill it.
@@ -5,9 +5,9 @@
 #include "GameSnake.hpp"
 #include "GamesDrawCommon.hpp"
 #include "Progress.hpp"
-#include "Sprites.hpp"
-#include "SpriteBMP.hpp"
+#include "SpriteAtlas.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <cassert>
 
 namespace
@@ -141,8 +141,10 @@ GameTetris::GameTetris(SoundPlayer& sound_player)
 	};
 }
 
-void GameTetris::Tick(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameTetris::Tick(const InputFrame& input)
 {
+	TRACE_ZONE("GameTetris::Tick");
+
 	++tick_;
 
 	if(tick_ == level_end_animation_end_tick_)
@@ -159,21 +161,25 @@ void GameTetris::Tick(const std::vector<SDL_Event>& events, const std::vector<bo
 
 	if(tick_ >= level_end_animation_end_tick_)
 	{
-		ProcessLogic(events, keyboard_state);
+		ProcessLogic(input);
 	}
 }
 
-void GameTetris::Draw(const FrameBuffer frame_buffer) const
+void GameTetris::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
 {
-	static constexpr const SpriteBMP sprites[g_tetris_num_piece_types]
-	{
-		Sprites::tetris_block_4,
-		Sprites::tetris_block_7,
-		Sprites::tetris_block_5,
-		Sprites::tetris_block_1,
-		Sprites::tetris_block_2,
-		Sprites::tetris_block_6,
-		Sprites::tetris_block_3,
+	TRACE_ZONE("GameTetris::Draw");
+
+	(void)interpolation_alpha;
+
+	static constexpr const SpriteHandle sprites[g_tetris_num_piece_types]
+	{
+		SpriteId::tetris_block_4,
+		SpriteId::tetris_block_7,
+		SpriteId::tetris_block_5,
+		SpriteId::tetris_block_1,
+		SpriteId::tetris_block_2,
+		SpriteId::tetris_block_6,
+		SpriteId::tetris_block_3,
 	};
 
 	const uint32_t block_width  = sprites[0].GetWidth ();
@@ -206,7 +212,7 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 	}
 	else if(tick_ < g_transition_time_field_border_change)
 	{
-		const SpriteBMP border_sprite(Sprites::tetris_block_8);
+		const SpriteHandle border_sprite(SpriteId::tetris_block_8);
 		for(uint32_t x = 0; x < g_arkanoid_field_width * 2 + 2; ++x)
 		{
 			DrawSprite(
@@ -233,7 +239,13 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 	}
 	else
 	{
-		DrawTetrisFieldBorder(frame_buffer, laser_ship_is_active);
+		border_layer_.Draw(
+			frame_buffer,
+			laser_ship_is_active,
+			[&](const FrameBuffer layer_frame_buffer)
+			{
+				DrawTetrisFieldBorder(layer_frame_buffer, laser_ship_is_active);
+			});
 	}
 
 	if(tick_ >= g_transition_time_transform_blocks)
@@ -243,11 +255,10 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 
 	if(tick_ < g_transition_time_arkanoid_ship_disappear)
 	{
-		const SpriteBMP sprite = (Sprites::arkanoid_ship);
+		const SpriteHandle sprite = (SpriteId::arkanoid_ship);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			g_arkanoid_field_offset_x + uint32_t(Fixed16FloorToInt(temp_arkanoid_ship_.position[0])) - sprite.GetWidth () / 2,
 			g_arkanoid_field_offset_y + uint32_t(Fixed16FloorToInt(temp_arkanoid_ship_.position[1])) - sprite.GetHeight() / 2);
 	}
@@ -262,7 +273,6 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 				DrawSpriteWithAlpha(
 					frame_buffer,
 					sprites[uint32_t(active_piece_->type) - 1],
-					0,
 					field_offset_x + uint32_t(piece_block[0]) * block_width,
 					field_offset_y + uint32_t(piece_block[1]) * block_height);
 			}
@@ -270,8 +280,7 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 			{
 				DrawSpriteWithAlpha(
 					frame_buffer,
-					Sprites::tetris_block_shadow,
-					0,
+					SpriteId::tetris_block_shadow,
 					field_offset_x + uint32_t(piece_block[0]) * block_width,
 					field_offset_y + (c_field_height + 2) * block_height);
 			}
@@ -285,11 +294,10 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 				x_center_scaled += piece_block[0];
 			}
 
-			const SpriteBMP sprite(Sprites::arkanoid_ship_with_turrets);
+			const SpriteHandle sprite(SpriteId::arkanoid_ship_with_turrets);
 			DrawSpriteWithAlphaMirrorY(
 				frame_buffer,
 				sprite,
-				0,
 				field_offset_x + uint32_t(x_center_scaled) * block_width / 4 + block_width / 2 - sprite.GetWidth () / 2,
 				field_offset_y - sprite.GetHeight() / 2);
 		}
@@ -297,22 +305,21 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 
 	for(const LaserBeam& laser_beam : laser_beams_)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_laser_beam);
+		const SpriteHandle sprite(SpriteId::arkanoid_laser_beam);
 		DrawSpriteWithAlpha(
 			frame_buffer,
-			Sprites::arkanoid_laser_beam,
-			0,
+			SpriteId::arkanoid_laser_beam,
 			field_offset_x + uint32_t(Fixed16FloorToInt(laser_beam.position[0] * int32_t(block_width ))),
 			field_offset_y + uint32_t(Fixed16FloorToInt(laser_beam.position[1] * int32_t(block_height)))  - sprite.GetHeight() / 2);
 	}
 
-	static constexpr const SpriteBMP bonuses_sprites[]
+	static constexpr const SpriteHandle bonuses_sprites[]
 	{
-		Sprites::arkanoid_bonus_b,
-		Sprites::arkanoid_bonus_d,
-		Sprites::arkanoid_bonus_e,
-		Sprites::arkanoid_bonus_l,
-		Sprites::arkanoid_bonus_s,
+		SpriteId::arkanoid_bonus_b,
+		SpriteId::arkanoid_bonus_d,
+		SpriteId::arkanoid_bonus_e,
+		SpriteId::arkanoid_bonus_l,
+		SpriteId::arkanoid_bonus_s,
 	};
 
 	const bool playing_level_end_animation = tick_ < level_end_animation_end_tick_;
@@ -321,22 +328,20 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 	{
 		for(const Bonus& bonus : bonuses_)
 		{
-			const SpriteBMP sprite = bonuses_sprites[size_t(bonus.type)];
+			const SpriteHandle sprite = bonuses_sprites[size_t(bonus.type)];
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				field_offset_x + uint32_t(Fixed16FloorToInt(int32_t(block_width ) * bonus.position[0])) - sprite.GetWidth () / 2,
 				field_offset_y + uint32_t(Fixed16FloorToInt(int32_t(block_height) * bonus.position[1])) - sprite.GetHeight() / 2);
 		}
 
 		for(const ArkanoidBall& arkanoid_ball: arkanoid_balls_)
 		{
-			const SpriteBMP sprite(Sprites::arkanoid_ball);
+			const SpriteHandle sprite(SpriteId::arkanoid_ball);
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				field_offset_x + uint32_t(Fixed16FloorToInt(int32_t(block_width ) * arkanoid_ball.position[0])) - sprite.GetWidth () / 2,
 				field_offset_y + uint32_t(Fixed16FloorToInt(int32_t(block_height) * arkanoid_ball.position[1])) - sprite.GetHeight() / 2);
 		}
@@ -357,7 +362,7 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 	{
 		DrawTextCentered(
 			frame_buffer,
-			g_cga_palette[14],
+			14,
 			field_offset_x + block_width  * c_field_width  / 2,
 			field_offset_y + block_height * c_field_height / 2,
 			Strings::tetris_level_completed);
@@ -367,7 +372,7 @@ void GameTetris::Draw(const FrameBuffer frame_buffer) const
 	{
 		DrawTextCentered(
 			frame_buffer,
-			g_cga_palette[14],
+			14,
 			field_offset_x + block_width  * c_field_width  / 2,
 			field_offset_y + block_height * c_field_height / 2,
 			Strings::tetris_game_over);
@@ -379,28 +384,71 @@ bool GameTetris::NeedToCaptureMouse()
 	return tick_ < g_transition_time_arkanoid_ship_disappear;
 }
 
+void GameTetris::HashState(StateHasher& hasher) const
+{
+	hasher.Add(rand_.PeekNext(), tick_, score_, level_, lines_removed_for_this_level_, game_over_);
+
+	hasher.Add(field_);
+
+	hasher.AddPresence(active_piece_);
+	if(active_piece_ != std::nullopt)
+	{
+		hasher.Add(active_piece_->type, active_piece_->blocks);
+	}
+
+	hasher.Add(next_piece_type_, i_pieces_left_);
+
+	hasher.AddSize(arkanoid_balls_);
+	for(const ArkanoidBall& arkanoid_ball : arkanoid_balls_)
+	{
+		hasher.Add(arkanoid_ball.position, arkanoid_ball.velocity);
+	}
+
+	hasher.AddSize(bonuses_);
+	for(const Bonus& bonus : bonuses_)
+	{
+		hasher.Add(bonus.type, bonus.position);
+	}
+
+	hasher.AddSize(laser_beams_);
+	for(const LaserBeam& laser_beam : laser_beams_)
+	{
+		hasher.Add(laser_beam.position);
+	}
+
+	hasher.Add(
+		prev_bonus_type_,
+		slow_down_end_tick_,
+		laser_ship_end_tick_,
+		next_shoot_tick_,
+		end_level_triggered_,
+		level_end_animation_end_tick_,
+		pieces_spawnded_,
+		temp_arkanoid_ship_.position);
+}
+
 GameInterfacePtr GameTetris::AskForNextGameTransition()
 {
 	return std::move(next_game_);
 }
 
-void GameTetris::ProcessLogic(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state)
+void GameTetris::ProcessLogic(const InputFrame& input)
 {
 	if(tick_ >= g_transition_time_show_arkanoid_level_splash)
 	{
-		if(keyboard_state.size() > SDL_SCANCODE_LEFT  && keyboard_state[SDL_SCANCODE_LEFT ])
+		if(input.IsKeyPressed(SDL_SCANCODE_LEFT))
 		{
 			temp_arkanoid_ship_.position[0] -= g_arkanoid_ship_keyboard_move_sensetivity;
 			CorrectArkanoidShipPosition();
 		}
-		if(keyboard_state.size() > SDL_SCANCODE_RIGHT && keyboard_state[SDL_SCANCODE_RIGHT])
+		if(input.IsKeyPressed(SDL_SCANCODE_RIGHT))
 		{
 			temp_arkanoid_ship_.position[0] += g_arkanoid_ship_keyboard_move_sensetivity;
 			CorrectArkanoidShipPosition();
 		}
 	}
 
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_MOUSEMOTION && tick_ >= g_transition_time_show_arkanoid_level_splash)
 		{
@@ -428,7 +476,7 @@ void GameTetris::ProcessLogic(const std::vector<SDL_Event>& events, const std::v
 
 	if(tick_ >= g_transition_time_change_end)
 	{
-		ManipulatePiece(events);
+		ManipulatePiece(input);
 	}
 
 	uint32_t speed = GetSpeedForLevel(level_);
@@ -579,7 +627,7 @@ void GameTetris::ProcessShootRequest()
 	next_shoot_tick_ = tick_ + g_min_shoot_interval;
 }
 
-void GameTetris::ManipulatePiece(const std::vector<SDL_Event>& events)
+void GameTetris::ManipulatePiece(const InputFrame& input)
 {
 	if (active_piece_ == std::nullopt)
 	{
@@ -590,7 +638,7 @@ void GameTetris::ManipulatePiece(const std::vector<SDL_Event>& events)
 	bool has_move_right = false;
 	bool has_move_down = false;
 	bool has_rotate = false;
-	for(const SDL_Event& event : events)
+	for(const SDL_Event& event : input.GetEvents())
 	{
 		if(event.type == SDL_KEYDOWN)
 		{
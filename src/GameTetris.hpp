@@ -2,6 +2,7 @@
 #include "Fixed.hpp"
 #include "GameInterface.hpp"
 #include "GamesCommon.hpp"
+#include "LayerCache.hpp"
 #include "Rand.hpp"
 #include "SoundPlayer.hpp"
 #include <array>
@@ -13,11 +14,11 @@ public:
 	GameTetris(SoundPlayer& sound_player);
 
 public: // GameInterface
-	virtual void Tick(
-		const std::vector<SDL_Event>& events,
-		const std::vector<bool>& keyboard_state) override;
+	virtual void Tick(const InputFrame& input) override;
 
-	virtual void Draw(FrameBuffer frame_buffer) const override;
+	virtual void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const override;
+
+	virtual void HashState(StateHasher& hasher) const override;
 
 	virtual bool NeedToCaptureMouse() override;
 
@@ -67,11 +68,11 @@ private:
 	static const constexpr uint32_t c_arkanoid_ship_half_width = 16;
 
 private:
-	void ProcessLogic(const std::vector<SDL_Event>& events, const std::vector<bool>& keyboard_state);
+	void ProcessLogic(const InputFrame& input);
 	void EndLevel();
 	void NextLevel();
 	void ProcessShootRequest();
-	void ManipulatePiece(const std::vector<SDL_Event>& events);
+	void ManipulatePiece(const InputFrame& input);
 	void MovePieceDown();
 	void TryMoveWholeFieldDown();
 	void TryRemoveLines();
@@ -128,4 +129,7 @@ private:
 	ArkanoidShip temp_arkanoid_ship_;
 
 	GameInterfacePtr next_game_;
+
+	// Cache of field border image, not a part of game state.
+	mutable LayerCache border_layer_{LayerCache::Type::Transparent};
 };
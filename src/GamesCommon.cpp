@@ -26,6 +26,25 @@ ArkanoidBlockType GetArkanoidBlockTypeForLevelDataByte(const char level_data_byt
 
 } // namespace
 
+fixed16vec2_t InterpolatePosition(
+	const fixed16vec2_t& prev_position,
+	const fixed16vec2_t& position,
+	const fixed16_t alpha,
+	const fixed16_t max_distance)
+{
+	if( Fixed16Abs(position[0] - prev_position[0]) > max_distance ||
+		Fixed16Abs(position[1] - prev_position[1]) > max_distance)
+	{
+		return position;
+	}
+
+	return
+	{
+		Fixed16Lerp(prev_position[0], position[0], alpha),
+		Fixed16Lerp(prev_position[1], position[1], alpha),
+	};
+}
+
 void FillArkanoidField(ArkanoidBlock* const field, const char* field_data)
 {
 	for(uint32_t y = 0; y < g_arkanoid_field_height; ++y)
@@ -9,6 +9,14 @@ enum class GridDirection
 	YMinus,
 };
 
+// Position for drawing between previous and current ticks. "alpha" should be in range [0; 1].
+// Jumps longer than given distance (spawn, teleportation) are not interpolated.
+fixed16vec2_t InterpolatePosition(
+	const fixed16vec2_t& prev_position,
+	const fixed16vec2_t& position,
+	fixed16_t alpha,
+	fixed16_t max_distance);
+
 //
 // Arkanoid stuff
 //
@@ -1,7 +1,6 @@
 #include "GamesDrawCommon.hpp"
 #include "Draw.hpp"
-#include "Sprites.hpp"
-#include "SpriteBMP.hpp"
+#include "SpriteAtlas.hpp"
 #include "String.hpp"
 #include "Strings.hpp"
 #include <cassert>
@@ -9,42 +8,42 @@
 namespace
 {
 
-constexpr const SpriteBMP g_tetris_blocks[g_tetris_num_piece_types]
+constexpr const SpriteHandle g_tetris_blocks[g_tetris_num_piece_types]
 {
-	Sprites::tetris_block_4,
-	Sprites::tetris_block_7,
-	Sprites::tetris_block_5,
-	Sprites::tetris_block_1,
-	Sprites::tetris_block_2,
-	Sprites::tetris_block_6,
-	Sprites::tetris_block_3,
+	SpriteId::tetris_block_4,
+	SpriteId::tetris_block_7,
+	SpriteId::tetris_block_5,
+	SpriteId::tetris_block_1,
+	SpriteId::tetris_block_2,
+	SpriteId::tetris_block_6,
+	SpriteId::tetris_block_3,
 };
 
-constexpr const SpriteBMP g_pacman_ghost_sprites[4][4]
+constexpr const SpriteHandle g_pacman_ghost_sprites[4][4]
 {
 	{
-		Sprites::pacman_ghost_0_right,
-		Sprites::pacman_ghost_0_left ,
-		Sprites::pacman_ghost_0_down ,
-		Sprites::pacman_ghost_0_up   ,
+		SpriteId::pacman_ghost_0_right,
+		SpriteId::pacman_ghost_0_left ,
+		SpriteId::pacman_ghost_0_down ,
+		SpriteId::pacman_ghost_0_up   ,
 	},
 	{
-		Sprites::pacman_ghost_1_right,
-		Sprites::pacman_ghost_1_left ,
-		Sprites::pacman_ghost_1_down ,
-		Sprites::pacman_ghost_1_up   ,
+		SpriteId::pacman_ghost_1_right,
+		SpriteId::pacman_ghost_1_left ,
+		SpriteId::pacman_ghost_1_down ,
+		SpriteId::pacman_ghost_1_up   ,
 	},
 	{
-		Sprites::pacman_ghost_2_right,
-		Sprites::pacman_ghost_2_left ,
-		Sprites::pacman_ghost_2_down ,
-		Sprites::pacman_ghost_2_up   ,
+		SpriteId::pacman_ghost_2_right,
+		SpriteId::pacman_ghost_2_left ,
+		SpriteId::pacman_ghost_2_down ,
+		SpriteId::pacman_ghost_2_up   ,
 	},
 	{
-		Sprites::pacman_ghost_3_right,
-		Sprites::pacman_ghost_3_left ,
-		Sprites::pacman_ghost_3_down ,
-		Sprites::pacman_ghost_3_up   ,
+		SpriteId::pacman_ghost_3_right,
+		SpriteId::pacman_ghost_3_left ,
+		SpriteId::pacman_ghost_3_down ,
+		SpriteId::pacman_ghost_3_up   ,
 	},
 };
 
@@ -53,78 +52,75 @@ constexpr const SpriteBMP g_pacman_ghost_sprites[4][4]
 
 void DrawArkanoidFieldBorder(const FrameBuffer frame_buffer, const bool draw_exit)
 {
-	static constexpr const SpriteBMP sprites_trim_top[]
+	static constexpr const SpriteHandle sprites_trim_top[]
 	{
-		Sprites::arkanoid_trim_corner_top_left,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_1,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_1,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_1,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_1,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_segment_top_0,
-		Sprites::arkanoid_trim_corner_top_right,
+		SpriteId::arkanoid_trim_corner_top_left,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_1,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_1,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_1,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_1,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_segment_top_0,
+		SpriteId::arkanoid_trim_corner_top_right,
 	};
 
 	uint32_t trim_top_x = g_arkanoid_field_offset_x - 10;
-	for(const SpriteBMP& sprite : sprites_trim_top)
+	for(const SpriteHandle& sprite : sprites_trim_top)
 	{
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			trim_top_x,
 			g_arkanoid_field_offset_y - 10);
 
 		trim_top_x += sprite.GetWidth();
 	}
 
-	static constexpr const SpriteBMP sprites_trim_left[]
+	static constexpr const SpriteHandle sprites_trim_left[]
 	{
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_1,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_1,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_1,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_0,
-		Sprites::arkanoid_trim_segment_side_1,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_1,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_1,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_1,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_0,
+		SpriteId::arkanoid_trim_segment_side_1,
 	};
 
 	uint32_t trim_side_y = g_arkanoid_field_offset_y;
 	const uint32_t side_trim_offset_x = g_arkanoid_field_offset_x - 10;
-	for(const SpriteBMP& sprite : sprites_trim_left)
+	for(const SpriteHandle& sprite : sprites_trim_left)
 	{
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			side_trim_offset_x,
 			trim_side_y);
 
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			side_trim_offset_x + g_arkanoid_block_width * g_arkanoid_field_width + sprite.GetWidth(),
 			trim_side_y);
 
@@ -133,11 +129,10 @@ void DrawArkanoidFieldBorder(const FrameBuffer frame_buffer, const bool draw_exi
 
 	if(draw_exit)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_level_exit_gate);
+		const SpriteHandle sprite(SpriteId::arkanoid_level_exit_gate);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			side_trim_offset_x + g_arkanoid_block_width * g_arkanoid_field_width + sprite.GetWidth(),
 			trim_side_y);
 	}
@@ -145,11 +140,10 @@ void DrawArkanoidFieldBorder(const FrameBuffer frame_buffer, const bool draw_exi
 	// Draw two lover sprites of side trimming, including level exit.
 	for(size_t i = 0; i < 2; ++i)
 	{
-		const SpriteBMP sprite(Sprites::arkanoid_trim_segment_side_0);
+		const SpriteHandle sprite(SpriteId::arkanoid_trim_segment_side_0);
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			sprite,
-			0,
 			side_trim_offset_x,
 			trim_side_y);
 
@@ -158,7 +152,6 @@ void DrawArkanoidFieldBorder(const FrameBuffer frame_buffer, const bool draw_exi
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				sprite,
-				0,
 				side_trim_offset_x + g_arkanoid_block_width * g_arkanoid_field_width + sprite.GetWidth(),
 				trim_side_y);
 		}
@@ -181,25 +174,25 @@ void DrawArkanoidField(
 	assert(start_column <= end_column);
 	assert(end_column <= g_arkanoid_field_width);
 
-	static constexpr const SpriteBMP block_sprites[]
+	static constexpr const SpriteHandle block_sprites[]
 	{
-		Sprites::arkanoid_block_1,
-		Sprites::arkanoid_block_2,
-		Sprites::arkanoid_block_3,
-		Sprites::arkanoid_block_4,
-		Sprites::arkanoid_block_5,
-		Sprites::arkanoid_block_6,
-		Sprites::arkanoid_block_7,
-		Sprites::arkanoid_block_8,
-		Sprites::arkanoid_block_9,
-		Sprites::arkanoid_block_10,
-		Sprites::arkanoid_block_11,
-		Sprites::arkanoid_block_12,
-		Sprites::arkanoid_block_13,
-		Sprites::arkanoid_block_14,
-		Sprites::arkanoid_block_15,
-		Sprites::arkanoid_block_concrete,
-		Sprites::arkanoid_block_14_15,
+		SpriteId::arkanoid_block_1,
+		SpriteId::arkanoid_block_2,
+		SpriteId::arkanoid_block_3,
+		SpriteId::arkanoid_block_4,
+		SpriteId::arkanoid_block_5,
+		SpriteId::arkanoid_block_6,
+		SpriteId::arkanoid_block_7,
+		SpriteId::arkanoid_block_8,
+		SpriteId::arkanoid_block_9,
+		SpriteId::arkanoid_block_10,
+		SpriteId::arkanoid_block_11,
+		SpriteId::arkanoid_block_12,
+		SpriteId::arkanoid_block_13,
+		SpriteId::arkanoid_block_14,
+		SpriteId::arkanoid_block_15,
+		SpriteId::arkanoid_block_concrete,
+		SpriteId::arkanoid_block_14_15,
 	};
 
 	for(uint32_t y = 0; y < g_arkanoid_field_height; ++y)
@@ -214,7 +207,6 @@ void DrawArkanoidField(
 			DrawSpriteWithAlpha(
 				frame_buffer,
 				block_sprites[uint32_t(block.type) - 1],
-				0,
 				g_arkanoid_field_offset_x + x * g_arkanoid_block_width,
 				g_arkanoid_field_offset_y + y * g_arkanoid_block_height);
 		}
@@ -225,7 +217,7 @@ void DrawArkanoidLevelStartSplash(const FrameBuffer frame_buffer, const uint32_t
 {
 	DrawTextCentered(
 		frame_buffer,
-		g_cga_palette[9],
+		9,
 		g_arkanoid_field_offset_x + g_arkanoid_block_width  * g_arkanoid_field_width  / 2,
 		g_arkanoid_field_offset_y + g_arkanoid_block_height * (g_arkanoid_field_height - 6),
 		Strings::arkanoid_round);
@@ -249,7 +241,7 @@ void DrawArakoindStats(const FrameBuffer frame_buffer, const uint32_t level, con
 
 	DrawText(
 		frame_buffer,
-		g_cga_palette[9],
+		9,
 		texts_offset_x - g_glyph_width * uint32_t(UTF8StringLen(Strings::arkanoid_round)),
 		texts_offset_y,
 		Strings::arkanoid_round);
@@ -264,7 +256,7 @@ void DrawArakoindStats(const FrameBuffer frame_buffer, const uint32_t level, con
 
 	DrawText(
 		frame_buffer,
-		g_cga_palette[9],
+		9,
 		texts_offset_x - g_glyph_width * uint32_t(UTF8StringLen(Strings::arkanoid_score)),
 		texts_offset_y + g_glyph_height * 8,
 		Strings::arkanoid_score);
@@ -291,7 +283,7 @@ uint32_t GetTetrisFieldOffsetY(const FrameBuffer frame_buffer)
 
 void DrawTetrisFieldBorder(const FrameBuffer frame_buffer, const bool curt_upper_segments)
 {
-	const SpriteBMP border_sprite(Sprites::tetris_block_8);
+	const SpriteHandle border_sprite(SpriteId::tetris_block_8);
 
 	const uint32_t block_width  = border_sprite.GetWidth ();
 	const uint32_t block_height = border_sprite.GetHeight();
@@ -342,7 +334,7 @@ void DrawTetrisNextPiece(const FrameBuffer frame_buffer, const TetrisBlock next_
 	const uint8_t pieces_colors[g_tetris_num_piece_types]{ 4, 7, 5, 1, 2, 6, 3, };
 	DrawText(
 		frame_buffer,
-		g_cga_palette[pieces_colors[uint32_t(next_piece_index)]],
+		pieces_colors[uint32_t(next_piece_index)],
 		next_piece_offset_x + block_width * 4,
 		next_piece_offset_y - block_height * 6,
 		Strings::tetris_next);
@@ -352,7 +344,6 @@ void DrawTetrisNextPiece(const FrameBuffer frame_buffer, const TetrisBlock next_
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			g_tetris_blocks[next_piece_index],
-			0,
 			next_piece_offset_x + uint32_t(piece_block[0]) * block_width,
 			next_piece_offset_y + uint32_t(piece_block[1]) * block_height);
 	}
@@ -369,11 +360,11 @@ void DrawTetrisStats(const FrameBuffer frame_buffer, const uint32_t level, const
 	const uint32_t texts_offset_y = field_offset_y + block_height * g_tetris_field_height - g_glyph_height * 3;
 
 	char text[64];
-	DrawText(frame_buffer, g_cga_palette[14], texts_offset_x, texts_offset_y, Strings::tetris_level);
+	DrawText(frame_buffer, 14, texts_offset_x, texts_offset_y, Strings::tetris_level);
 	NumToString(text, sizeof(text), level, 4);
 	DrawText(frame_buffer, g_color_white, texts_offset_x + g_glyph_width * 6, texts_offset_y, text);
 
-	DrawText(frame_buffer, g_cga_palette[14], texts_offset_x, texts_offset_y + g_glyph_height * 2, Strings::tetris_score);
+	DrawText(frame_buffer, 14, texts_offset_x, texts_offset_y + g_glyph_height * 2, Strings::tetris_score);
 	NumToString(text, sizeof(text), score, 4);
 	DrawText(frame_buffer, g_color_white, texts_offset_x + g_glyph_width * 6, texts_offset_y + g_glyph_height * 2, text);
 }
@@ -401,7 +392,6 @@ void DrawTetrisField(
 		DrawSpriteWithAlpha(
 			frame_buffer,
 			g_tetris_blocks[uint32_t(block) - 1],
-			0,
 			offset_x + x * block_width,
 			offset_y + y * block_height);
 	}
@@ -427,7 +417,7 @@ void DrawSnakeStats(
 
 		DrawText(
 			frame_buffer,
-			g_cga_palette[stats_colors[i]],
+			stats_colors[i],
 			x - g_glyph_width * len,
 			frame_buffer.height - g_glyph_height * 2 - 3,
 			stats_names[i]);
@@ -452,8 +442,11 @@ void DrawPacmanField(
 	const uint32_t x_end,
 	const uint32_t y_end)
 {
+	// Pixels are written directly, so commands recording isn't supported.
+	assert(frame_buffer.command_buffer == nullptr);
+
 	const char c_wall_symbol = '#';
-	const Color32 c_wall_color = g_cga_palette[1];
+	const ColorIndex c_wall_color = 1;
 	for(uint32_t y = y_start; y < y_end; ++y)
 	{
 		const char* const line = field_data + y * field_width;
@@ -472,7 +465,7 @@ void DrawPacmanField(
 			const uint32_t block_y = y * g_pacman_block_size;
 			const auto set_pixel = [&](const uint32_t dx, const uint32_t dy)
 			{
-				frame_buffer.data[ (block_x + dx) + (block_y + dy) * frame_buffer.width] = c_wall_color;
+				frame_buffer.GetRow(block_y + dy)[block_x + dx] = c_wall_color;
 			};
 
 			const uint32_t x_minus_one_clamped = std::max(x, 1u) - 1;
@@ -620,7 +613,7 @@ void DrawPacmanField(
 	} // for y
 }
 
-SpriteBMP GetPacmanGhostSprite(const PacmanGhostType ghost_type, const GridDirection ghost_direction)
+SpriteHandle GetPacmanGhostSprite(const PacmanGhostType ghost_type, const GridDirection ghost_direction)
 {
 	return g_pacman_ghost_sprites[size_t(ghost_type)][size_t(ghost_direction)];
 }
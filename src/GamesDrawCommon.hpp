@@ -1,7 +1,7 @@
 #pragma once
 #include "FrameBuffer.hpp"
 #include "GamesCommon.hpp"
-#include "SpriteBMP.hpp"
+#include "SpriteAtlas.hpp"
 
 const constexpr uint32_t g_arkanoid_field_offset_x = 10;
 const constexpr uint32_t g_arkanoid_field_offset_y = 10;
@@ -45,4 +45,4 @@ void DrawPacmanField(
 	uint32_t x_end,
 	uint32_t y_end);
 
-SpriteBMP GetPacmanGhostSprite(PacmanGhostType ghost_type, GridDirection ghost_direction);
+SpriteHandle GetPacmanGhostSprite(PacmanGhostType ghost_type, GridDirection ghost_direction);
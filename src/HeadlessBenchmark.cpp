@@ -0,0 +1,386 @@
+#include "HeadlessBenchmark.hpp"
+#include "FrameWriter.hpp"
+#include "Host.hpp"
+#include "PlatformHeadless.hpp"
+#include "Replay.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+struct GameName
+{
+	GameId id;
+	const char* name;
+};
+
+const GameName g_benchmark_games[]
+{
+	{GameId::Arkanoid, "arkanoid"},
+	{GameId::Tetris, "tetris"},
+	{GameId::Snake, "snake"},
+	{GameId::Pacman, "pacman"},
+	{GameId::BattleCity, "battle_city"},
+};
+
+const uint32_t g_default_num_ticks = 60 * GameInterface::c_update_frequency;
+
+enum class DrawMode
+{
+	Immediate,
+	Deferred,
+	// Run game with immediate and deferred drawing and compare frames.
+	Compare,
+};
+
+const GameName* FindGame(const char* const name)
+{
+	for(const GameName& game : g_benchmark_games)
+	{
+		if(std::strcmp(name, game.name) == 0)
+		{
+			return &game;
+		}
+	}
+	return nullptr;
+}
+
+// Setup of run with random input. Each run with same seed is reproducible.
+ReplayHeader MakeRandomInputSetup(const GameId game_id, const Rand::RandResultType input_seed)
+{
+	ReplayHeader setup;
+	setup.seed = input_seed;
+	setup.sample_rate = PlatformHeadless::c_default_sample_rate;
+	setup.start_game = game_id;
+	return setup;
+}
+
+// Host on headless platform. Seed and progress from setup are applied before game creation, like in replay playback.
+std::unique_ptr<Host> CreateHeadlessHost(
+	InputSourceInterfacePtr input_source,
+	const ReplayHeader& setup,
+	const bool deferred_drawing,
+	PlatformHeadless*& out_platform)
+{
+	Rand::SetDeterministicSeed(setup.seed);
+	UseInMemoryProgress(setup.progress);
+
+	auto platform = std::make_unique<PlatformHeadless>(std::move(input_source), setup.sample_rate);
+	out_platform = platform.get();
+	auto host = std::make_unique<Host>(std::move(platform), setup.start_game);
+	if(deferred_drawing)
+	{
+		host->EnableDeferredDrawing(WorkerPool::GetDefaultNumThreads());
+	}
+	return host;
+}
+
+// Hashes of all frames are written if output vector isn't null.
+void RunGame(
+	const GameName& game,
+	const uint32_t num_ticks,
+	const Rand::RandResultType input_seed,
+	const bool deferred_drawing,
+	std::vector<StateHasher::HashType>* const out_frame_hashes)
+{
+	PlatformHeadless* platform = nullptr;
+	const std::unique_ptr<Host> host =
+		CreateHeadlessHost(
+			std::make_unique<RandomInputSource>(input_seed),
+			MakeRandomInputSetup(game.id, input_seed),
+			deferred_drawing,
+			platform);
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	uint32_t num_performed_ticks = 0;
+	while(num_performed_ticks < num_ticks)
+	{
+		++num_performed_ticks;
+		if(host->Loop())
+		{
+			break;
+		}
+
+		if(out_frame_hashes != nullptr)
+		{
+			out_frame_hashes->push_back(CalculateFrameHash(platform->GetLastFrame()));
+		}
+	}
+
+	const double duration_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+	std::printf(
+		"%-12s %-9s %8u ticks in %8.3f s: %10.1f ticks/s, %8.2f us/tick\n",
+		game.name,
+		deferred_drawing ? "deferred" : "immediate",
+		num_performed_ticks,
+		duration_s,
+		double(num_performed_ticks) / duration_s,
+		duration_s * 1.0e6 / double(num_performed_ticks));
+}
+
+// Returns true if frames are equal.
+bool CompareDrawModes(const GameName& game, const uint32_t num_ticks, const Rand::RandResultType input_seed)
+{
+	std::vector<StateHasher::HashType> immediate_hashes, deferred_hashes;
+	RunGame(game, num_ticks, input_seed, false, &immediate_hashes);
+	RunGame(game, num_ticks, input_seed, true, &deferred_hashes);
+
+	for(size_t i = 0; i < std::min(immediate_hashes.size(), deferred_hashes.size()); ++i)
+	{
+		if(immediate_hashes[i] != deferred_hashes[i])
+		{
+			std::fprintf(stderr, "%s: deferred drawing result differs from immediate drawing at frame %zu\n", game.name, i);
+			return false;
+		}
+	}
+
+	if(immediate_hashes.size() != deferred_hashes.size())
+	{
+		std::fprintf(stderr, "%s: different number of frames with deferred drawing\n", game.name);
+		return false;
+	}
+
+	return true;
+}
+
+bool EndsWith(const char* const str, const char* const suffix)
+{
+	const size_t str_length = std::strlen(str);
+	const size_t suffix_length = std::strlen(suffix);
+	return str_length >= suffix_length && std::strcmp(str + str_length - suffix_length, suffix) == 0;
+}
+
+} // namespace
+
+int RunHeadlessBenchmark(const int argc, const char* const* const argv)
+{
+	const char* const game_name = argc >= 1 ? argv[0] : "all";
+	const uint32_t num_ticks = argc >= 2 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : g_default_num_ticks;
+	const auto input_seed = Rand::RandResultType(argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 0);
+
+	DrawMode draw_mode = DrawMode::Immediate;
+	if(argc >= 4)
+	{
+		if(std::strcmp(argv[3], "immediate") == 0)
+		{
+			draw_mode = DrawMode::Immediate;
+		}
+		else if(std::strcmp(argv[3], "deferred") == 0)
+		{
+			draw_mode = DrawMode::Deferred;
+		}
+		else if(std::strcmp(argv[3], "compare") == 0)
+		{
+			draw_mode = DrawMode::Compare;
+		}
+		else
+		{
+			std::fprintf(stderr, "Unknown draw mode \"%s\", expected \"immediate\", \"deferred\" or \"compare\"\n", argv[3]);
+			return 1;
+		}
+	}
+
+	const bool run_all_games = std::strcmp(game_name, "all") == 0;
+	const GameName* const single_game = run_all_games ? nullptr : FindGame(game_name);
+	if(!run_all_games && single_game == nullptr)
+	{
+		std::fprintf(stderr, "Unknown game \"%s\"\n", game_name);
+		return 1;
+	}
+
+	bool all_results_are_equal = true;
+	for(const GameName& game : g_benchmark_games)
+	{
+		if(single_game != nullptr && single_game != &game)
+		{
+			continue;
+		}
+
+		if(draw_mode == DrawMode::Compare)
+		{
+			all_results_are_equal &= CompareDrawModes(game, num_ticks, input_seed);
+		}
+		else
+		{
+			RunGame(game, num_ticks, input_seed, draw_mode == DrawMode::Deferred, nullptr);
+		}
+	}
+
+	return all_results_are_equal ? 0 : 1;
+}
+
+int RunFrameRendering(int argc, const char* const* argv)
+{
+	if(argc < 4)
+	{
+		std::fprintf(stderr, "Expected game name, number of ticks, input seed or \"--replay\" with replay file and output file name\n");
+		return 1;
+	}
+
+	const char* const game_name = argv[0];
+	const uint32_t num_ticks = uint32_t(std::strtoul(argv[1], nullptr, 10));
+
+	// Input is either random with given seed or is read from replay.
+	InputSourceInterfacePtr input_source;
+	const ReplayInputSource* replay = nullptr;
+	ReplayHeader setup;
+	if(std::strcmp(argv[2], "--replay") == 0)
+	{
+		if(argc < 5)
+		{
+			std::fprintf(stderr, "Expected replay file and output file name\n");
+			return 1;
+		}
+
+		auto replay_input_source = std::make_unique<ReplayInputSource>(argv[3]);
+		if(!replay_input_source->IsValid())
+		{
+			std::fprintf(stderr, "Can't load replay \"%s\"\n", argv[3]);
+			return 1;
+		}
+
+		// Replays recorded normally start in main menu.
+		const std::optional<GameId> start_game = replay_input_source->GetHeader().start_game;
+		const GameName* const game = FindGame(game_name);
+		const bool game_matches =
+			start_game == std::nullopt
+				? std::strcmp(game_name, "menu") == 0
+				: game != nullptr && game->id == *start_game;
+		if(!game_matches)
+		{
+			std::fprintf(stderr, "Replay \"%s\" doesn't start with \"%s\"\n", argv[3], game_name);
+			return 1;
+		}
+
+		setup = replay_input_source->GetHeader();
+		replay = replay_input_source.get();
+		input_source = std::move(replay_input_source);
+
+		// Skip replay file name, so that other arguments are at the same positions as with seed.
+		--argc;
+		++argv;
+	}
+	else
+	{
+		const GameName* const game = FindGame(game_name);
+		if(game == nullptr)
+		{
+			std::fprintf(stderr, "Unknown game \"%s\"\n", game_name);
+			return 1;
+		}
+
+		const auto input_seed = Rand::RandResultType(std::strtoul(argv[2], nullptr, 10));
+		setup = MakeRandomInputSetup(game->id, input_seed);
+		input_source = std::make_unique<RandomInputSource>(input_seed);
+	}
+
+	const char* const file_name = argv[3];
+
+	FrameFileFormat format = EndsWith(file_name, ".y4m") ? FrameFileFormat::Y4M : FrameFileFormat::RawIndices;
+	if(argc >= 5)
+	{
+		if(std::strcmp(argv[4], "raw") == 0)
+		{
+			format = FrameFileFormat::RawIndices;
+		}
+		else if(std::strcmp(argv[4], "y4m") == 0)
+		{
+			format = FrameFileFormat::Y4M;
+		}
+		else
+		{
+			std::fprintf(stderr, "Unknown format \"%s\", expected \"raw\" or \"y4m\"\n", argv[4]);
+			return 1;
+		}
+	}
+
+	bool deferred_drawing = false;
+	if(argc >= 6)
+	{
+		if(std::strcmp(argv[5], "immediate") == 0)
+		{
+			deferred_drawing = false;
+		}
+		else if(std::strcmp(argv[5], "deferred") == 0)
+		{
+			deferred_drawing = true;
+		}
+		else
+		{
+			std::fprintf(stderr, "Unknown draw mode \"%s\", expected \"immediate\" or \"deferred\"\n", argv[5]);
+			return 1;
+		}
+	}
+
+	PlatformHeadless* platform = nullptr;
+	const std::unique_ptr<Host> host = CreateHeadlessHost(std::move(input_source), setup, deferred_drawing, platform);
+
+	FrameWriter frame_writer(file_name, format, g_framebuffer_width, g_framebuffer_height, GameInterface::c_update_frequency);
+	if(!frame_writer.IsOpen())
+	{
+		std::fprintf(stderr, "Can't open \"%s\"\n", file_name);
+		return 1;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	uint32_t num_frames = 0;
+	uint64_t total_draw_duration_ns = 0;
+	uint64_t max_draw_duration_ns = 0;
+	while(num_frames < num_ticks && (replay == nullptr || !replay->IsFinished()))
+	{
+		if(host->Loop())
+		{
+			break;
+		}
+		++num_frames;
+
+		total_draw_duration_ns += host->GetLastDrawDurationNs();
+		max_draw_duration_ns = std::max(max_draw_duration_ns, host->GetLastDrawDurationNs());
+
+		frame_writer.AddFrame(platform->GetLastFrame());
+	}
+
+	const double simulation_duration_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+
+	FrameWriter::Stats stats;
+	const bool write_ok = frame_writer.Finish(stats);
+	const double duration_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+
+	std::printf(
+		"%s: %u frames in %8.3f s: %10.1f frames/s (%.1f frames/s before writer finished)\n",
+		game_name,
+		num_frames,
+		duration_s,
+		double(num_frames) / duration_s,
+		double(num_frames) / simulation_duration_s);
+	std::printf(
+		"draw %8.2f us/frame average, %8.2f us max\n",
+		double(total_draw_duration_ns) * 1.0e-3 / double(std::max(num_frames, 1u)),
+		double(max_draw_duration_ns) * 1.0e-3);
+	std::printf(
+		"%" PRIu64 " bytes written to \"%s\", %" PRIu64 " stalls on full queue (%.3f s total), frames hash %016" PRIx64 "\n",
+		stats.num_bytes,
+		file_name,
+		stats.num_stalls,
+		double(stats.stalls_duration_ns) * 1.0e-9,
+		stats.frames_hash);
+
+	if(!write_ok)
+	{
+		std::fprintf(stderr, "Error writing \"%s\"\n", file_name);
+		return 1;
+	}
+
+	return 0;
+}
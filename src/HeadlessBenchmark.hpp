@@ -0,0 +1,15 @@
+#pragma once
+
+// Run games on headless platform as fast as possible and print throughput.
+// Arguments: [game name or "all"] [number of ticks] [input seed] [draw mode: "immediate", "deferred" or "compare"].
+// Compare mode runs each game with both draw modes and checks that frames are identical.
+int RunHeadlessBenchmark(int argc, const char* const* argv);
+
+// Run game on headless platform as fast as possible and write each frame into file in background thread.
+// Prints achieved frame rate, drawing time and hash of all frames, which may be used for regression checks.
+// Arguments: <game name> <number of ticks> <input seed> <output file> [format: "raw" or "y4m"] [draw mode: "immediate" or "deferred"].
+// Instead of seed "--replay <replay file>" may be given in order to render recorded play-through.
+// Game name must match start of replay - "menu" for replays, which start in main menu, like ones made by "--record".
+// Rendering stops at replay end.
+// Default format is "y4m" for files with ".y4m" extension and "raw" (palette indices) otherwise.
+int RunFrameRendering(int argc, const char* const* argv);
@@ -1,126 +1,426 @@
 #include "Host.hpp"
 #include "Draw.hpp"
 #include "GameMainMenu.hpp"
+#include "SPSCQueue.hpp"
 #include "SoundsGeneration.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
+#include "TripleBuffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <thread>
 
-Host::Host()
-	: system_window_()
-	, sound_out_()
+namespace
+{
+
+uint64_t GetDurationNs(const std::chrono::steady_clock::time_point start_time)
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
+}
+
+} // namespace
+
+struct Host::ThreadedState
+{
+	// Rendering thread -> simulation thread.
+	// Events are dropped if simulation thread is stalled for a long time and the queue is full.
+	// Quit event isn't passed via queue - rendering thread sets quit flag directly.
+	SPSCQueue<SDL_Event, 1024> events;
+	TripleBuffer<InputFrame::KeyboardState> keyboard_state;
+
+	// Simulation thread -> rendering thread.
+	TripleBuffer<RenderSnapshot> snapshots{
+		RenderSnapshot{std::vector<ColorIndex>(g_framebuffer_width * g_framebuffer_height, 0), false}};
+
+	std::atomic<bool> quit{false};
+};
+
+Host::Host(PlatformInterfacePtr platform, const std::optional<GameId> start_game)
+	: platform_(std::move(platform))
+	, sound_out_(platform_->GetSoundOut())
 	, sound_player_(sound_out_)
 	, init_time_(Clock::now())
 	, prev_tick_time_(GetCurrentTime())
-	, game_(std::make_unique<GameMainMenu>(sound_player_))
+	, game_(
+		start_game == std::nullopt
+			? std::make_unique<GameMainMenu>(sound_player_)
+			: CreateGameById(*start_game, sound_player_))
 {
-	sound_player_.PlayMusic(MusicId::HerrMannelig);
+	// Decode all sprites now, not on first frame.
+	SpriteAtlas::GetInstance();
+
+	if(start_game == std::nullopt)
+	{
+		sound_player_.PlayMusic(MusicId::HerrMannelig);
+	}
 }
 
 bool Host::Loop()
 {
+	TRACE_ZONE("Host::Loop");
+
+	const bool is_real_time = platform_->IsRealTime();
 	const auto tick_start_time = GetCurrentTime();
 
+	uint64_t physics_start_tick = prev_tick_time_ * GameInterface::c_update_frequency / c_time_point_resolution;
+	uint64_t physics_end_tick = tick_start_time * GameInterface::c_update_frequency / c_time_point_resolution;
+	if(!is_real_time)
+	{
+		// Perform exactly one tick for each frame.
+		physics_start_tick = num_virtual_ticks_;
+		physics_end_tick = num_virtual_ticks_ + 1;
+	}
+
 	// Perform some ticks. Possible 0, 1 or many. But do not perform more than 5 ticks at once.
-	for (
-		uint64_t
-			physics_start_tick = prev_tick_time_ * GameInterface::c_update_frequency / c_time_point_resolution,
-			physics_end_tick = tick_start_time * GameInterface::c_update_frequency / c_time_point_resolution,
-			t = physics_start_tick,
-			iterations= 0;
-		game_ != nullptr && t < physics_end_tick && iterations < 5;
-		++t, ++iterations)
-	{
-		const auto events = system_window_.GetEvents();
-		const auto keyboard_state = system_window_.GetKeyboardState();
-
-		for(const SDL_Event& event : events)
+	// Skip remaining ticks in order to avoid spiral of death if simulation can't keep up.
+	const uint64_t num_ticks = physics_end_tick - physics_start_tick;
+	const uint64_t num_ticks_to_perform = std::min(num_ticks, c_max_ticks_per_frame);
+	for(uint64_t i = 0; i < num_ticks_to_perform; ++i)
+	{
+		platform_->GetInput(input_);
+		ProcessDebugKeys(input_);
+
+		const Clock::time_point tick_start_time = Clock::now();
+		if(Tick(input_))
+		{
+			return true;
+		}
+		perf_hud_.AddPhaseTime(PerfPhase::Tick, GetDurationNs(tick_start_time));
+
+		platform_->SetRelativeMouseMode(NeedToCaptureMouse());
+	} // For game logic iterations.
+
+	platform_->BeginFrame();
+	const FrameBuffer frame_buffer = platform_->GetFrameBuffer();
+
+	const Clock::time_point draw_start_time = Clock::now();
+	// Draw exactly last tick state if time isn't real, in order to make output deterministic.
+	Draw(frame_buffer, is_real_time ? GetInterpolationAlpha(tick_start_time) : g_fixed16_one);
+	last_draw_duration_ns_ = GetDurationNs(draw_start_time);
+	perf_hud_.AddPhaseTime(PerfPhase::Draw, last_draw_duration_ns_);
+
+	PresentFrame(frame_buffer, uint32_t(num_ticks_to_perform));
+
+	if(is_real_time)
+	{
+		RegisterTicks(num_ticks_to_perform, num_ticks - num_ticks_to_perform);
+		pacer_.WaitNextFrame();
+	}
+	else
+	{
+		++num_virtual_ticks_;
+	}
+
+	prev_tick_time_ = tick_start_time;
+
+	return false;
+}
+
+void Host::RunThreaded()
+{
+	ThreadedState state;
+	std::thread simulation_thread([&]{ SimulationThreadFunc(state); });
+
+	// Platform functions are called only from this thread, since window and events handling isn't thread-safe.
+	// Simulation thread uses only sound output, which is thread-safe.
+	while(!state.quit.load(std::memory_order_acquire))
+	{
+		platform_->GetInput(input_);
+		bool events_dropped = false;
+		for(const SDL_Event& event : input_.GetEvents())
 		{
 			if(event.type == SDL_QUIT)
 			{
-				return true;
+				// Quit is handled here, so it can't be lost in full queue.
+				state.quit.store(true, std::memory_order_release);
 			}
-			if(event.type == SDL_KEYDOWN)
+			else
 			{
-				if(event.key.keysym.scancode == SDL_SCANCODE_LEFTBRACKET)
-				{
-					sound_out_.DecreaseVolume();
-				}
-				if(event.key.keysym.scancode == SDL_SCANCODE_RIGHTBRACKET)
-				{
-					sound_out_.IncreaseVolume();
-				}
-				if(event.key.keysym.scancode == SDL_SCANCODE_PAUSE)
-				{
-					paused_ = !paused_;
-				}
-				if(event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && paused_)
-				{
-					paused_ = false;
-				}
+				events_dropped |= !state.events.Push(event);
 			}
 		}
-
-		if(game_->AskForQuit())
+		if(events_dropped)
 		{
-			return true;
+			std::fprintf(stderr, "Simulation can't keep up with input, dropping events\n");
 		}
-		if(auto next_game = game_->AskForNextGameTransition())
+		ProcessDebugKeys(input_);
+
+		state.keyboard_state.GetWriteBuffer() = input_.GetKeyboardState();
+		state.keyboard_state.Publish();
+
+		if(!state.snapshots.Update())
 		{
-			game_ = std::move(next_game);
-			sound_out_.StopPlaying();
+			// Nothing to present - give some time to simulation.
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
 		}
 
-		SDL_SetRelativeMouseMode((!paused_ && game_->NeedToCaptureMouse()) ? SDL_TRUE : SDL_FALSE);
+		RenderSnapshot& snapshot = state.snapshots.GetReadBuffer();
+		platform_->SetRelativeMouseMode(snapshot.capture_mouse);
+
+		// Snapshot is presented directly. Its buffer belongs to this thread until next update,
+		// so HUD may be drawn over it - simulation thread redraws whole frame anyway.
+		platform_->BeginFrame();
+		const FrameBuffer frame_buffer =
+			MakeFrameBuffer(snapshot.frame_buffer_data.data(), g_framebuffer_width, g_framebuffer_height);
+
+		perf_hud_.AddPhaseTime(PerfPhase::Tick, snapshot.tick_duration_ns);
+		perf_hud_.AddPhaseTime(PerfPhase::Draw, snapshot.draw_duration_ns);
+		PresentFrame(frame_buffer, snapshot.num_ticks);
+	}
+
+	simulation_thread.join();
+}
+
+void Host::SetMaxFPS(const uint32_t max_fps)
+{
+	pacer_.SetMaxFPS(max_fps);
+}
+
+void Host::EnableDeferredDrawing(const uint32_t num_threads)
+{
+	draw_command_buffer_ = std::make_unique<DrawCommandBuffer>();
+	draw_worker_pool_ = std::make_unique<WorkerPool>(num_threads);
+}
+
+FramePacer::Stats Host::GetPacingStats() const
+{
+	return pacer_.GetStats();
+}
 
-		if(!paused_)
+void Host::StartRecording(ReplayWriter& replay_writer)
+{
+	replay_writer_ = &replay_writer;
+}
+
+StateHasher::HashType Host::CalculateStateHash() const
+{
+	StateHasher hasher;
+	hasher.Add(paused_);
+	if(game_ != nullptr)
+	{
+		game_->HashState(hasher);
+	}
+
+	return hasher.GetHash();
+}
+
+bool Host::Tick(const InputFrame& input)
+{
+	if(replay_writer_ != nullptr)
+	{
+		replay_writer_->WriteTickInput(input);
+	}
+
+	for(const SDL_Event& event : input.GetEvents())
+	{
+		if(event.type == SDL_QUIT)
 		{
-			game_->Tick(events, keyboard_state);
+			return true;
 		}
-	} // For game logic iterations.
+		if(event.type == SDL_KEYDOWN)
+		{
+			if(event.key.keysym.scancode == SDL_SCANCODE_LEFTBRACKET)
+			{
+				sound_out_.DecreaseVolume();
+			}
+			if(event.key.keysym.scancode == SDL_SCANCODE_RIGHTBRACKET)
+			{
+				sound_out_.IncreaseVolume();
+			}
+			if(event.key.keysym.scancode == SDL_SCANCODE_PAUSE)
+			{
+				paused_ = !paused_;
+			}
+			if(event.key.keysym.scancode == SDL_SCANCODE_ESCAPE && paused_)
+			{
+				paused_ = false;
+			}
+		}
+	}
+
+	if(game_->AskForQuit())
+	{
+		return true;
+	}
+	if(auto next_game = game_->AskForNextGameTransition())
+	{
+		game_ = std::move(next_game);
+		sound_out_.StopPlaying();
+	}
+
+	if(!paused_)
+	{
+		game_->Tick(input);
+	}
 
-	system_window_.BeginFrame();
+	if(replay_writer_ != nullptr && replay_writer_->NeedStateHash())
+	{
+		replay_writer_->WriteStateHash(CalculateStateHash());
+	}
 
-	const FrameBuffer frame_buffer = system_window_.GetFrameBuffer();
+	return false;
+}
+
+void Host::Draw(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha)
+{
+	if(draw_command_buffer_ == nullptr)
+	{
+		DrawScene(frame_buffer, interpolation_alpha);
+		return;
+	}
+
+	DrawScene(draw_command_buffer_->BeginRecording(frame_buffer), interpolation_alpha);
+	draw_command_buffer_->Execute(*draw_worker_pool_);
+}
+
+void Host::DrawScene(const FrameBuffer frame_buffer, const fixed16_t interpolation_alpha) const
+{
 	if(game_ != nullptr)
 	{
-		game_->Draw(frame_buffer);
+		// Objects are not moving in pause, so draw them exactly at current positions.
+		game_->Draw(frame_buffer, paused_ ? g_fixed16_one : interpolation_alpha);
 	}
 
 	if(paused_)
 	{
 		const uint8_t colors[2] = {8, 15};
-		const uint32_t index = prev_tick_time_ / 300 % 2;
+		const uint32_t index = uint32_t(prev_tick_time_ / (c_time_point_resolution * 3 / 10) % 2); // Blink each 300 ms.
 
 		DrawTextCenteredWithOutline(
 			frame_buffer,
-			g_cga_palette[colors[index]],
-			g_cga_palette[colors[index ^ 1]],
+			colors[index],
+			colors[index ^ 1],
 			frame_buffer.width  / 2,
 			frame_buffer.height / 2,
 			Strings::paused);
 	}
+}
+
+bool Host::NeedToCaptureMouse()
+{
+	return !paused_ && game_ != nullptr && game_->NeedToCaptureMouse();
+}
+
+void Host::SimulationThreadFunc(ThreadedState& state)
+{
+	TRACE_THREAD_NAME("Simulation");
+
+	InputFrame input;
+
+	while(!state.quit.load(std::memory_order_acquire))
+	{
+		TRACE_ZONE("Host::SimulationFrame");
+
+		const auto tick_start_time = GetCurrentTime();
+
+		const uint64_t physics_start_tick = prev_tick_time_ * GameInterface::c_update_frequency / c_time_point_resolution;
+		const uint64_t physics_end_tick = tick_start_time * GameInterface::c_update_frequency / c_time_point_resolution;
+
+		// Perform some ticks. Possible 0, 1 or many. But do not perform more than 5 ticks at once.
+		const uint64_t num_ticks = physics_end_tick - physics_start_tick;
+		const uint64_t num_ticks_to_perform = std::min(num_ticks, c_max_ticks_per_frame);
+		const Clock::time_point ticks_start_time = Clock::now();
+		for(uint64_t i = 0; i < num_ticks_to_perform; ++i)
+		{
+			// Events which don't fit into input of this tick stay in queue for next ticks.
+			input.Clear();
+			SDL_Event event;
+			while(!input.IsFull() && state.events.Pop(event))
+			{
+				input.AddEvent(event);
+			}
+
+			state.keyboard_state.Update();
+			input.GetKeyboardState() = state.keyboard_state.GetReadBuffer();
+			if(Tick(input))
+			{
+				state.quit.store(true, std::memory_order_release);
+				return;
+			}
+		}
+		const uint64_t tick_duration_ns = GetDurationNs(ticks_start_time);
+
+		// Draw even if no ticks were performed, since moving objects are interpolated between ticks.
+		RenderSnapshot& snapshot = state.snapshots.GetWriteBuffer();
+
+		const FrameBuffer frame_buffer =
+			MakeFrameBuffer(snapshot.frame_buffer_data.data(), g_framebuffer_width, g_framebuffer_height);
+
+		const Clock::time_point draw_start_time = Clock::now();
+		Draw(frame_buffer, GetInterpolationAlpha(tick_start_time));
+
+		snapshot.capture_mouse = NeedToCaptureMouse();
+		snapshot.num_ticks = uint32_t(num_ticks_to_perform);
+		snapshot.tick_duration_ns = tick_duration_ns;
+		snapshot.draw_duration_ns = GetDurationNs(draw_start_time);
+		state.snapshots.Publish();
+
+		RegisterTicks(num_ticks_to_perform, num_ticks - num_ticks_to_perform);
+		prev_tick_time_ = tick_start_time;
+
+		pacer_.WaitNextFrame();
+	}
+}
 
-	system_window_.EndFrame();
+void Host::ProcessDebugKeys(const InputFrame& input)
+{
+	for(const SDL_Event& event : input.GetEvents())
+	{
+		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_F3)
+		{
+			show_perf_hud_ = !show_perf_hud_;
+		}
+		if(event.type == SDL_KEYDOWN && event.key.keysym.scancode == SDL_SCANCODE_F4)
+		{
+			TRACE_INSTANT("Trace dump");
+			TRACE_DUMP(c_trace_file_name);
+		}
+	}
+}
 
-	const TimePoint tick_end_time = GetCurrentTime();
-	const auto frame_dt = tick_end_time - tick_start_time;
+void Host::PresentFrame(const FrameBuffer frame_buffer, const uint32_t num_ticks)
+{
+	TRACE_ZONE("Host::PresentFrame");
+	TRACE_COUNTER("Ticks per frame", num_ticks);
 
-	const uint64_t max_fps = 120;
-	const auto min_frame_duration = c_time_point_resolution / max_fps;
-	if(frame_dt <= min_frame_duration)
+	if(show_perf_hud_)
 	{
-		std::this_thread::sleep_for(ChronoDuration(min_frame_duration - frame_dt));
+		perf_hud_.Draw(frame_buffer);
 	}
 
-	prev_tick_time_ = tick_start_time;
+	platform_->EndFrame(frame_buffer);
 
-	return false;
+	const EndFrameTimings timings = platform_->GetLastEndFrameTimings();
+	perf_hud_.AddPhaseTime(PerfPhase::PostProcess, timings.post_process_ns);
+	perf_hud_.AddPhaseTime(PerfPhase::Present, timings.present_ns);
+	perf_hud_.EndFrame(num_ticks);
+}
+
+void Host::RegisterTicks(const uint64_t num_performed, const uint64_t num_dropped)
+{
+	if(pacer_.RegisterTicks(num_performed, num_dropped))
+	{
+		std::fprintf(stderr, "Simulation can't keep up with real time, dropping ticks\n");
+	}
 }
 
 Host::TimePoint Host::GetCurrentTime()
 {
+	if(!platform_->IsRealTime())
+	{
+		return num_virtual_ticks_ * c_time_point_resolution / GameInterface::c_update_frequency;
+	}
+
 	const Clock::time_point now = Clock::now();
 	const auto dt = now - init_time_;
 
 	return TimePoint(std::chrono::duration_cast<ChronoDuration>(dt).count());
 }
+
+fixed16_t Host::GetInterpolationAlpha(const TimePoint time)
+{
+	const uint64_t tick_fraction = time * GameInterface::c_update_frequency % c_time_point_resolution;
+	return fixed16_t(tick_fraction * uint64_t(g_fixed16_one) / c_time_point_resolution);
+}
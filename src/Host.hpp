@@ -1,37 +1,119 @@
 #pragma once
+#include "DrawCommandBuffer.hpp"
+#include "FramePacer.hpp"
 #include "GameInterface.hpp"
-#include "SoundOut.hpp"
+#include "PerfHUD.hpp"
+#include "PlatformInterface.hpp"
+#include "Progress.hpp"
+#include "Replay.hpp"
 #include "SoundPlayer.hpp"
-#include "SystemWindow.hpp"
+#include "WorkerPool.hpp"
 #include <chrono>
+#include <optional>
 
 
 class Host
 {
 public:
-	Host();
+	// Starts with main menu if no start game is specified.
+	explicit Host(PlatformInterfacePtr platform, std::optional<GameId> start_game = std::nullopt);
 
-	// Returns false on quit
+	// Returns true on quit
 	bool Loop();
 
+	// Run simulation in separate thread, draw and present frames in calling thread. Returns on quit.
+	// Simulation thread owns game state and publishes drawn frames via lock-free triple buffer,
+	// so slow presentation doesn't delay input handling and simulation.
+	// Requires real time platform.
+	void RunThreaded();
+
+	// Trace is dumped here on exit and by hotkey.
+	static constexpr const char* c_trace_file_name = "trace.json";
+
+	// Zero FPS means no limit. Ticks frequency isn't affected.
+	void SetMaxFPS(uint32_t max_fps);
+
+	// Record drawing commands of each frame and rasterize them in screen tiles,
+	// split between drawing thread and given number of worker threads. Result is identical to immediate drawing.
+	void EnableDeferredDrawing(uint32_t num_threads);
+
+	// Should be called from thread running simulation.
+	FramePacer::Stats GetPacingStats() const;
+
+	// Write input of all following ticks and periodic state hashes. Writer must outlive the host.
+	void StartRecording(ReplayWriter& replay_writer);
+
+	StateHasher::HashType CalculateStateHash() const;
+
+	// Duration of drawing of last frame by "Loop".
+	uint64_t GetLastDrawDurationNs() const { return last_draw_duration_ns_; }
+
 private:
 	using TimePoint = uint64_t;
-	using ChronoDuration= std::chrono::milliseconds;
+	using ChronoDuration= std::chrono::nanoseconds;
 	static constexpr const uint64_t c_time_point_resolution= ChronoDuration::period::den; // time points in seconds
+	static constexpr const uint64_t c_max_ticks_per_frame = 5;
 
 	using Clock= std::chrono::steady_clock;
 
+	// Immutable result of simulation, passed to rendering thread.
+	struct RenderSnapshot
+	{
+		std::vector<ColorIndex> frame_buffer_data;
+		bool capture_mouse = false;
+		// Timings for performance HUD.
+		uint32_t num_ticks = 0;
+		uint64_t tick_duration_ns = 0;
+		uint64_t draw_duration_ns = 0;
+	};
+
+	struct ThreadedState;
+
 private:
+	// Process single tick. Returns true on quit.
+	bool Tick(const InputFrame& input);
+	void Draw(FrameBuffer frame_buffer, fixed16_t interpolation_alpha);
+	void DrawScene(FrameBuffer frame_buffer, fixed16_t interpolation_alpha) const;
+	bool NeedToCaptureMouse();
+	void RegisterTicks(uint64_t num_performed, uint64_t num_dropped);
+
+	// F3 - toggle performance HUD, F4 - dump trace (if tracing is enabled).
+	void ProcessDebugKeys(const InputFrame& input);
+	// Draw HUD over given frame, present it and finish HUD frame.
+	void PresentFrame(FrameBuffer frame_buffer, uint32_t num_ticks);
+
+	void SimulationThreadFunc(ThreadedState& state);
+
 	TimePoint GetCurrentTime();
 
+	// Fraction of time passed since last tick, in range [0; 1).
+	static fixed16_t GetInterpolationAlpha(TimePoint time);
+
 private:
-	SystemWindow system_window_;
-	SoundOut sound_out_;
+	const PlatformInterfacePtr platform_;
+	// Sound output is thread-safe, so simulation thread uses it directly, without platform.
+	SoundOut& sound_out_;
 	SoundPlayer sound_player_;
 
 	const Clock::time_point init_time_;
 	TimePoint prev_tick_time_;
+	// Used instead of real time for platforms without real time.
+	uint64_t num_virtual_ticks_ = 0;
+	FramePacer pacer_;
 
 	GameInterfacePtr game_ = nullptr;
 	bool paused_ = false;
+
+	// Used only by thread drawing frames. Null if drawing is immediate.
+	std::unique_ptr<DrawCommandBuffer> draw_command_buffer_;
+	std::unique_ptr<WorkerPool> draw_worker_pool_;
+
+	// Used only by thread presenting frames.
+	// Reused between frames in order to avoid allocations.
+	InputFrame input_;
+	PerfHUD perf_hud_;
+	bool show_perf_hud_ = false;
+	uint64_t last_draw_duration_ns_ = 0;
+
+	ReplayWriter* replay_writer_ = nullptr;
 };
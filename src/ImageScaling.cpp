@@ -0,0 +1,470 @@
+#include "ImageScaling.hpp"
+#include "SIMD.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+
+using CopyImageFunc =
+	void(*)(
+		const ColorIndex* src,
+		uint32_t src_width,
+		uint32_t src_height,
+		uint32_t src_stride,
+		const Color32* palette,
+		Color32* dst,
+		uint32_t dst_stride);
+using WidenRowFunc = void(*)(const ColorIndex* src, uint32_t src_width, const Color32* palette, Color32* dst);
+
+using CopyImageFuncs = CopyImageFunc[g_max_image_scale];
+
+template<uint32_t scale>
+void CopyImageWithScaleScalar(
+	const ColorIndex* src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const Color32* const palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	for(uint32_t y = 0; y < src_height; ++y)
+	{
+		const ColorIndex* const src_line = src + y * src_stride;
+		Color32* dst_start_line = dst + y * scale * dst_stride;
+		for(uint32_t x = 0; x < src_width; ++x)
+		{
+			const Color32 c = palette[src_line[x]];
+			Color32* const dst_span_sart = dst_start_line + x * scale;
+			for(uint32_t dy = 0; dy < scale; ++dy)
+			{
+				Color32* const dst_line = dst_span_sart + dy * dst_stride;
+				for(uint32_t dx = 0; dx < scale; ++dx)
+				{
+					dst_line[dx] = c;
+				}
+			}
+		}
+	}
+}
+
+// Used for row tails, which are too short for vector kernels.
+template<uint32_t scale>
+void WidenRowScalar(const ColorIndex* const src, const uint32_t src_width, const Color32* const palette, Color32* const dst)
+{
+	for(uint32_t x = 0; x < src_width; ++x)
+	{
+		const Color32 c = palette[src[x]];
+		for(uint32_t dx = 0; dx < scale; ++dx)
+		{
+			dst[x * scale + dx] = c;
+		}
+	}
+}
+
+// Widen only first destination row for each source row, than copy it into other rows.
+template<uint32_t scale, WidenRowFunc widen_row>
+void CopyImageWithScaleRows(
+	const ColorIndex* src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const Color32* const palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	const uint32_t dst_width = src_width * scale;
+	for(uint32_t y = 0; y < src_height; ++y)
+	{
+		Color32* const dst_line = dst + y * scale * dst_stride;
+		widen_row(src + y * src_stride, src_width, palette, dst_line);
+		for(uint32_t dy = 1; dy < scale; ++dy)
+		{
+			std::memcpy(dst_line + dy * dst_stride, dst_line, dst_width * sizeof(Color32));
+		}
+	}
+}
+
+#ifdef SIMD_X86
+
+// Shuffle mask for "_mm_shuffle_epi32" selecting source pixels of k-th output vector.
+template<uint32_t scale, uint32_t k>
+constexpr int c_widen_shuffle_mask_sse2 = int(
+	(((4 * k + 0) / scale) << 0) |
+	(((4 * k + 1) / scale) << 2) |
+	(((4 * k + 2) / scale) << 4) |
+	(((4 * k + 3) / scale) << 6));
+
+template<uint32_t scale, uint32_t... k>
+TARGET_SSE2 inline void StoreWidenedSSE2(const __m128i v, Color32* const dst, std::integer_sequence<uint32_t, k...>)
+{
+	(_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * k), _mm_shuffle_epi32(v, (c_widen_shuffle_mask_sse2<scale, k>))), ...);
+}
+
+// SSE2 has no gather, so colors are looked up by scalar loads.
+TARGET_SSE2 inline __m128i LoadColorsSSE2(const ColorIndex* const src, const Color32* const palette)
+{
+	return _mm_setr_epi32(int(palette[src[0]]), int(palette[src[1]]), int(palette[src[2]]), int(palette[src[3]]));
+}
+
+template<uint32_t scale>
+TARGET_SSE2 void WidenRowSSE2(const ColorIndex* const src, const uint32_t src_width, const Color32* const palette, Color32* const dst)
+{
+	uint32_t x = 0;
+	for(; x + 4 <= src_width; x += 4)
+	{
+		const __m128i v = LoadColorsSSE2(src + x, palette);
+		StoreWidenedSSE2<scale>(v, dst + x * scale, std::make_integer_sequence<uint32_t, scale>());
+	}
+	WidenRowScalar<scale>(src + x, src_width - x, palette, dst + x * scale);
+}
+
+// Permutation for "_mm256_permutevar8x32_epi32" selecting source pixels of k-th output vector.
+template<uint32_t scale, uint32_t k>
+TARGET_AVX2 inline __m256i GetWidenPermutationAVX2()
+{
+	return _mm256_setr_epi32(
+		int((8 * k + 0) / scale),
+		int((8 * k + 1) / scale),
+		int((8 * k + 2) / scale),
+		int((8 * k + 3) / scale),
+		int((8 * k + 4) / scale),
+		int((8 * k + 5) / scale),
+		int((8 * k + 6) / scale),
+		int((8 * k + 7) / scale));
+}
+
+template<uint32_t scale, uint32_t... k>
+TARGET_AVX2 inline void StoreWidenedAVX2(const __m256i v, Color32* const dst, std::integer_sequence<uint32_t, k...>)
+{
+	(_mm256_storeu_si256(
+		reinterpret_cast<__m256i*>(dst + 8 * k),
+		_mm256_permutevar8x32_epi32(v, GetWidenPermutationAVX2<scale, k>())), ...);
+}
+
+// Load 8 indices and gather their colors.
+TARGET_AVX2 inline __m256i LoadColorsAVX2(const ColorIndex* const src, const Color32* const palette)
+{
+	const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+	return _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), indices, 4);
+}
+
+template<uint32_t scale>
+TARGET_AVX2 void WidenRowAVX2(const ColorIndex* const src, const uint32_t src_width, const Color32* const palette, Color32* const dst)
+{
+	uint32_t x = 0;
+	for(; x + 8 <= src_width; x += 8)
+	{
+		const __m256i v = LoadColorsAVX2(src + x, palette);
+		StoreWidenedAVX2<scale>(v, dst + x * scale, std::make_integer_sequence<uint32_t, scale>());
+	}
+	WidenRowScalar<scale>(src + x, src_width - x, palette, dst + x * scale);
+}
+
+TARGET_SSE2 void StreamRow(const Color32* const src, const uint32_t size, Color32* const dst)
+{
+	uint32_t x = 0;
+	for(; x < size && (reinterpret_cast<uintptr_t>(dst + x) & 15) != 0; ++x)
+	{
+		dst[x] = src[x];
+	}
+	for(; x + 4 <= size; x += 4)
+	{
+		_mm_stream_si128(reinterpret_cast<__m128i*>(dst + x), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)));
+	}
+	for(; x < size; ++x)
+	{
+		dst[x] = src[x];
+	}
+}
+
+// Widen source rows by small chunks, which stay in cache, and write them into all destination rows with non-temporal stores.
+template<uint32_t scale, WidenRowFunc widen_row>
+TARGET_SSE2 void CopyImageWithScaleRowsNonTemporal(
+	const ColorIndex* src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const Color32* const palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	constexpr uint32_t c_chunk_size = 64;
+	Color32 chunk[c_chunk_size * scale];
+
+	for(uint32_t y = 0; y < src_height; ++y)
+	{
+		for(uint32_t x = 0; x < src_width; x += c_chunk_size)
+		{
+			const uint32_t chunk_width = std::min(c_chunk_size, src_width - x);
+			widen_row(src + y * src_stride + x, chunk_width, palette, chunk);
+			for(uint32_t dy = 0; dy < scale; ++dy)
+			{
+				StreamRow(chunk, chunk_width * scale, dst + (y * scale + dy) * dst_stride + x * scale);
+			}
+		}
+	}
+
+	// Make non-temporal stores visible for other threads.
+	_mm_sfence();
+}
+
+#ifdef _MSC_VER
+
+bool CPUSupportsSSE2()
+{
+	int info[4]{};
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+}
+
+bool CPUSupportsAVX2()
+{
+	int info[4]{};
+	__cpuid(info, 0);
+	if(info[0] < 7)
+	{
+		return false;
+	}
+
+	__cpuid(info, 1);
+	const bool has_avx = (info[2] & (1 << 28)) != 0;
+	// Check also that OS saves YMM registers.
+	const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	if(!(has_avx && has_osxsave && (_xgetbv(0) & 6) == 6))
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+#else
+
+bool CPUSupportsSSE2()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+}
+
+bool CPUSupportsAVX2()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+// Table for "vqtbl1q_u8" selecting bytes of source pixels of k-th output vector.
+template<uint32_t scale, uint32_t k, size_t... i>
+inline uint8x16_t GetWidenTableNEON(std::index_sequence<i...>)
+{
+	static constexpr const uint8_t indices[]{ uint8_t((4 * k + i / 4) / scale * 4 + i % 4)... };
+	return vld1q_u8(indices);
+}
+
+template<uint32_t scale, uint32_t... k>
+inline void StoreWidenedNEON(const uint8x16_t v, Color32* const dst, std::integer_sequence<uint32_t, k...>)
+{
+	(vst1q_u32(
+		dst + 4 * k,
+		vreinterpretq_u32_u8(vqtbl1q_u8(v, GetWidenTableNEON<scale, k>(std::make_index_sequence<16>())))), ...);
+}
+
+inline uint8x16_t LoadColorsNEON(const ColorIndex* const src, const Color32* const palette)
+{
+	const Color32 colors[4]{ palette[src[0]], palette[src[1]], palette[src[2]], palette[src[3]] };
+	return vreinterpretq_u8_u32(vld1q_u32(colors));
+}
+
+template<uint32_t scale>
+void WidenRowNEON(const ColorIndex* const src, const uint32_t src_width, const Color32* const palette, Color32* const dst)
+{
+	uint32_t x = 0;
+	for(; x + 4 <= src_width; x += 4)
+	{
+		const uint8x16_t v = LoadColorsNEON(src + x, palette);
+		StoreWidenedNEON<scale>(v, dst + x * scale, std::make_integer_sequence<uint32_t, scale>());
+	}
+	WidenRowScalar<scale>(src + x, src_width - x, palette, dst + x * scale);
+}
+
+#endif // SIMD_NEON
+
+const CopyImageFuncs g_scalar_funcs
+{
+	CopyImageWithScaleScalar<1>,
+	CopyImageWithScaleScalar<2>,
+	CopyImageWithScaleScalar<3>,
+	CopyImageWithScaleScalar<4>,
+	CopyImageWithScaleScalar<5>,
+	CopyImageWithScaleScalar<6>,
+};
+
+#ifdef SIMD_X86
+
+const CopyImageFuncs g_sse2_funcs
+{
+	CopyImageWithScaleRows<1, WidenRowSSE2<1>>,
+	CopyImageWithScaleRows<2, WidenRowSSE2<2>>,
+	CopyImageWithScaleRows<3, WidenRowSSE2<3>>,
+	CopyImageWithScaleRows<4, WidenRowSSE2<4>>,
+	CopyImageWithScaleRows<5, WidenRowSSE2<5>>,
+	CopyImageWithScaleRows<6, WidenRowSSE2<6>>,
+};
+
+const CopyImageFuncs g_sse2_non_temporal_funcs
+{
+	CopyImageWithScaleRowsNonTemporal<1, WidenRowSSE2<1>>,
+	CopyImageWithScaleRowsNonTemporal<2, WidenRowSSE2<2>>,
+	CopyImageWithScaleRowsNonTemporal<3, WidenRowSSE2<3>>,
+	CopyImageWithScaleRowsNonTemporal<4, WidenRowSSE2<4>>,
+	CopyImageWithScaleRowsNonTemporal<5, WidenRowSSE2<5>>,
+	CopyImageWithScaleRowsNonTemporal<6, WidenRowSSE2<6>>,
+};
+
+const CopyImageFuncs g_avx2_funcs
+{
+	CopyImageWithScaleRows<1, WidenRowAVX2<1>>,
+	CopyImageWithScaleRows<2, WidenRowAVX2<2>>,
+	CopyImageWithScaleRows<3, WidenRowAVX2<3>>,
+	CopyImageWithScaleRows<4, WidenRowAVX2<4>>,
+	CopyImageWithScaleRows<5, WidenRowAVX2<5>>,
+	CopyImageWithScaleRows<6, WidenRowAVX2<6>>,
+};
+
+const CopyImageFuncs g_avx2_non_temporal_funcs
+{
+	CopyImageWithScaleRowsNonTemporal<1, WidenRowAVX2<1>>,
+	CopyImageWithScaleRowsNonTemporal<2, WidenRowAVX2<2>>,
+	CopyImageWithScaleRowsNonTemporal<3, WidenRowAVX2<3>>,
+	CopyImageWithScaleRowsNonTemporal<4, WidenRowAVX2<4>>,
+	CopyImageWithScaleRowsNonTemporal<5, WidenRowAVX2<5>>,
+	CopyImageWithScaleRowsNonTemporal<6, WidenRowAVX2<6>>,
+};
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+const CopyImageFuncs g_neon_funcs
+{
+	CopyImageWithScaleRows<1, WidenRowNEON<1>>,
+	CopyImageWithScaleRows<2, WidenRowNEON<2>>,
+	CopyImageWithScaleRows<3, WidenRowNEON<3>>,
+	CopyImageWithScaleRows<4, WidenRowNEON<4>>,
+	CopyImageWithScaleRows<5, WidenRowNEON<5>>,
+	CopyImageWithScaleRows<6, WidenRowNEON<6>>,
+};
+
+#endif // SIMD_NEON
+
+const CopyImageFuncs& GetKernelFuncs(const ImageScalingKernel kernel, const bool use_non_temporal_stores)
+{
+	switch(kernel)
+	{
+#ifdef SIMD_X86
+	case ImageScalingKernel::SSE2:
+		return use_non_temporal_stores ? g_sse2_non_temporal_funcs : g_sse2_funcs;
+	case ImageScalingKernel::AVX2:
+		return use_non_temporal_stores ? g_avx2_non_temporal_funcs : g_avx2_funcs;
+#endif
+#ifdef SIMD_NEON
+	case ImageScalingKernel::NEON:
+		return g_neon_funcs;
+#endif
+	default:
+		(void)use_non_temporal_stores;
+		return g_scalar_funcs;
+	}
+}
+
+ImageScalingKernel DetectBestImageScalingKernel()
+{
+	const ImageScalingKernel kernels_by_priority[]
+	{
+		ImageScalingKernel::AVX2,
+		ImageScalingKernel::NEON,
+		ImageScalingKernel::SSE2,
+	};
+
+	for(const ImageScalingKernel kernel : kernels_by_priority)
+	{
+		if(IsImageScalingKernelSupported(kernel))
+		{
+			return kernel;
+		}
+	}
+
+	return ImageScalingKernel::Scalar;
+}
+
+} // namespace
+
+const char* GetImageScalingKernelName(const ImageScalingKernel kernel)
+{
+	switch(kernel)
+	{
+	case ImageScalingKernel::Scalar: return "scalar";
+	case ImageScalingKernel::SSE2: return "sse2";
+	case ImageScalingKernel::AVX2: return "avx2";
+	case ImageScalingKernel::NEON: return "neon";
+	case ImageScalingKernel::NumKernels: break;
+	}
+
+	return "";
+}
+
+bool IsImageScalingKernelSupported(const ImageScalingKernel kernel)
+{
+	switch(kernel)
+	{
+	case ImageScalingKernel::Scalar:
+		return true;
+#ifdef SIMD_X86
+	case ImageScalingKernel::SSE2:
+		return CPUSupportsSSE2();
+	case ImageScalingKernel::AVX2:
+		return CPUSupportsAVX2();
+#endif
+#ifdef SIMD_NEON
+	case ImageScalingKernel::NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+ImageScalingKernel GetBestImageScalingKernel()
+{
+	static const ImageScalingKernel best_kernel = DetectBestImageScalingKernel();
+	return best_kernel;
+}
+
+void CopyImageWithScale(
+	const ImageScalingKernel kernel,
+	const bool use_non_temporal_stores,
+	const uint32_t scale,
+	const ColorIndex* const src,
+	const uint32_t src_width,
+	const uint32_t src_height,
+	const uint32_t src_stride,
+	const Palette& palette,
+	Color32* const dst,
+	const uint32_t dst_stride)
+{
+	assert(IsImageScalingKernelSupported(kernel));
+
+	const uint32_t scale_clamped = scale >= 1 && scale <= g_max_image_scale ? scale : g_max_image_scale;
+	GetKernelFuncs(kernel, use_non_temporal_stores)[scale_clamped - 1](
+		src, src_width, src_height, src_stride, palette.data(), dst, dst_stride);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Color.hpp"
+
+constexpr const uint32_t g_max_image_scale = 6;
+
+// Implementations of integer image upscaling. Availability depends on target architecture and current CPU.
+enum class ImageScalingKernel : uint8_t
+{
+	// Reference implementation.
+	Scalar,
+	SSE2,
+	AVX2,
+	NEON,
+	NumKernels,
+};
+
+const char* GetImageScalingKernelName(ImageScalingKernel kernel);
+
+// Returns true if kernel is compiled for this target and current CPU supports it.
+bool IsImageScalingKernelSupported(ImageScalingKernel kernel);
+
+// Fastest supported kernel. CPU features are detected only once.
+ImageScalingKernel GetBestImageScalingKernel();
+
+// Copy image, repeating each pixel "scale x scale" times. Scale should be in range [1; g_max_image_scale].
+// Source pixels are palette indices, which are expanded into colors during copying.
+// Strides are in pixels.
+// Non-temporal stores bypass cache, which may be faster for large destination images.
+// They are ignored by kernels which have no support for them.
+void CopyImageWithScale(
+	ImageScalingKernel kernel,
+	bool use_non_temporal_stores,
+	uint32_t scale,
+	const ColorIndex* src,
+	uint32_t src_width,
+	uint32_t src_height,
+	uint32_t src_stride,
+	const Palette& palette,
+	Color32* dst,
+	uint32_t dst_stride);
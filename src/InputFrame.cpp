@@ -0,0 +1,18 @@
+#include "InputFrame.hpp"
+
+void InputFrame::Clear()
+{
+	num_events_ = 0;
+}
+
+bool InputFrame::AddEvent(const SDL_Event& event)
+{
+	if(IsFull())
+	{
+		return false;
+	}
+
+	events_[num_events_] = event;
+	++num_events_;
+	return true;
+}
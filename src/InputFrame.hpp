@@ -0,0 +1,48 @@
+#pragma once
+#include <SDL_events.h>
+#include <array>
+#include <bitset>
+
+// Input for single tick. Has fixed capacity, so can be reused between ticks without allocations.
+class InputFrame
+{
+public:
+	static constexpr size_t c_max_events = 64;
+
+	using KeyboardState = std::bitset<SDL_NUM_SCANCODES>;
+
+	struct EventsRange
+	{
+		const SDL_Event* events_begin;
+		const SDL_Event* events_end;
+
+		const SDL_Event* begin() const { return events_begin; }
+		const SDL_Event* end() const { return events_end; }
+	};
+
+public:
+	// Remove events. Keyboard state is preserved.
+	void Clear();
+
+	bool IsFull() const { return num_events_ == events_.size(); }
+
+	// Returns false if frame is full and event isn't added.
+	// Producers should stop fetching events in such case and leave remaining events for next tick.
+	bool AddEvent(const SDL_Event& event);
+
+	// Events in order of arrival.
+	EventsRange GetEvents() const { return EventsRange{events_.data(), events_.data() + num_events_}; }
+
+	bool IsKeyPressed(const SDL_Scancode scancode) const
+	{
+		return size_t(scancode) < keyboard_state_.size() && keyboard_state_[size_t(scancode)];
+	}
+
+	const KeyboardState& GetKeyboardState() const { return keyboard_state_; }
+	KeyboardState& GetKeyboardState() { return keyboard_state_; }
+
+private:
+	std::array<SDL_Event, c_max_events> events_;
+	size_t num_events_ = 0;
+	KeyboardState keyboard_state_;
+};
@@ -0,0 +1,67 @@
+#include "InputSource.hpp"
+
+namespace
+{
+
+const SDL_Scancode g_random_input_keys[]
+{
+	SDL_SCANCODE_LEFT,
+	SDL_SCANCODE_RIGHT,
+	SDL_SCANCODE_UP,
+	SDL_SCANCODE_DOWN,
+	SDL_SCANCODE_SPACE,
+	SDL_SCANCODE_LCTRL,
+	SDL_SCANCODE_RETURN,
+};
+
+// Average number of ticks between two keyboard state changes.
+const uint32_t g_key_change_inv_chance = 12;
+const uint32_t g_mouse_motion_inv_chance = 4;
+const uint32_t g_mouse_click_inv_chance = 240;
+const int32_t g_max_mouse_motion = 8;
+
+} // namespace
+
+RandomInputSource::RandomInputSource(const Rand::RandResultType seed)
+	: rand_(seed)
+{
+}
+
+void RandomInputSource::GenerateInput(const uint64_t tick, InputFrame& input)
+{
+	InputFrame::KeyboardState& keyboard_state = input.GetKeyboardState();
+
+	if(rand_.Next() % g_key_change_inv_chance == 0)
+	{
+		const SDL_Scancode scancode = g_random_input_keys[rand_.Next() % std::size(g_random_input_keys)];
+		const bool pressed = !keyboard_state[size_t(scancode)];
+		keyboard_state[size_t(scancode)] = pressed;
+
+		SDL_Event event{};
+		event.type = pressed ? SDL_KEYDOWN : SDL_KEYUP;
+		event.key.timestamp = uint32_t(tick);
+		event.key.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+		event.key.keysym.scancode = scancode;
+		input.AddEvent(event);
+	}
+
+	if(rand_.Next() % g_mouse_motion_inv_chance == 0)
+	{
+		SDL_Event event{};
+		event.type = SDL_MOUSEMOTION;
+		event.motion.timestamp = uint32_t(tick);
+		event.motion.xrel = int32_t(rand_.Next() % uint32_t(g_max_mouse_motion * 2 + 1)) - g_max_mouse_motion;
+		event.motion.yrel = int32_t(rand_.Next() % uint32_t(g_max_mouse_motion * 2 + 1)) - g_max_mouse_motion;
+		input.AddEvent(event);
+	}
+
+	if(rand_.Next() % g_mouse_click_inv_chance == 0)
+	{
+		SDL_Event event{};
+		event.type = SDL_MOUSEBUTTONDOWN;
+		event.button.timestamp = uint32_t(tick);
+		event.button.button = 1;
+		event.button.state = SDL_PRESSED;
+		input.AddEvent(event);
+	}
+}
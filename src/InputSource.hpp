@@ -0,0 +1,31 @@
+#pragma once
+#include "InputFrame.hpp"
+#include "Rand.hpp"
+#include <memory>
+
+class InputSourceInterface;
+using InputSourceInterfacePtr = std::unique_ptr<InputSourceInterface>;
+
+// Source of synthetic input for platforms without real input devices.
+class InputSourceInterface
+{
+public:
+	virtual ~InputSourceInterface() = default;
+
+	// Called once per tick with cleared input. Should add new events and modify keyboard state.
+	virtual void GenerateInput(uint64_t tick, InputFrame& input) = 0;
+};
+
+// Presses and releases game control keys and moves mouse randomly.
+// Escape and pause keys are never pressed in order to keep game running.
+class RandomInputSource final : public InputSourceInterface
+{
+public:
+	explicit RandomInputSource(Rand::RandResultType seed);
+
+public: // InputSourceInterface
+	virtual void GenerateInput(uint64_t tick, InputFrame& input) override;
+
+private:
+	Rand rand_;
+};
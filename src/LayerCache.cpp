@@ -0,0 +1,116 @@
+#include "LayerCache.hpp"
+#include "DrawCommandBuffer.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// Games use only CGA colors, so this index can't be produced by drawing functions.
+constexpr const ColorIndex c_transparent_color = 0xFF;
+
+} // namespace
+
+FrameBuffer LayerCache::BeginRendering(const uint32_t width, const uint32_t height)
+{
+	TRACE_ZONE("LayerCache::Render");
+
+	width_ = width;
+	height_ = height;
+	data_.assign(size_t(width) * size_t(height), type_ == Type::Opaque ? g_color_black : c_transparent_color);
+
+	return MakeFrameBuffer(data_.data(), width, height);
+}
+
+void LayerCache::EndRendering(const Key key)
+{
+	key_ = key;
+	is_valid_ = true;
+
+	// Destination frame buffer may have different stride, so spans don't cross rows.
+	spans_.clear();
+	for(uint32_t y = 0; y < height_; ++y)
+	{
+		if(type_ == Type::Opaque)
+		{
+			spans_.push_back({0, y, width_});
+			continue;
+		}
+
+		const ColorIndex* const line = data_.data() + y * width_;
+		uint32_t x = 0;
+		while(x < width_)
+		{
+			while(x < width_ && line[x] == c_transparent_color)
+			{
+				++x;
+			}
+
+			const uint32_t span_start = x;
+			while(x < width_ && line[x] != c_transparent_color)
+			{
+				++x;
+			}
+
+			if(x > span_start)
+			{
+				spans_.push_back({span_start, y, x - span_start});
+			}
+		}
+	}
+
+	bounds_ = ClipRect{width_, height_, 0, 0};
+	for(const Span& span : spans_)
+	{
+		bounds_.x_begin = std::min(bounds_.x_begin, span.x);
+		bounds_.y_begin = std::min(bounds_.y_begin, span.y);
+		bounds_.x_end = std::max(bounds_.x_end, span.x + span.size);
+		bounds_.y_end = std::max(bounds_.y_end, span.y + 1);
+	}
+}
+
+void LayerCache::CopyTo(const FrameBuffer frame_buffer) const
+{
+	if(frame_buffer.command_buffer != nullptr)
+	{
+		// Layer contents aren't changed until frame is rasterized.
+		DrawCommand command;
+		command.bounds = bounds_;
+		command.type = DrawCommandType::Layer;
+		command.payload = frame_buffer.command_buffer->AddLayer(*this);
+		frame_buffer.command_buffer->AddCommand(command);
+		return;
+	}
+
+	for(const Span& span : spans_)
+	{
+		std::memcpy(
+			frame_buffer.GetRow(span.y) + span.x,
+			data_.data() + span.y * width_ + span.x,
+			span.size * sizeof(ColorIndex));
+	}
+}
+
+void LayerCache::CopyTo(const FrameBuffer frame_buffer, const ClipRect& clip) const
+{
+	const auto first_span =
+		std::lower_bound(
+			spans_.begin(),
+			spans_.end(),
+			clip.y_begin,
+			[](const Span& span, const uint32_t y) { return span.y < y; });
+
+	for(auto it = first_span; it != spans_.end() && it->y < clip.y_end; ++it)
+	{
+		const uint32_t x_begin = std::max(it->x, clip.x_begin);
+		const uint32_t x_end = std::min(it->x + it->size, clip.x_end);
+		if(x_begin < x_end)
+		{
+			std::memcpy(
+				frame_buffer.GetRow(it->y) + x_begin,
+				data_.data() + it->y * width_ + x_begin,
+				(x_end - x_begin) * sizeof(ColorIndex));
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "FrameBuffer.hpp"
+#include <vector>
+
+// Offscreen image of static part of frame (field, walls, borders).
+// It's rendered again only if its key changes and is copied into frame with row "memcpy".
+// Key should be built from all state which affects layer contents.
+class LayerCache
+{
+public:
+	enum class Type : uint8_t
+	{
+		// Layer replaces whole frame buffer contents. It's rendered over black background.
+		Opaque,
+		// Only pixels written by render function are copied.
+		Transparent,
+	};
+
+	using Key = uint64_t;
+
+public:
+	explicit LayerCache(Type type) : type_(type) {}
+
+	// Render function is called as "render_func(layer_frame_buffer)".
+	template<typename Func>
+	void Draw(const FrameBuffer frame_buffer, const Key key, const Func& render_func)
+	{
+		if(!is_valid_ || key != key_ || frame_buffer.width != width_ || frame_buffer.height != height_)
+		{
+			render_func(BeginRendering(frame_buffer.width, frame_buffer.height));
+			EndRendering(key);
+		}
+
+		CopyTo(frame_buffer);
+	}
+
+	void Invalidate() { is_valid_ = false; }
+
+	// Copy layer pixels inside clip rect. Used for execution of recorded commands.
+	void CopyTo(FrameBuffer frame_buffer, const ClipRect& clip) const;
+
+private:
+	// Run of pixels within single row. Position and size are in pixels.
+	struct Span
+	{
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t size = 0;
+	};
+
+private:
+	FrameBuffer BeginRendering(uint32_t width, uint32_t height);
+	void EndRendering(Key key);
+	// Copy whole layer or record copy command.
+	void CopyTo(FrameBuffer frame_buffer) const;
+
+private:
+	const Type type_;
+	std::vector<ColorIndex> data_;
+	// Sorted by y.
+	std::vector<Span> spans_;
+	// Bounding box of spans.
+	ClipRect bounds_;
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	Key key_ = 0;
+	bool is_valid_ = false;
+};
@@ -1,4 +1,5 @@
 #include "Host.hpp"
+#include "PlatformSDL.hpp"
 #include <SDL.h>
 
 #ifdef __EMSCRIPTEN__
@@ -26,7 +27,9 @@ extern "C" int main(int argc, char *argv[])
 	(void) argc;
 	(void) argv;
 
-	host= std::make_unique<Host>();
+	host= std::make_unique<Host>(std::make_unique<PlatformSDL>(SystemWindowSettings()));
+	// Browser paces frames itself.
+	host->SetMaxFPS(0);
 	emscripten_set_main_loop(MainLoop, 0, 1);
 
 	return 0;
@@ -36,14 +39,143 @@ extern "C" int main(int argc, char *argv[])
 
 #else
 
-extern "C" int main(int argc, char *argv[])
+#include "HeadlessBenchmark.hpp"
+#include "ReplayDriver.hpp"
+#include "ScalingBenchmark.hpp"
+#include "SpriteBenchmark.hpp"
+#include "Trace.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
 {
-	(void) argc;
-	(void) argv;
 
-	Host host;
-	while(!host.Loop()){}
+int Run(const int argc, char *argv[])
+{
+	if(argc >= 2 && std::strcmp(argv[1], "--headless-benchmark") == 0)
+	{
+		return RunHeadlessBenchmark(argc - 2, argv + 2);
+	}
+	if(argc >= 2 && std::strcmp(argv[1], "--render-frames") == 0)
+	{
+		return RunFrameRendering(argc - 2, argv + 2);
+	}
+	if(argc >= 2 && std::strcmp(argv[1], "--scaling-benchmark") == 0)
+	{
+		return RunScalingBenchmark(argc - 2, argv + 2);
+	}
+	if(argc >= 2 && std::strcmp(argv[1], "--sprite-benchmark") == 0)
+	{
+		return RunSpriteBenchmark(argc - 2, argv + 2);
+	}
+	if(argc >= 2 && std::strcmp(argv[1], "--record") == 0)
+	{
+		return RunRecording(argc - 2, argv + 2);
+	}
+	if(argc >= 2 && std::strcmp(argv[1], "--replay") == 0)
+	{
+		return RunReplay(argc - 2, argv + 2);
+	}
+
+	bool threaded = false;
+	bool deferred_draw = false;
+	bool print_pacing_stats = false;
+	uint32_t max_fps = FramePacer::c_default_max_fps;
+	SystemWindowSettings window_settings;
+	window_settings.num_post_process_threads = WorkerPool::GetDefaultNumThreads();
+	for(int i = 1; i < argc; ++i)
+	{
+		if(std::strcmp(argv[i], "--threaded") == 0)
+		{
+			threaded = true;
+		}
+		else if(std::strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc)
+		{
+			++i;
+			max_fps = uint32_t(std::strtoul(argv[i], nullptr, 10));
+		}
+		else if(std::strcmp(argv[i], "--post-process-threads") == 0 && i + 1 < argc)
+		{
+			++i;
+			window_settings.num_post_process_threads = uint32_t(std::strtoul(argv[i], nullptr, 10));
+		}
+		else if(std::strcmp(argv[i], "--presentation") == 0 && i + 1 < argc)
+		{
+			++i;
+			if(std::strcmp(argv[i], "surface") == 0)
+			{
+				window_settings.presentation_backend = PresentationBackend::WindowSurface;
+			}
+			else if(std::strcmp(argv[i], "texture") == 0)
+			{
+				window_settings.presentation_backend = PresentationBackend::StreamingTexture;
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown presentation backend \"%s\", expected \"surface\" or \"texture\"\n", argv[i]);
+				return 1;
+			}
+		}
+		else if(std::strcmp(argv[i], "--vsync") == 0)
+		{
+			window_settings.vsync = true;
+		}
+		else if(std::strcmp(argv[i], "--deferred-draw") == 0)
+		{
+			deferred_draw = true;
+		}
+		else if(std::strcmp(argv[i], "--pacing-stats") == 0)
+		{
+			print_pacing_stats = true;
+		}
+	}
+
+	Host host(std::make_unique<PlatformSDL>(window_settings));
+	host.SetMaxFPS(max_fps);
+	if(deferred_draw)
+	{
+		host.EnableDeferredDrawing(WorkerPool::GetDefaultNumThreads());
+	}
+	if(threaded)
+	{
+		host.RunThreaded();
+	}
+	else
+	{
+		while(!host.Loop()){}
+	}
+
+	if(print_pacing_stats)
+	{
+		const FramePacer::Stats stats = host.GetPacingStats();
+		std::printf(
+			"Frames: %" PRIu64 " (%" PRIu64 " late), ticks: %" PRIu64 " (%" PRIu64 " dropped), "
+			"jitter p50/p95/p99/max: %.3f/%.3f/%.3f/%.3f ms\n",
+			stats.num_frames,
+			stats.num_late_frames,
+			stats.num_ticks,
+			stats.num_dropped_ticks,
+			double(stats.jitter_p50_ns) * 1.0e-6,
+			double(stats.jitter_p95_ns) * 1.0e-6,
+			double(stats.jitter_p99_ns) * 1.0e-6,
+			double(stats.jitter_max_ns) * 1.0e-6);
+	}
+
 	return 0;
 }
 
+} // namespace
+
+extern "C" int main(int argc, char *argv[])
+{
+	TRACE_THREAD_NAME("Main");
+
+	const int result = Run(argc, argv);
+
+	TRACE_DUMP(Host::c_trace_file_name);
+	return result;
+}
+
 #endif
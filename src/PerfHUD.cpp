@@ -0,0 +1,153 @@
+#include "PerfHUD.hpp"
+#include "Draw.hpp"
+#include "GameInterface.hpp"
+#include "String.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+const ColorIndex g_phase_colors[size_t(PerfPhase::NumPhases)]
+{
+	10,
+	11,
+	14,
+	12,
+};
+
+const char* const g_phase_names[size_t(PerfPhase::NumPhases)]
+{
+	"Tick",
+	"Draw",
+	"Post",
+	"Present",
+};
+
+const uint32_t g_hud_x = 4;
+const uint32_t g_hud_y = 4;
+const uint32_t g_graph_height = 48;
+// Graph scale.
+const uint32_t g_pixels_per_ms = 4;
+
+// Writes value in hundredths as "123.45".
+void HundredthsToString(char* const str, const size_t str_len, const uint32_t value)
+{
+	NumToString(str, str_len, value / 100, 3);
+	const size_t len = std::strlen(str);
+	if(len + 4 > str_len)
+	{
+		return;
+	}
+
+	str[len + 0] = '.';
+	str[len + 1] = char('0' + value / 10 % 10);
+	str[len + 2] = char('0' + value % 10);
+	str[len + 3] = '\0';
+}
+
+} // namespace
+
+void PerfHUD::AddPhaseTime(const PerfPhase phase, const uint64_t duration_ns)
+{
+	current_phase_time_ns_[size_t(phase)] += duration_ns;
+}
+
+void PerfHUD::EndFrame(const uint32_t num_ticks)
+{
+	FrameSample& sample = samples_[num_frames_ % c_num_samples];
+	for(size_t i = 0; i < size_t(PerfPhase::NumPhases); ++i)
+	{
+		sample.phase_time_ns[i] = uint32_t(std::min(current_phase_time_ns_[i], uint64_t(0xFFFFFFFF)));
+		current_phase_time_ns_[i] = 0;
+	}
+	sample.num_ticks = num_ticks;
+	sample.end_time = Clock::now();
+
+	++num_frames_;
+}
+
+void PerfHUD::Draw(const FrameBuffer frame_buffer) const
+{
+	const size_t num_samples = size_t(std::min(num_frames_, uint64_t(c_num_samples)));
+	if(num_samples < 2)
+	{
+		return;
+	}
+
+	const size_t last_sample_index = size_t((num_frames_ - 1) % c_num_samples);
+	const size_t first_sample_index = size_t((num_frames_ - num_samples) % c_num_samples);
+
+	std::array<uint64_t, size_t(PerfPhase::NumPhases)> total_phase_time_ns{};
+	uint64_t total_ticks = 0;
+	for(const FrameSample& sample : samples_)
+	{
+		for(size_t i = 0; i < size_t(PerfPhase::NumPhases); ++i)
+		{
+			total_phase_time_ns[i] += sample.phase_time_ns[i];
+		}
+		total_ticks += sample.num_ticks;
+	}
+
+	const uint32_t num_lines = 2 + uint32_t(PerfPhase::NumPhases);
+	// Enough for longest line - "Present 123.45 ms".
+	const uint32_t width = std::max(uint32_t(c_num_samples), 17 * g_glyph_width) + 8;
+	const uint32_t height = num_lines * g_glyph_height + g_graph_height + 8;
+	FillRect(frame_buffer, g_color_black, g_hud_x, g_hud_y, width, height);
+
+	uint32_t y = g_hud_y + 2;
+	char text[64];
+
+	// Frame rate is measured between first and last frames in buffer.
+	const auto duration_ns =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			samples_[last_sample_index].end_time - samples_[first_sample_index].end_time).count();
+	const uint64_t fps_hundredths = duration_ns <= 0 ? 0 : uint64_t(num_samples - 1) * 100000000000ull / uint64_t(duration_ns);
+
+	std::strcpy(text, "FPS   ");
+	HundredthsToString(text + std::strlen(text), sizeof(text) - std::strlen(text), uint32_t(fps_hundredths));
+	DrawText(frame_buffer, g_color_white, g_hud_x + 4, y, text);
+	y += g_glyph_height;
+
+	std::strcpy(text, "Ticks ");
+	HundredthsToString(text + std::strlen(text), sizeof(text) - std::strlen(text), uint32_t(total_ticks * 100 / num_samples));
+	DrawText(frame_buffer, g_color_white, g_hud_x + 4, y, text);
+	y += g_glyph_height;
+
+	for(size_t i = 0; i < size_t(PerfPhase::NumPhases); ++i)
+	{
+		// Average time in milliseconds.
+		std::strcpy(text, g_phase_names[i]);
+		std::memset(text + std::strlen(text), ' ', 8 - std::strlen(text));
+		HundredthsToString(text + 8, sizeof(text) - 8, uint32_t(total_phase_time_ns[i] / num_samples / 10000));
+		std::strcat(text, " ms");
+		DrawText(frame_buffer, g_phase_colors[i], g_hud_x + 4, y, text);
+		y += g_glyph_height;
+	}
+
+	y += 2;
+	const uint32_t graph_bottom = y + g_graph_height;
+
+	// Draw stacked bars for each frame, oldest first.
+	for(size_t s = 0; s < num_samples; ++s)
+	{
+		const FrameSample& sample = samples_[(num_frames_ - num_samples + s) % c_num_samples];
+		const uint32_t x = g_hud_x + 4 + uint32_t(s);
+
+		uint32_t bar_bottom = graph_bottom;
+		for(size_t i = 0; i < size_t(PerfPhase::NumPhases) && bar_bottom > y; ++i)
+		{
+			const uint32_t bar_height =
+				std::min(bar_bottom - y, uint32_t(uint64_t(sample.phase_time_ns[i]) * g_pixels_per_ms / 1000000));
+			FillRect(frame_buffer, g_phase_colors[i], x, bar_bottom - bar_height, 1, bar_height);
+			bar_bottom -= bar_height;
+		}
+	}
+
+	// Line for time of single tick.
+	const uint32_t tick_budget_height = g_pixels_per_ms * 1000 / GameInterface::c_update_frequency;
+	for(uint32_t x = 0; x < uint32_t(c_num_samples); x += 2)
+	{
+		FillRect(frame_buffer, g_color_white, g_hud_x + 4 + x, graph_bottom - tick_budget_height, 1, 1);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "FrameBuffer.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+enum class PerfPhase : uint8_t
+{
+	Tick, // All ticks of frame.
+	Draw,
+	PostProcess, // Scaling and effects.
+	Present,
+	NumPhases,
+};
+
+// Collects timings of frame phases into fixed-size ring buffer and draws them as overlay.
+// Performs no allocations, in order to not disturb measurements.
+class PerfHUD
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+public:
+	void AddPhaseTime(PerfPhase phase, uint64_t duration_ns);
+
+	// Save timings of current frame and start new frame.
+	void EndFrame(uint32_t num_ticks);
+
+	void Draw(FrameBuffer frame_buffer) const;
+
+private:
+	struct FrameSample
+	{
+		std::array<uint32_t, size_t(PerfPhase::NumPhases)> phase_time_ns{};
+		uint32_t num_ticks = 0;
+		Clock::time_point end_time;
+	};
+
+	static constexpr size_t c_num_samples = 128;
+
+private:
+	std::array<uint64_t, size_t(PerfPhase::NumPhases)> current_phase_time_ns_{};
+	std::array<FrameSample, c_num_samples> samples_{};
+	uint64_t num_frames_ = 0;
+};
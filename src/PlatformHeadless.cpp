@@ -0,0 +1,75 @@
+#include "PlatformHeadless.hpp"
+#include "GameInterface.hpp"
+#include <algorithm>
+#include <cstring>
+
+PlatformHeadless::PlatformHeadless(InputSourceInterfacePtr input_source, const uint32_t sample_rate)
+	: input_source_(std::move(input_source))
+	, sound_out_(sample_rate)
+	, frame_buffer_data_(g_framebuffer_width * g_framebuffer_height, 0)
+{
+}
+
+void PlatformHeadless::GetInput(InputFrame& input)
+{
+	input.Clear();
+	input.GetKeyboardState() = keyboard_state_;
+	if(input_source_ != nullptr)
+	{
+		input_source_->GenerateInput(num_ticks_with_input_, input);
+	}
+	keyboard_state_ = input.GetKeyboardState();
+	++num_ticks_with_input_;
+}
+
+void PlatformHeadless::SetRelativeMouseMode(const bool enable)
+{
+	(void)enable;
+}
+
+void PlatformHeadless::BeginFrame()
+{
+}
+
+FrameBuffer PlatformHeadless::GetFrameBuffer()
+{
+	return GetLastFrame();
+}
+
+void PlatformHeadless::EndFrame(const FrameBuffer frame_buffer)
+{
+	// Keep last frame available.
+	if(frame_buffer.data != frame_buffer_data_.data())
+	{
+		const FrameBuffer last_frame = GetLastFrame();
+		const uint32_t width = std::min(frame_buffer.width, last_frame.width);
+		for(uint32_t y = 0; y < std::min(frame_buffer.height, last_frame.height); ++y)
+		{
+			std::memcpy(last_frame.GetRow(y), frame_buffer.GetRow(y), width * sizeof(ColorIndex));
+		}
+	}
+
+	++num_frames_;
+
+	// Consume amount of samples corresponding to one tick.
+	const uint64_t total_samples =
+		num_frames_ * uint64_t(sound_out_.GetSampleRate()) / uint64_t(GameInterface::c_update_frequency);
+	sound_out_.ConsumeSamples(uint32_t(total_samples - num_consumed_samples_));
+	num_consumed_samples_ = total_samples;
+}
+
+EndFrameTimings PlatformHeadless::GetLastEndFrameTimings() const
+{
+	// Nothing is post-processed or presented.
+	return EndFrameTimings();
+}
+
+SoundOut& PlatformHeadless::GetSoundOut()
+{
+	return sound_out_;
+}
+
+FrameBuffer PlatformHeadless::GetLastFrame()
+{
+	return MakeFrameBuffer(frame_buffer_data_.data(), g_framebuffer_width, g_framebuffer_height);
+}
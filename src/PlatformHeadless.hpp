@@ -0,0 +1,49 @@
+#pragma once
+#include "InputSource.hpp"
+#include "PlatformInterface.hpp"
+
+// Platform implementation without window and audio device.
+// Frames are drawn into in-memory buffer, sound is consumed by null sink, input is provided by given input source.
+// Time is virtual - one frame is exactly one tick.
+class PlatformHeadless final : public PlatformInterface
+{
+public:
+	// Same as requested for real device.
+	static constexpr uint32_t c_default_sample_rate = 8192;
+
+public:
+	// Input source may be null - in such case no input is generated.
+	// Sample rate affects sounds and music duration, so it should match sample rate of recording for replays.
+	explicit PlatformHeadless(InputSourceInterfacePtr input_source, uint32_t sample_rate = c_default_sample_rate);
+
+public: // PlatformInterface
+	virtual void GetInput(InputFrame& input) override;
+
+	virtual void SetRelativeMouseMode(bool enable) override;
+
+	virtual void BeginFrame() override;
+	virtual FrameBuffer GetFrameBuffer() override;
+	virtual void EndFrame(FrameBuffer frame_buffer) override;
+	virtual EndFrameTimings GetLastEndFrameTimings() const override;
+
+	virtual SoundOut& GetSoundOut() override;
+
+	virtual bool IsRealTime() const override { return false; }
+
+public:
+	// Result of last drawn frame.
+	FrameBuffer GetLastFrame();
+
+	uint64_t GetNumFrames() const { return num_frames_; }
+
+private:
+	const InputSourceInterfacePtr input_source_;
+	SoundOut sound_out_;
+
+	std::vector<ColorIndex> frame_buffer_data_;
+	InputFrame::KeyboardState keyboard_state_;
+
+	uint64_t num_ticks_with_input_ = 0;
+	uint64_t num_frames_ = 0;
+	uint64_t num_consumed_samples_ = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "FrameBuffer.hpp"
+#include "InputFrame.hpp"
+#include "SoundOut.hpp"
+#include <memory>
+
+// Durations of parts of last "EndFrame" call.
+struct EndFrameTimings
+{
+	uint64_t post_process_ns = 0; // Scaling and effects.
+	uint64_t present_ns = 0;
+};
+
+class PlatformInterface;
+using PlatformInterfacePtr = std::unique_ptr<PlatformInterface>;
+
+// Abstraction over system stuff - window, input and sound output.
+class PlatformInterface
+{
+public:
+	virtual ~PlatformInterface() = default;
+
+	// Replace events of given input with new ones and update its keyboard state.
+	virtual void GetInput(InputFrame& input) = 0;
+
+	virtual void SetRelativeMouseMode(bool enable) = 0;
+
+	virtual void BeginFrame() = 0;
+	virtual FrameBuffer GetFrameBuffer() = 0;
+	// Present given frame. It's usually frame buffer returned by "GetFrameBuffer",
+	// but may be any other image (possibly with different stride), which is presented without copying into platform frame buffer.
+	virtual void EndFrame(FrameBuffer frame_buffer) = 0;
+	virtual EndFrameTimings GetLastEndFrameTimings() const = 0;
+
+	virtual SoundOut& GetSoundOut() = 0;
+
+	// Returns false if this platform has no real time.
+	// In such case host should perform exactly one tick per frame and should not wait.
+	virtual bool IsRealTime() const = 0;
+};
@@ -0,0 +1,46 @@
+#include "PlatformSDL.hpp"
+#include <SDL_mouse.h>
+
+PlatformSDL::PlatformSDL(const SystemWindowSettings& window_settings)
+	: system_window_(window_settings)
+	, sound_out_()
+{
+}
+
+void PlatformSDL::GetInput(InputFrame& input)
+{
+	system_window_.GetInput(input);
+}
+
+void PlatformSDL::SetRelativeMouseMode(const bool enable)
+{
+	SDL_SetRelativeMouseMode(enable ? SDL_TRUE : SDL_FALSE);
+}
+
+void PlatformSDL::BeginFrame()
+{
+	system_window_.BeginFrame();
+}
+
+FrameBuffer PlatformSDL::GetFrameBuffer()
+{
+	return system_window_.GetFrameBuffer();
+}
+
+void PlatformSDL::EndFrame(const FrameBuffer frame_buffer)
+{
+	system_window_.EndFrame(frame_buffer);
+}
+
+EndFrameTimings PlatformSDL::GetLastEndFrameTimings() const
+{
+	EndFrameTimings timings;
+	timings.post_process_ns = system_window_.GetLastPostProcessDurationNs();
+	timings.present_ns = system_window_.GetLastPresentDurationNs();
+	return timings;
+}
+
+SoundOut& PlatformSDL::GetSoundOut()
+{
+	return sound_out_;
+}
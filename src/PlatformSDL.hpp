@@ -0,0 +1,28 @@
+#pragma once
+#include "PlatformInterface.hpp"
+#include "SystemWindow.hpp"
+
+// Platform implementation with real window and real sound output.
+class PlatformSDL final : public PlatformInterface
+{
+public:
+	explicit PlatformSDL(const SystemWindowSettings& window_settings);
+
+public: // PlatformInterface
+	virtual void GetInput(InputFrame& input) override;
+
+	virtual void SetRelativeMouseMode(bool enable) override;
+
+	virtual void BeginFrame() override;
+	virtual FrameBuffer GetFrameBuffer() override;
+	virtual void EndFrame(FrameBuffer frame_buffer) override;
+	virtual EndFrameTimings GetLastEndFrameTimings() const override;
+
+	virtual SoundOut& GetSoundOut() override;
+
+	virtual bool IsRealTime() const override { return true; }
+
+private:
+	SystemWindow system_window_;
+	SoundOut sound_out_;
+};
@@ -1,13 +1,22 @@
 #include "Progress.hpp"
 #include <cstdio>
+#include <optional>
 
 namespace
 {
 
 const char g_file_name[] = "save.bin";
 
+std::optional<Progress> g_in_memory_progress;
+
 void SaveProgress(const Progress& progress)
 {
+	if(g_in_memory_progress != std::nullopt)
+	{
+		*g_in_memory_progress = progress;
+		return;
+	}
+
 	FILE* const f = std::fopen(g_file_name, "wb");
 	if(f == nullptr)
 	{
@@ -41,6 +50,11 @@ uint32_t Progress::GetNumOpenedGames() const
 
 Progress LoadProgress()
 {
+	if(g_in_memory_progress != std::nullopt)
+	{
+		return *g_in_memory_progress;
+	}
+
 	Progress progress;
 
 	FILE* const f = std::fopen(g_file_name, "rb");
@@ -54,6 +68,11 @@ Progress LoadProgress()
 	return progress;
 }
 
+void UseInMemoryProgress(const Progress& progress)
+{
+	g_in_memory_progress = progress;
+}
+
 void OpenGame(const GameId game_id)
 {
 	Progress progress = LoadProgress();
@@ -24,4 +24,8 @@ struct Progress
 
 Progress LoadProgress();
 
+// Keep progress in memory, starting with given value, instead of loading and saving it.
+// Used for replays and benchmarks in order to make them independent on save file and to keep it intact.
+void UseInMemoryProgress(const Progress& progress);
+
 void OpenGame(GameId game_id);
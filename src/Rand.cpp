@@ -1,6 +1,14 @@
 #include "Rand.hpp"
 #include <cstring>
 #include <cassert>
+#include <optional>
+
+namespace
+{
+
+std::optional<Rand> g_seeds_generator;
+
+} // namespace
 
 Rand::Rand(const RandResultType seed)
 	: generator_(seed)
@@ -8,14 +16,30 @@ Rand::Rand(const RandResultType seed)
 
 Rand Rand::CreateWithRandomSeed()
 {
+	if(g_seeds_generator != std::nullopt)
+	{
+		return Rand(g_seeds_generator->Next());
+	}
+
 	return Rand(std::random_device()());
 }
 
+void Rand::SetDeterministicSeed(const RandResultType seed)
+{
+	g_seeds_generator = Rand(seed);
+}
+
 Rand::RandResultType Rand::Next()
 {
 	return generator_();
 }
 
+Rand::RandResultType Rand::PeekNext() const
+{
+	Generator generator_copy = generator_;
+	return generator_copy();
+}
+
 float Rand::RandomAngle()
 {
 	return float(Next()) * (2.0f * 3.1415926535f / float(c_max_rand_plus_one_));
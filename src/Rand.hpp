@@ -10,8 +10,15 @@ public:
 
 	static Rand CreateWithRandomSeed();
 
+	// Make all generators created later via "CreateWithRandomSeed" deterministic.
+	// Their seeds are taken from a sequence, started with given seed. Used for replays and benchmarks.
+	static void SetDeterministicSeed(RandResultType seed);
+
 	RandResultType Next();
 
+	// Returns next value without changing state. Result uniquely identifies current state.
+	RandResultType PeekNext() const;
+
 	float RandomAngle();
 
 private:
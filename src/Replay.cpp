@@ -0,0 +1,409 @@
+#include "Replay.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+const char g_magic[4] = {'V', 'R', 'P', 'L'};
+const uint32_t g_version = 1;
+
+enum class EventType : uint8_t
+{
+	Quit,
+	KeyDown,
+	KeyUp,
+	MouseMotion,
+	MouseButtonDown,
+	MouseButtonUp,
+};
+
+std::optional<EventType> GetEventType(const SDL_Event& event)
+{
+	switch(event.type)
+	{
+	case SDL_QUIT: return EventType::Quit;
+	case SDL_KEYDOWN: return EventType::KeyDown;
+	case SDL_KEYUP: return EventType::KeyUp;
+	case SDL_MOUSEMOTION: return EventType::MouseMotion;
+	case SDL_MOUSEBUTTONDOWN: return EventType::MouseButtonDown;
+	case SDL_MOUSEBUTTONUP: return EventType::MouseButtonUp;
+	}
+	return std::nullopt;
+}
+
+uint64_t ZigZagEncode(const int32_t value)
+{
+	return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t ZigZagDecode(const uint64_t value)
+{
+	return int32_t(uint32_t(value >> 1) ^ (0u - uint32_t(value & 1)));
+}
+
+} // namespace
+
+ReplayWriter::ReplayWriter(const char* const file_name, const ReplayHeader& header)
+	: file_(std::fopen(file_name, "wb"))
+	, state_hash_interval_(header.state_hash_interval)
+{
+	if(file_ == nullptr)
+	{
+		return;
+	}
+
+	Reserve(sizeof(g_magic));
+	std::memcpy(buffer_.data() + buffer_size_, g_magic, sizeof(g_magic));
+	buffer_size_ += sizeof(g_magic);
+
+	WriteVarInt(g_version);
+	WriteVarInt(header.seed);
+	WriteVarInt(header.sample_rate);
+	WriteVarInt(header.progress.opened_games_mask);
+	WriteVarInt(uint64_t(header.progress.current_game));
+	WriteVarInt(header.start_game == std::nullopt ? 0 : uint64_t(*header.start_game) + 1);
+	WriteVarInt(header.state_hash_interval);
+}
+
+ReplayWriter::~ReplayWriter()
+{
+	Finish();
+}
+
+void ReplayWriter::WriteTickInput(const InputFrame& input)
+{
+	if(file_ == nullptr)
+	{
+		return;
+	}
+
+	uint32_t num_events = 0;
+	for(const SDL_Event& event : input.GetEvents())
+	{
+		num_events += GetEventType(event) == std::nullopt ? 0 : 1;
+	}
+
+	WriteVarInt(num_events);
+	for(const SDL_Event& event : input.GetEvents())
+	{
+		const auto type = GetEventType(event);
+		if(type == std::nullopt)
+		{
+			continue;
+		}
+
+		WriteByte(uint8_t(*type));
+		switch(*type)
+		{
+		case EventType::Quit:
+			break;
+		case EventType::KeyDown:
+		case EventType::KeyUp:
+			WriteVarInt((uint64_t(event.key.keysym.scancode) << 1) | (event.key.repeat != 0 ? 1 : 0));
+			break;
+		case EventType::MouseMotion:
+			WriteVarInt(ZigZagEncode(event.motion.xrel));
+			WriteVarInt(ZigZagEncode(event.motion.yrel));
+			break;
+		case EventType::MouseButtonDown:
+		case EventType::MouseButtonUp:
+			WriteVarInt(event.button.button);
+			break;
+		}
+	}
+
+	const InputFrame::KeyboardState& keyboard_state = input.GetKeyboardState();
+	const InputFrame::KeyboardState changes = keyboard_state ^ prev_keyboard_state_;
+
+	WriteVarInt(changes.count());
+	size_t prev_changed_scancode = 0;
+	for(size_t i = 0; i < changes.size(); ++i)
+	{
+		if(changes[i])
+		{
+			WriteVarInt(i - prev_changed_scancode);
+			prev_changed_scancode = i;
+		}
+	}
+	prev_keyboard_state_ = keyboard_state;
+
+	++num_ticks_;
+}
+
+bool ReplayWriter::NeedStateHash() const
+{
+	return file_ != nullptr && state_hash_interval_ != 0 && num_ticks_ % state_hash_interval_ == 0;
+}
+
+void ReplayWriter::WriteStateHash(const StateHasher::HashType hash)
+{
+	if(file_ == nullptr)
+	{
+		return;
+	}
+
+	Reserve(sizeof(hash));
+	for(size_t i = 0; i < sizeof(hash); ++i)
+	{
+		buffer_[buffer_size_] = uint8_t(hash >> (i * 8));
+		++buffer_size_;
+	}
+}
+
+bool ReplayWriter::Finish()
+{
+	if(file_ == nullptr)
+	{
+		return !write_error_;
+	}
+
+	Flush();
+	if(std::fclose(file_) != 0)
+	{
+		write_error_ = true;
+	}
+	file_ = nullptr;
+
+	return !write_error_;
+}
+
+void ReplayWriter::WriteVarInt(uint64_t value)
+{
+	Reserve(c_min_free_space);
+	while(value >= 0x80)
+	{
+		buffer_[buffer_size_] = uint8_t(value | 0x80);
+		++buffer_size_;
+		value >>= 7;
+	}
+	buffer_[buffer_size_] = uint8_t(value);
+	++buffer_size_;
+}
+
+void ReplayWriter::WriteByte(const uint8_t value)
+{
+	Reserve(1);
+	buffer_[buffer_size_] = value;
+	++buffer_size_;
+}
+
+void ReplayWriter::Reserve(const size_t size)
+{
+	if(buffer_size_ + size > buffer_.size())
+	{
+		Flush();
+	}
+}
+
+void ReplayWriter::Flush()
+{
+	if(std::fwrite(buffer_.data(), 1, buffer_size_, file_) != buffer_size_)
+	{
+		write_error_ = true;
+	}
+	buffer_size_ = 0;
+}
+
+ReplayInputSource::ReplayInputSource(const char* const file_name)
+{
+	std::FILE* const f = std::fopen(file_name, "rb");
+	if(f == nullptr)
+	{
+		return;
+	}
+
+	std::array<uint8_t, 4096> chunk;
+	while(true)
+	{
+		const size_t read = std::fread(chunk.data(), 1, chunk.size(), f);
+		data_.insert(data_.end(), chunk.data(), chunk.data() + read);
+		if(read < chunk.size())
+		{
+			break;
+		}
+	}
+	std::fclose(f);
+
+	is_valid_ = ReadHeader();
+}
+
+bool ReplayInputSource::IsFinished() const
+{
+	return !is_valid_ || has_read_error_ || position_ >= data_.size();
+}
+
+void ReplayInputSource::GenerateInput(const uint64_t tick, InputFrame& input)
+{
+	expected_state_hash_ = std::nullopt;
+	if(IsFinished())
+	{
+		return;
+	}
+
+	uint64_t num_events = 0;
+	if(!ReadVarInt(num_events))
+	{
+		return;
+	}
+
+	for(uint64_t i = 0; i < num_events; ++i)
+	{
+		if(position_ >= data_.size())
+		{
+			has_read_error_ = true;
+			return;
+		}
+		const auto type = EventType(data_[position_]);
+		++position_;
+
+		SDL_Event event{};
+		uint64_t value0 = 0, value1 = 0;
+		switch(type)
+		{
+		case EventType::Quit:
+			event.type = SDL_QUIT;
+			break;
+		case EventType::KeyDown:
+		case EventType::KeyUp:
+			if(!ReadVarInt(value0))
+			{
+				return;
+			}
+			event.type = type == EventType::KeyDown ? SDL_KEYDOWN : SDL_KEYUP;
+			event.key.timestamp = uint32_t(tick);
+			event.key.state = type == EventType::KeyDown ? SDL_PRESSED : SDL_RELEASED;
+			event.key.repeat = uint8_t(value0 & 1);
+			event.key.keysym.scancode = SDL_Scancode(value0 >> 1);
+			break;
+		case EventType::MouseMotion:
+			if(!ReadVarInt(value0) || !ReadVarInt(value1))
+			{
+				return;
+			}
+			event.type = SDL_MOUSEMOTION;
+			event.motion.timestamp = uint32_t(tick);
+			event.motion.xrel = ZigZagDecode(value0);
+			event.motion.yrel = ZigZagDecode(value1);
+			break;
+		case EventType::MouseButtonDown:
+		case EventType::MouseButtonUp:
+			if(!ReadVarInt(value0))
+			{
+				return;
+			}
+			event.type = type == EventType::MouseButtonDown ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+			event.button.timestamp = uint32_t(tick);
+			event.button.state = type == EventType::MouseButtonDown ? SDL_PRESSED : SDL_RELEASED;
+			event.button.button = uint8_t(value0);
+			break;
+		default:
+			has_read_error_ = true;
+			return;
+		}
+		if(!input.AddEvent(event))
+		{
+			// Recorded tick has more events than supported.
+			has_read_error_ = true;
+			return;
+		}
+	}
+
+	uint64_t num_changes = 0;
+	if(!ReadVarInt(num_changes))
+	{
+		return;
+	}
+
+	InputFrame::KeyboardState& keyboard_state = input.GetKeyboardState();
+	uint64_t scancode = 0;
+	for(uint64_t i = 0; i < num_changes; ++i)
+	{
+		uint64_t delta = 0;
+		if(!ReadVarInt(delta))
+		{
+			return;
+		}
+		scancode += delta;
+		if(scancode >= keyboard_state.size())
+		{
+			has_read_error_ = true;
+			return;
+		}
+		keyboard_state.flip(size_t(scancode));
+	}
+
+	if(header_.state_hash_interval != 0 && (tick + 1) % header_.state_hash_interval == 0)
+	{
+		StateHasher::HashType hash = 0;
+		if(position_ + sizeof(hash) > data_.size())
+		{
+			// Recording may stop right after last tick input.
+			position_ = data_.size();
+			return;
+		}
+		for(size_t i = 0; i < sizeof(hash); ++i)
+		{
+			hash |= StateHasher::HashType(data_[position_ + i]) << (i * 8);
+		}
+		position_ += sizeof(hash);
+		expected_state_hash_ = hash;
+	}
+}
+
+bool ReplayInputSource::ReadVarInt(uint64_t& out_value)
+{
+	out_value = 0;
+	for(uint32_t shift = 0; shift < 64; shift += 7)
+	{
+		if(position_ >= data_.size())
+		{
+			break;
+		}
+		const uint8_t byte = data_[position_];
+		++position_;
+		out_value |= uint64_t(byte & 0x7F) << shift;
+		if((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	has_read_error_ = true;
+	return false;
+}
+
+bool ReplayInputSource::ReadHeader()
+{
+	if(data_.size() < sizeof(g_magic) || std::memcmp(data_.data(), g_magic, sizeof(g_magic)) != 0)
+	{
+		return false;
+	}
+	position_ = sizeof(g_magic);
+
+	uint64_t version = 0, seed = 0, sample_rate = 0, opened_games_mask = 0, current_game = 0, start_game = 0, state_hash_interval = 0;
+	if(!(ReadVarInt(version) && version == g_version &&
+		ReadVarInt(seed) &&
+		ReadVarInt(sample_rate) &&
+		ReadVarInt(opened_games_mask) &&
+		ReadVarInt(current_game) &&
+		ReadVarInt(start_game) &&
+		ReadVarInt(state_hash_interval)))
+	{
+		return false;
+	}
+
+	if(current_game >= uint64_t(GameId::NumGames) || start_game > uint64_t(GameId::NumGames))
+	{
+		return false;
+	}
+
+	header_.seed = Rand::RandResultType(seed);
+	header_.sample_rate = uint32_t(sample_rate);
+	header_.progress.opened_games_mask = uint32_t(opened_games_mask);
+	header_.progress.current_game = GameId(current_game);
+	header_.start_game = start_game == 0 ? std::nullopt : std::optional<GameId>(GameId(start_game - 1));
+	header_.state_hash_interval = uint32_t(state_hash_interval);
+
+	return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "GameInterface.hpp"
+#include "InputSource.hpp"
+#include "Progress.hpp"
+#include "StateHash.hpp"
+#include <array>
+#include <bitset>
+#include <cstdio>
+#include <optional>
+
+// Replay file format. Integers are unsigned LEB128 varints, signed values are zigzag-encoded.
+// Header:
+//   magic "VRPL", version, seed, sample rate, progress (opened games mask, current game),
+//   start game (0 - main menu, game id + 1 otherwise), state hash interval.
+// For each tick:
+//   number of events, events (type + type-specific payload),
+//   number of keyboard state changes, scancodes of changed keys (ascending, delta-encoded),
+//   state hash (8 bytes, little-endian) if this tick number + 1 is multiple of state hash interval.
+// Only events used by games are recorded, all other events are skipped.
+// Events, including mouse motion, are written in order of arrival.
+
+struct ReplayHeader
+{
+	Rand::RandResultType seed = 0;
+	uint32_t sample_rate = 0;
+	Progress progress;
+	std::optional<GameId> start_game;
+	uint32_t state_hash_interval = GameInterface::c_update_frequency;
+};
+
+// Streaming replay writer. Uses fixed-size buffer and performs no allocations per tick.
+class ReplayWriter
+{
+public:
+	ReplayWriter(const char* file_name, const ReplayHeader& header);
+	~ReplayWriter();
+
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+	bool IsOpen() const { return file_ != nullptr; }
+
+	void WriteTickInput(const InputFrame& input);
+
+	// Returns true if state hash must be written for last written tick.
+	bool NeedStateHash() const;
+	void WriteStateHash(StateHasher::HashType hash);
+
+	// Flush buffered data and close file. Returns false if any write failed.
+	bool Finish();
+
+private:
+	void WriteVarInt(uint64_t value);
+	void WriteByte(uint8_t value);
+	// Flush buffer if it can't fit given number of bytes.
+	void Reserve(size_t size);
+	void Flush();
+
+private:
+	// Enough to fit any single item.
+	static constexpr size_t c_min_free_space = 16;
+
+private:
+	std::FILE* file_ = nullptr;
+	const uint32_t state_hash_interval_;
+	uint64_t num_ticks_ = 0;
+	InputFrame::KeyboardState prev_keyboard_state_;
+	std::array<uint8_t, 4096> buffer_{};
+	size_t buffer_size_ = 0;
+	bool write_error_ = false;
+};
+
+// Reads whole replay file and provides its input tick by tick.
+class ReplayInputSource final : public InputSourceInterface
+{
+public:
+	explicit ReplayInputSource(const char* file_name);
+
+	// Returns false if file is missing or has invalid header.
+	bool IsValid() const { return is_valid_; }
+	const ReplayHeader& GetHeader() const { return header_; }
+
+	// Returns true if there is no more recorded ticks.
+	bool IsFinished() const;
+
+	// Returns hash of state after last generated tick, if it is present.
+	std::optional<StateHasher::HashType> GetExpectedStateHash() const { return expected_state_hash_; }
+
+public: // InputSourceInterface
+	virtual void GenerateInput(uint64_t tick, InputFrame& input) override;
+
+private:
+	bool ReadVarInt(uint64_t& out_value);
+	bool ReadHeader();
+
+private:
+	std::vector<uint8_t> data_;
+	size_t position_ = 0;
+	bool is_valid_ = false;
+	bool has_read_error_ = false;
+	ReplayHeader header_;
+	std::optional<StateHasher::HashType> expected_state_hash_;
+};
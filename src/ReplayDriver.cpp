@@ -0,0 +1,122 @@
+#include "ReplayDriver.hpp"
+#include "Host.hpp"
+#include "PlatformHeadless.hpp"
+#include "PlatformSDL.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+int RunRecording(const int argc, const char* const* const argv)
+{
+	if(argc < 1)
+	{
+		std::fprintf(stderr, "Expected replay file name\n");
+		return 1;
+	}
+
+	// Seed must be set before creation of any game.
+	ReplayHeader header;
+	header.seed = std::random_device()();
+	Rand::SetDeterministicSeed(header.seed);
+
+	SystemWindowSettings window_settings;
+	window_settings.num_post_process_threads = WorkerPool::GetDefaultNumThreads();
+	auto platform = std::make_unique<PlatformSDL>(window_settings);
+	header.sample_rate = platform->GetSoundOut().GetSampleRate();
+	header.progress = LoadProgress();
+
+	ReplayWriter replay_writer(argv[0], header);
+	if(!replay_writer.IsOpen())
+	{
+		std::fprintf(stderr, "Can't open \"%s\"\n", argv[0]);
+		return 1;
+	}
+
+	Host host(std::move(platform), header.start_game);
+	host.StartRecording(replay_writer);
+	while(!host.Loop()){}
+
+	// Truncated replay would be reported as desync later, so report it now.
+	if(!replay_writer.Finish())
+	{
+		std::fprintf(stderr, "Error writing \"%s\"\n", argv[0]);
+		return 1;
+	}
+
+	return 0;
+}
+
+int RunReplay(const int argc, const char* const* const argv)
+{
+	if(argc < 1)
+	{
+		std::fprintf(stderr, "Expected replay file name\n");
+		return 1;
+	}
+	const bool quiet = argc >= 2 && std::strcmp(argv[1], "--quiet") == 0;
+
+	auto input_source = std::make_unique<ReplayInputSource>(argv[0]);
+	if(!input_source->IsValid())
+	{
+		std::fprintf(stderr, "Can't load replay \"%s\"\n", argv[0]);
+		return 1;
+	}
+
+	// Keep pointer in order to access replay after passing ownership to platform.
+	ReplayInputSource& replay = *input_source;
+	const ReplayHeader& header = replay.GetHeader();
+
+	Rand::SetDeterministicSeed(header.seed);
+	UseInMemoryProgress(header.progress);
+
+	Host host(std::make_unique<PlatformHeadless>(std::move(input_source), header.sample_rate), header.start_game);
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	uint64_t num_ticks = 0;
+	uint64_t num_checked_hashes = 0;
+	bool desync = false;
+	while(!replay.IsFinished())
+	{
+		const bool quit = host.Loop();
+		++num_ticks;
+
+		if(const auto expected_hash = replay.GetExpectedStateHash())
+		{
+			const StateHasher::HashType hash = host.CalculateStateHash();
+			if(!quiet)
+			{
+				std::printf("tick %8" PRIu64 ": %016" PRIx64 "\n", num_ticks, hash);
+			}
+			if(hash != *expected_hash)
+			{
+				std::printf(
+					"Desync at tick %" PRIu64 ": expected %016" PRIx64 ", got %016" PRIx64 "\n",
+					num_ticks,
+					*expected_hash,
+					hash);
+				desync = true;
+				break;
+			}
+			++num_checked_hashes;
+		}
+
+		if(quit)
+		{
+			break;
+		}
+	}
+
+	const double duration_s = std::chrono::duration<double>(Clock::now() - start_time).count();
+	std::printf(
+		"%" PRIu64 " ticks (%" PRIu64 " hashes checked) in %.3f s: %.1f ticks/s, %.2f us/tick\n",
+		num_ticks,
+		num_checked_hashes,
+		duration_s,
+		double(num_ticks) / duration_s,
+		duration_s * 1.0e6 / double(std::max(num_ticks, uint64_t(1))));
+
+	return desync ? 1 : 0;
+}
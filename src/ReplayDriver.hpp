@@ -0,0 +1,10 @@
+#pragma once
+
+// Play normally and record input and state hashes into replay file.
+// Arguments: <file name>.
+int RunRecording(int argc, const char* const* argv);
+
+// Play replay on headless platform as fast as possible, check state hashes and print throughput.
+// Stops at first desync. Can be used as benchmark with real input.
+// Arguments: <file name> [--quiet].
+int RunReplay(int argc, const char* const* argv);
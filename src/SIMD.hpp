@@ -0,0 +1,22 @@
+#pragma once
+
+// Detection of SIMD instruction sets available for target architecture.
+// Availability of optional instruction sets (like AVX2) should be checked in runtime before use.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define SIMD_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define TARGET_SSE2
+		#define TARGET_AVX2
+	#else
+		// Allow using intrinsics without enabling instruction sets for whole program.
+		#define TARGET_SSE2 __attribute__((target("sse2")))
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	// NEON is mandatory for AArch64.
+	#define SIMD_NEON
+	#include <arm_neon.h>
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded queue for one producer thread and one consumer thread.
+template<typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of two");
+
+public:
+	// Returns false if queue is full.
+	bool Push(const T& value)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if(tail - head_.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		items_[tail % Capacity] = value;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false if queue is empty.
+	bool Pop(T& out_value)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if(head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		out_value = items_[head % Capacity];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	std::array<T, Capacity> items_{};
+	// Separate cache lines in order to avoid false sharing between producer and consumer.
+	alignas(64) std::atomic<size_t> head_{0};
+	alignas(64) std::atomic<size_t> tail_{0};
+};
@@ -0,0 +1,268 @@
+#include "ScalingBenchmark.hpp"
+#include "CrtEffect.hpp"
+#include "FrameBuffer.hpp"
+#include "ImageScaling.hpp"
+#include "StateHash.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+const uint32_t g_default_num_iterations = 200;
+
+// Hashes of reference CRT effect output for test image for each scale.
+// Should be updated only if CRT effect itself is changed intentionally.
+const StateHasher::HashType g_crt_golden_hashes[g_max_image_scale]
+{
+	0xe323f1a2a930ec6a, 0x37e8b70df611e3ea, 0x01432f0a0817e3bf,
+	0xc78b5ae2c4ba0a6d, 0xc0e6b13876448c00, 0xf07751e25db50615,
+};
+
+// Returns time of single iteration in seconds.
+template<typename Func>
+double MeasureTime(const uint32_t num_iterations, const Func& func)
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	for(uint32_t i = 0; i < num_iterations; ++i)
+	{
+		func();
+	}
+
+	return std::chrono::duration<double>(Clock::now() - start_time).count() / double(num_iterations);
+}
+
+double MeasureKernel(
+	const ImageScalingKernel kernel,
+	const bool use_non_temporal_stores,
+	const uint32_t scale,
+	const uint32_t num_iterations,
+	const std::vector<ColorIndex>& src,
+	const Palette& palette,
+	std::vector<Color32>& dst,
+	WorkerPool& worker_pool)
+{
+	const uint32_t dst_stride = g_framebuffer_width * scale;
+	return MeasureTime(
+		num_iterations,
+		[&]
+		{
+			worker_pool.ParallelForBands(
+				g_framebuffer_height,
+				[&](const uint32_t band_index, const uint32_t y_begin, const uint32_t y_end)
+				{
+					(void)band_index;
+					CopyImageWithScale(
+						kernel,
+						use_non_temporal_stores,
+						scale,
+						src.data() + y_begin * g_framebuffer_width,
+						g_framebuffer_width,
+						y_end - y_begin,
+						g_framebuffer_width,
+						palette,
+						dst.data() + y_begin * scale * dst_stride,
+						dst_stride);
+				});
+		});
+}
+
+double MeasureCrtEffectKernel(
+	CrtEffect& crt_effect,
+	const ImageScalingKernel kernel,
+	const uint32_t scale,
+	const uint32_t num_iterations,
+	const std::vector<ColorIndex>& src,
+	const Palette& palette,
+	std::vector<Color32>& dst,
+	WorkerPool& worker_pool)
+{
+	return MeasureTime(
+		num_iterations,
+		[&]
+		{
+			crt_effect.Apply(
+				kernel,
+				scale,
+				src.data(),
+				g_framebuffer_width,
+				g_framebuffer_height,
+				g_framebuffer_width,
+				0,
+				g_framebuffer_height,
+				palette,
+				dst.data(),
+				g_framebuffer_width * scale,
+				worker_pool);
+		});
+}
+
+StateHasher::HashType CalculateImageHash(const std::vector<Color32>& image, const size_t size)
+{
+	StateHasher hasher;
+	for(size_t i = 0; i < size; ++i)
+	{
+		hasher.Add(image[i]);
+	}
+
+	return hasher.GetHash();
+}
+
+} // namespace
+
+int RunScalingBenchmark(const int argc, const char* const* const argv)
+{
+	const uint32_t num_iterations =
+		std::max(argc >= 1 ? uint32_t(std::strtoul(argv[0], nullptr, 10)) : g_default_num_iterations, 1u);
+
+	// Palette with all components and all entries different.
+	Palette palette;
+	for(size_t i = 0; i < palette.size(); ++i)
+	{
+		palette[i] = Color32(i * 2654435761u);
+	}
+
+	std::vector<ColorIndex> src(g_framebuffer_width * g_framebuffer_height);
+	for(size_t i = 0; i < src.size(); ++i)
+	{
+		// Some non-repeating pattern to detect wrong pixel order.
+		src[i] = ColorIndex((i * 2654435761u) >> 24);
+	}
+
+	const size_t dst_size = src.size() * g_max_image_scale * g_max_image_scale;
+	std::vector<Color32> dst_reference(dst_size);
+	std::vector<Color32> dst(dst_size);
+
+	const ImageScalingKernel best_kernel = GetBestImageScalingKernel();
+	WorkerPool single_thread_pool(0);
+	WorkerPool worker_pool(
+		argc >= 2 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : WorkerPool::GetDefaultNumThreads());
+
+	std::printf(
+		"Best kernel: %s, threads: %u\n", GetImageScalingKernelName(best_kernel), worker_pool.GetConcurrency());
+
+	bool all_results_are_equal = true;
+	for(uint32_t scale = 1; scale <= g_max_image_scale; ++scale)
+	{
+		const double reference_time_s =
+			MeasureKernel(
+				ImageScalingKernel::Scalar, false, scale, num_iterations, src, palette, dst_reference, single_thread_pool);
+
+		for(uint32_t k = 0; k < uint32_t(ImageScalingKernel::NumKernels); ++k)
+		{
+			const auto kernel = ImageScalingKernel(k);
+			if(!IsImageScalingKernelSupported(kernel))
+			{
+				continue;
+			}
+
+			for(const bool use_non_temporal_stores : {false, true})
+			{
+				// Only x86 kernels have non-temporal variants.
+				if(use_non_temporal_stores && !(kernel == ImageScalingKernel::SSE2 || kernel == ImageScalingKernel::AVX2))
+				{
+					continue;
+				}
+
+				std::fill(dst.begin(), dst.end(), 0);
+				const double time_s =
+					MeasureKernel(kernel, use_non_temporal_stores, scale, num_iterations, src, palette, dst, single_thread_pool);
+
+				const bool is_equal = dst == dst_reference;
+				all_results_are_equal &= is_equal;
+
+				const double dst_bytes = double(src.size() * scale * scale * sizeof(Color32));
+				std::printf(
+					"scale %u %-6s %-13s %8.3f ms %7.2f GB/s %6.2fx%s\n",
+					scale,
+					GetImageScalingKernelName(kernel),
+					use_non_temporal_stores ? "non-temporal" : "",
+					time_s * 1.0e3,
+					dst_bytes / time_s * 1.0e-9,
+					reference_time_s / time_s,
+					is_equal ? "" : " MISMATCH");
+			}
+		}
+
+		std::fill(dst.begin(), dst.end(), 0);
+		const double time_s = MeasureKernel(best_kernel, false, scale, num_iterations, src, palette, dst, worker_pool);
+
+		const bool is_equal = dst == dst_reference;
+		all_results_are_equal &= is_equal;
+
+		std::printf(
+			"scale %u %-6s %-13s %8.3f ms %23.2fx%s\n",
+			scale,
+			GetImageScalingKernelName(best_kernel),
+			"threaded",
+			time_s * 1.0e3,
+			reference_time_s / time_s,
+			is_equal ? "" : " MISMATCH");
+	}
+
+	CrtEffect crt_effect;
+	for(uint32_t scale = 1; scale <= g_max_image_scale; ++scale)
+	{
+		std::fill(dst_reference.begin(), dst_reference.end(), 0);
+		const double reference_time_s =
+			MeasureCrtEffectKernel(
+				crt_effect, ImageScalingKernel::Scalar, scale, num_iterations, src, palette, dst_reference, single_thread_pool);
+
+		const StateHasher::HashType hash = CalculateImageHash(dst_reference, src.size() * scale * scale);
+		const bool is_golden = hash == g_crt_golden_hashes[scale - 1];
+		all_results_are_equal &= is_golden;
+		std::printf("scale %u CRT reference hash %016" PRIx64 "%s\n", scale, hash, is_golden ? "" : " MISMATCH");
+
+		for(uint32_t k = 0; k < uint32_t(ImageScalingKernel::NumKernels); ++k)
+		{
+			const auto kernel = ImageScalingKernel(k);
+			if(!IsImageScalingKernelSupported(kernel))
+			{
+				continue;
+			}
+
+			std::fill(dst.begin(), dst.end(), 0);
+			const double time_s =
+				MeasureCrtEffectKernel(crt_effect, kernel, scale, num_iterations, src, palette, dst, single_thread_pool);
+
+			const bool is_equal = dst == dst_reference;
+			all_results_are_equal &= is_equal;
+
+			std::printf(
+				"scale %u CRT %-6s %8.3f ms %6.2fx%s\n",
+				scale,
+				GetImageScalingKernelName(kernel),
+				time_s * 1.0e3,
+				reference_time_s / time_s,
+				is_equal ? "" : " MISMATCH");
+		}
+
+		std::fill(dst.begin(), dst.end(), 0);
+		const double time_s = MeasureCrtEffectKernel(crt_effect, best_kernel, scale, num_iterations, src, palette, dst, worker_pool);
+
+		const bool is_equal = dst == dst_reference;
+		all_results_are_equal &= is_equal;
+
+		std::printf(
+			"scale %u CRT %-6s %8.3f ms %6.2fx threaded%s\n",
+			scale,
+			GetImageScalingKernelName(best_kernel),
+			time_s * 1.0e3,
+			reference_time_s / time_s,
+			is_equal ? "" : " MISMATCH");
+	}
+
+	if(!all_results_are_equal)
+	{
+		std::fprintf(stderr, "Some kernels produced results different from reference\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Measure speed of each supported image scaling and CRT effect kernel for each scale and compare results with reference kernel.
+// Reference CRT effect output is also checked against known hashes.
+// Best kernel is also measured with work split between worker threads.
+// Arguments: [number of iterations] [number of worker threads].
+int RunScalingBenchmark(int argc, const char* const* argv);
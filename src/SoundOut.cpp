@@ -1,4 +1,5 @@
 #include "SoundOut.hpp"
+#include "Trace.hpp"
 #include <SDL.h>
 #include <cassert>
 
@@ -77,8 +78,19 @@ SoundOut::SoundOut()
 	SDL_PauseAudioDevice(device_id_ , 0);
 }
 
+SoundOut::SoundOut(const uint32_t null_sink_sample_rate)
+	: sample_rate_(null_sink_sample_rate)
+	, is_null_sink_(true)
+{
+}
+
 SoundOut::~SoundOut()
 {
+	if(is_null_sink_)
+	{
+		return;
+	}
+
 	if(device_id_ >= g_first_valid_device_id)
 		SDL_CloseAudioDevice(device_id_);
 
@@ -133,14 +145,30 @@ void SoundOut::DecreaseVolume()
 	SetVolume(Fixed16Div(volume_.load(), g_volume_step));
 }
 
+void SoundOut::ConsumeSamples(uint32_t sample_count)
+{
+	assert(is_null_sink_);
+
+	SampleType buffer[1024];
+	while(sample_count > 0)
+	{
+		const uint32_t samples_to_fill = std::min(sample_count, uint32_t(std::size(buffer)));
+		FillAudioBuffer(buffer, samples_to_fill);
+		sample_count -= samples_to_fill;
+	}
+}
+
 void SDLCALL SoundOut::AudioCallback(void* const userdata, Uint8* const stream, int len_bytes)
 {
 	const auto self = reinterpret_cast<SoundOut*>(userdata);
+	TRACE_THREAD_NAME("Audio");
 	self->FillAudioBuffer(reinterpret_cast<SampleType*>(stream), uint32_t(len_bytes) / sizeof(SampleType));
 }
 
 void SoundOut::FillAudioBuffer(SampleType* const buffer, const uint32_t sample_count)
 {
+	TRACE_ZONE("SoundOut::FillAudioBuffer");
+
 	// Zero buffer.
 	for(uint32_t i= 0u; i < sample_count; ++i)
 	{
@@ -11,10 +11,15 @@ struct SoundData
 	std::vector<SampleType> samples;
 };
 
+// Methods may be called from any thread - channel is protected by audio device lock, volume is atomic.
 class SoundOut final
 {
 public:
+	// Opens real audio device.
 	SoundOut();
+	// Creates null sink without audio device.
+	// Samples are consumed only via "ConsumeSamples" calls, so this sink may be driven by virtual clock.
+	explicit SoundOut(uint32_t null_sink_sample_rate);
 	~SoundOut();
 
 	SoundOut(const SoundOut&) = delete;
@@ -31,6 +36,9 @@ public:
 	void IncreaseVolume();
 	void DecreaseVolume();
 
+	// Mix and discard given number of samples, like audio device does. Use it only for null sink.
+	void ConsumeSamples(uint32_t sample_count);
+
 private:
 	struct Channel
 	{
@@ -50,6 +58,7 @@ private:
 private:
 	SDL_AudioDeviceID device_id_ = 0u;
 	uint32_t sample_rate_= 0u; // samples per second
+	const bool is_null_sink_ = false;
 
 	std::atomic<fixed16_t> volume_{g_fixed16_one / 2};
 
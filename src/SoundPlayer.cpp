@@ -1,11 +1,14 @@
 #include "SoundPlayer.hpp"
+#include "Assets.hpp"
 #include "SoundsGeneration.hpp"
 #include "MIDI.hpp"
-#include "Music.hpp"
+#include "Trace.hpp"
 
 SoundPlayer::SoundPlayer(SoundOut& sound_out)
 	: sound_out_(sound_out)
 {
+	TRACE_ZONE("SoundPlayer::GenerateSounds");
+
 	using GenFunc= SoundData(*)(uint32_t frequency);
 	static constexpr GenFunc c_gen_funcs[size_t(SoundId::NumSounds)]
 	{
@@ -25,20 +28,23 @@ SoundPlayer::SoundPlayer(SoundOut& sound_out)
 		sounds_[i] = c_gen_funcs[i](sound_out_.GetSampleRate());
 	}
 
-	static const constexpr std::pair<const uint8_t*, size_t> c_music_data[]
+	static constexpr AssetId c_music_assets[size_t(MusicId::NumMelodies)]
 	{
-		{Music::in_taberna, std::size(Music::in_taberna)},
-		{Music::herr_mannelig, std::size(Music::herr_mannelig)},
-		{Music::ritt_der_toten, std::size(Music::ritt_der_toten)},
-		{Music::du_hast_den_farbfilm_vergessen, std::size(Music::du_hast_den_farbfilm_vergessen)},
-		{Music::in_meinem_raum, std::size(Music::in_meinem_raum)},
-		{Music::heavy_metal, std::size(Music::heavy_metal)},
-		{Music::preussens_gloria, std::size(Music::preussens_gloria)},
+		AssetId::music_in_taberna,
+		AssetId::music_herr_mannelig,
+		AssetId::music_ritt_der_toten,
+		AssetId::music_du_hast_den_farbfilm_vergessen,
+		AssetId::music_in_meinem_raum,
+		AssetId::music_heavy_metal,
+		AssetId::music_preussens_gloria,
 	};
 
 	for(size_t i= 0; i < size_t(MusicId::NumMelodies); ++i)
 	{
-		music_[i] = MakeMIDISound(c_music_data[i].first, c_music_data[i].second, sound_out_.GetSampleRate());
+		const AssetData midi = GetAssetData(c_music_assets[i]);
+		music_[i] = MakeMIDISound(midi.data, midi.size, sound_out_.GetSampleRate());
+		// MIDI data isn't needed after synthesis.
+		ReleaseAssetData(c_music_assets[i]);
 	}
 }
 
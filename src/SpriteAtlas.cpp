@@ -0,0 +1,202 @@
+#include "SpriteAtlas.hpp"
+#include "Assets.hpp"
+#include "SpriteBMP.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+
+const AssetId g_sprites_assets[]
+{
+#define SPRITE(name) AssetId::sprite_##name,
+#include "SpritesList.hpp"
+#undef SPRITE
+};
+
+static_assert(std::size(g_sprites_assets) == size_t(SpriteId::NumSprites), "Wrong sprites list");
+
+constexpr const uint32_t c_cache_line_size = 64;
+constexpr const uint32_t c_pixels_alignment = c_cache_line_size / uint32_t(sizeof(ColorIndex));
+
+template<typename T>
+T* AlignPointer(T* const ptr)
+{
+	const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+	return reinterpret_cast<T*>((address + (c_cache_line_size - 1)) & ~uintptr_t(c_cache_line_size - 1));
+}
+
+ColorIndex GetCGAColorIndex(const Color32 color)
+{
+	const int32_t index = FindCGAColorIndex(color);
+	assert(index >= 0 && "Sprite has non-CGA color");
+	return ColorIndex(std::max(index, 0));
+}
+
+} // namespace
+
+AssetId GetSpriteAssetId(const SpriteId id)
+{
+	return g_sprites_assets[size_t(id)];
+}
+
+const SpriteAtlas& SpriteAtlas::GetInstance()
+{
+	static const SpriteAtlas atlas;
+	return atlas;
+}
+
+SpriteAtlas::SpriteAtlas()
+{
+	TRACE_ZONE("SpriteAtlas::Build");
+
+	// Source BMPs are held until decoding of each sprite is finished.
+	const uint8_t* sprites_data[std::size(g_sprites_assets)];
+
+	uint32_t total_pixels = 0;
+	for(size_t i = 0; i < std::size(g_sprites_assets); ++i)
+	{
+		sprites_data[i] = GetAssetData(g_sprites_assets[i]).data;
+		const SpriteBMP sprite(sprites_data[i]);
+		assert(sprite.GetWidth () <= 0xFFFF);
+		assert(sprite.GetHeight() <= 0xFFFF);
+
+		// Storing all orientations of large sprites costs a lot of memory, but they are rarely (or never) drawn transformed.
+		const bool store_all_orientations =
+			sprite.GetWidth() <= c_max_small_sprite_size && sprite.GetHeight() <= c_max_small_sprite_size;
+
+		for(uint32_t o = 0; o < uint32_t(SpriteOrientation::NumOrientations); ++o)
+		{
+			SpriteInfo& info = sprites_info_[i][o];
+			info.is_stored = store_all_orientations || SpriteOrientation(o) == SpriteOrientation::Identity;
+			info.offset = info.is_stored ? total_pixels : sprites_info_[i][size_t(SpriteOrientation::Identity)].offset;
+			if(IsTransposedOrientation(SpriteOrientation(o)))
+			{
+				info.width  = uint16_t(sprite.GetHeight());
+				info.height = uint16_t(sprite.GetWidth ());
+			}
+			else
+			{
+				info.width  = uint16_t(sprite.GetWidth ());
+				info.height = uint16_t(sprite.GetHeight());
+			}
+
+			if(info.is_stored)
+			{
+				total_pixels += (uint32_t(info.width) * uint32_t(info.height) + (c_pixels_alignment - 1)) & ~(c_pixels_alignment - 1);
+			}
+		}
+	}
+
+	// Reserve space for alignment of atlas start.
+	pixels_storage_.resize(total_pixels + c_pixels_alignment);
+	alpha_mask_storage_.resize(total_pixels + c_cache_line_size);
+	ColorIndex* const pixels = AlignPointer(pixels_storage_.data());
+	uint8_t* const alpha_mask = AlignPointer(alpha_mask_storage_.data());
+	pixels_ = pixels;
+	alpha_mask_ = alpha_mask;
+
+	for(size_t i = 0; i < std::size(g_sprites_assets); ++i)
+	{
+		const SpriteBMP sprite(sprites_data[i]);
+		const SpriteInfo& info = sprites_info_[i][size_t(SpriteOrientation::Identity)];
+		const uint32_t stride = sprite.GetRowStride();
+		const Color32* const palette = sprite.GetPalette();
+		const uint8_t* const data = sprite.GetImageData();
+
+		// Remap sprite palette into CGA palette. Only used entries are remapped, since palette may be shorter than 256 entries.
+		int16_t palette_remap[256];
+		std::fill(std::begin(palette_remap), std::end(palette_remap), int16_t(-1));
+
+		for(uint32_t y = 0; y < info.height; ++y)
+		{
+			// BMP rows are stored bottom-up.
+			const uint8_t* const src_line = data + (info.height - 1 - y) * stride;
+			ColorIndex* const dst_line = pixels + info.offset + y * info.width;
+			uint8_t* const dst_mask_line = alpha_mask + info.offset + y * info.width;
+			for(uint32_t x = 0; x < info.width; ++x)
+			{
+				const uint8_t color_index = src_line[x];
+				if(palette_remap[color_index] < 0)
+				{
+					// Palette in BMP file isn't aligned.
+					Color32 color = 0;
+					std::memcpy(&color, palette + color_index, sizeof(Color32));
+					palette_remap[color_index] = GetCGAColorIndex(color);
+				}
+				dst_line[x] = ColorIndex(palette_remap[color_index]);
+				dst_mask_line[x] = color_index == c_transparent_color_index ? 0x00 : 0xFF;
+			}
+		}
+
+		// Other orientations are produced from decoded sprite.
+		for(uint32_t o = 1; o < uint32_t(SpriteOrientation::NumOrientations); ++o)
+		{
+			const SpriteOrientation orientation = SpriteOrientation(o);
+			const SpriteInfo& dst_info = sprites_info_[i][o];
+			if(!dst_info.is_stored)
+			{
+				continue;
+			}
+			for(uint32_t y = 0; y < dst_info.height; ++y)
+			{
+				for(uint32_t x = 0; x < dst_info.width; ++x)
+				{
+					const uint32_t src_offset = info.offset + GetSourceTexelOffset(orientation, info.width, info.height, x, y);
+					const uint32_t dst_offset = dst_info.offset + x + y * dst_info.width;
+					pixels[dst_offset] = pixels[src_offset];
+					alpha_mask[dst_offset] = alpha_mask[src_offset];
+				}
+			}
+		}
+
+		for(SpriteInfo& dst_info : sprites_info_[i])
+		{
+			if(!dst_info.is_stored)
+			{
+				dst_info.row_spans_index = sprites_info_[i][size_t(SpriteOrientation::Identity)].row_spans_index;
+				continue;
+			}
+
+			dst_info.row_spans_index = uint32_t(row_spans_offsets_.size());
+			for(uint32_t y = 0; y < dst_info.height; ++y)
+			{
+				BuildRowSpans(alpha_mask + dst_info.offset + y * dst_info.width, dst_info.width);
+			}
+		}
+
+		// Source BMP isn't needed anymore.
+		ReleaseAssetData(g_sprites_assets[i]);
+	}
+
+	// End of last row.
+	row_spans_offsets_.push_back(uint32_t(spans_.size()));
+}
+
+void SpriteAtlas::BuildRowSpans(const uint8_t* const alpha_mask_row, const uint32_t width)
+{
+	row_spans_offsets_.push_back(uint32_t(spans_.size()));
+
+	uint32_t x = 0;
+	while(x < width)
+	{
+		while(x < width && alpha_mask_row[x] == 0)
+		{
+			++x;
+		}
+
+		const uint32_t span_start = x;
+		while(x < width && alpha_mask_row[x] != 0)
+		{
+			++x;
+		}
+
+		if(x > span_start)
+		{
+			spans_.push_back({uint16_t(span_start), uint16_t(x - span_start)});
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "Assets.hpp"
+#include "Color.hpp"
+#include "SpriteOrientation.hpp"
+#include <vector>
+
+// Identifiers of all sprites. List is generated from contents of "sprites" directory.
+enum class SpriteId : uint16_t
+{
+#define SPRITE(name) name,
+#include "SpritesList.hpp"
+#undef SPRITE
+	NumSprites
+};
+
+// Asset with source BMP of sprite.
+AssetId GetSpriteAssetId(SpriteId id);
+
+// All sprites decoded once into single block of memory.
+// Rows are stored top-down, pixels are indices in CGA palette, each sprite starts at cache line boundary.
+// Small sprites are stored in all orientations, so that any of them can be drawn by copying rows.
+// Larger sprites are stored only in identity orientation, other orientations are drawn pixel by pixel.
+class SpriteAtlas
+{
+public:
+	// Palette index which is excluded by alpha mask.
+	static constexpr uint8_t c_transparent_color_index = 0;
+
+	struct SpriteInfo
+	{
+		// Offset of first pixel in atlas.
+		uint32_t offset = 0;
+		uint16_t width = 0;
+		uint16_t height = 0;
+		// Index of first row in spans table.
+		uint32_t row_spans_index = 0;
+		// If false, this orientation isn't stored - offset and spans are ones of identity orientation,
+		// texels should be fetched via "GetSourceTexelOffset".
+		bool is_stored = true;
+	};
+
+	// Run of opaque pixels within single row of sprite.
+	struct OpaqueSpan
+	{
+		// Number of pixels from row start.
+		uint16_t start = 0;
+		uint16_t length = 0;
+	};
+
+	struct OpaqueSpansRange
+	{
+		const OpaqueSpan* begin_ = nullptr;
+		const OpaqueSpan* end_ = nullptr;
+
+		const OpaqueSpan* begin() const { return begin_; }
+		const OpaqueSpan* end() const { return end_; }
+	};
+
+public:
+	// Atlas is built on first call.
+	static const SpriteAtlas& GetInstance();
+
+	const SpriteInfo& GetSpriteInfo(const SpriteId id, const SpriteOrientation orientation = SpriteOrientation::Identity) const
+	{
+		return sprites_info_[size_t(id)][size_t(orientation)];
+	}
+
+	const ColorIndex* GetPixels(const SpriteInfo& info) const { return pixels_ + info.offset; }
+	// 0xFF for opaque pixels, 0 for transparent pixels.
+	const uint8_t* GetAlphaMask(const SpriteInfo& info) const { return alpha_mask_ + info.offset; }
+
+	// Opaque spans ordered by start. Blitting them gives the same result as per-pixel alpha mask check.
+	OpaqueSpansRange GetRowSpans(const SpriteInfo& info, const uint32_t y) const
+	{
+		const uint32_t row_index = info.row_spans_index + y;
+		return { spans_.data() + row_spans_offsets_[row_index], spans_.data() + row_spans_offsets_[row_index + 1] };
+	}
+
+private:
+	SpriteAtlas();
+
+	// Append spans of single row to spans table.
+	void BuildRowSpans(const uint8_t* alpha_mask_row, uint32_t width);
+
+private:
+	SpriteInfo sprites_info_[size_t(SpriteId::NumSprites)][size_t(SpriteOrientation::NumOrientations)];
+	std::vector<ColorIndex> pixels_storage_;
+	std::vector<uint8_t> alpha_mask_storage_;
+	// Aligned pointers into storage.
+	const ColorIndex* pixels_ = nullptr;
+	const uint8_t* alpha_mask_ = nullptr;
+	// Spans of all rows of all sprites.
+	std::vector<OpaqueSpan> spans_;
+	// Offset of first span of each row. Has extra element at the end.
+	std::vector<uint32_t> row_spans_offsets_;
+};
+
+// Lightweight handle of sprite in atlas.
+class SpriteHandle
+{
+public:
+	constexpr SpriteHandle(const SpriteId id) : id_(id) {}
+
+	SpriteId GetId() const { return id_; }
+
+	const SpriteAtlas::SpriteInfo& GetInfo() const { return SpriteAtlas::GetInstance().GetSpriteInfo(id_); }
+
+	uint32_t GetWidth () const { return GetInfo().width ; }
+	uint32_t GetHeight() const { return GetInfo().height; }
+
+private:
+	SpriteId id_;
+};
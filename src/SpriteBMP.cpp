@@ -31,6 +31,24 @@ struct SpriteBMP::BitmapInfoHeader
 };
 #pragma pack(pop)
 
+bool SpriteBMP::IsValid(const size_t file_size) const
+{
+	if(file_size < sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader))
+	{
+		return false;
+	}
+
+	const BitmapInfoHeader& info_header = GetInfoHeader();
+	if(info_header.bit_count != 8 || info_header.width <= 0 || info_header.height <= 0)
+	{
+		return false;
+	}
+
+	const size_t image_offset = GetFileHeader().off_bits;
+	const size_t image_end = image_offset + size_t(GetRowStride()) * size_t(GetHeight());
+	return image_offset >= sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader) && image_end <= file_size;
+}
+
 uint32_t SpriteBMP::GetWidth() const
 {
 	return uint32_t(GetInfoHeader().width);
@@ -58,6 +76,12 @@ const Color32* SpriteBMP::GetPalette() const
 	return reinterpret_cast<const Color32*>(file_data_ + sizeof(BitmapFileHeader) + sizeof(BitmapInfoHeader));
 }
 
+uint32_t SpriteBMP::GetPaletteSize() const
+{
+	// Palette is placed between headers and image data.
+	return uint32_t((GetFileHeader().off_bits - sizeof(BitmapFileHeader) - sizeof(BitmapInfoHeader)) / sizeof(Color32));
+}
+
 const SpriteBMP::BitmapFileHeader& SpriteBMP::GetFileHeader() const
 {
 	static_assert(sizeof(SpriteBMP::BitmapFileHeader) == 14, "invalide size");
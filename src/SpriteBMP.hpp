@@ -1,5 +1,6 @@
 #pragma once
 #include "Color.hpp"
+#include <cstddef>
 #include <cstdint>
 
 // Simple wrapper for BMP static data.
@@ -9,12 +10,18 @@ class SpriteBMP
 public:
 	constexpr SpriteBMP(const uint8_t* file_data) : file_data_(file_data) {}
 
+	// Check that file of given size is 8-bit BMP with headers and pixels inside it.
+	// Other methods expect valid file. Pixels may still reference entries past palette end.
+	bool IsValid(size_t file_size) const;
+
 	uint32_t GetWidth() const;
 	uint32_t GetRowStride() const;
 	uint32_t GetHeight() const;
 
 	const uint8_t* GetImageData() const;
 	const Color32* GetPalette() const;
+	// Palette may be shorter than 256 entries.
+	uint32_t GetPaletteSize() const;
 
 private:
 	struct BitmapFileHeader;
@@ -0,0 +1,334 @@
+#include "SpriteBenchmark.hpp"
+#include "Assets.hpp"
+#include "Draw.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+const uint32_t g_default_num_iterations = 200;
+
+using BMPDrawFunc = void(*)(FrameBuffer frame_buffer, SpriteBMP sprite, uint8_t transparent_color_index, uint32_t start_x, uint32_t start_y);
+
+struct Orientation
+{
+	const char* name;
+	BMPDrawFunc reference_func;
+	SpriteWithAlphaDrawFunc func;
+	SpriteOrientation orientation;
+	// Sprite width and height are swapped.
+	bool is_transposed;
+};
+
+const Orientation g_orientations[]
+{
+	{ "identity"  , DrawSpriteWithAlpha         , DrawSpriteWithAlpha         , SpriteOrientation::Identity , false },
+	{ "mirror x"  , DrawSpriteWithAlphaMirrorX  , DrawSpriteWithAlphaMirrorX  , SpriteOrientation::MirrorX  , false },
+	{ "mirror y"  , DrawSpriteWithAlphaMirrorY  , DrawSpriteWithAlphaMirrorY  , SpriteOrientation::MirrorY  , false },
+	{ "rotate 90" , DrawSpriteWithAlphaRotate90 , DrawSpriteWithAlphaRotate90 , SpriteOrientation::Rotate90 , true  },
+	{ "rotate 180", DrawSpriteWithAlphaRotate180, DrawSpriteWithAlphaRotate180, SpriteOrientation::Rotate180, false },
+	{ "rotate 270", DrawSpriteWithAlphaRotate270, DrawSpriteWithAlphaRotate270, SpriteOrientation::Rotate270, true  },
+};
+
+// Returns time of single iteration in seconds.
+template<typename Func>
+double MeasureTime(const uint32_t num_iterations, const Func& func)
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	for(uint32_t i = 0; i < num_iterations; ++i)
+	{
+		func();
+	}
+
+	return std::chrono::duration<double>(Clock::now() - start_time).count() / double(num_iterations);
+}
+
+// Draw all sprites which fit frame buffer, each at own position.
+template<typename Func>
+void DrawAllSprites(const FrameBuffer frame_buffer, const bool is_transposed, const Func& func)
+{
+	for(uint32_t i = 0; i < uint32_t(SpriteId::NumSprites); ++i)
+	{
+		const SpriteHandle sprite = SpriteId(i);
+		const uint32_t w = is_transposed ? sprite.GetHeight() : sprite.GetWidth ();
+		const uint32_t h = is_transposed ? sprite.GetWidth () : sprite.GetHeight();
+		if(w > frame_buffer.width || h > frame_buffer.height)
+		{
+			continue;
+		}
+
+		const uint32_t x = i * 37u % (frame_buffer.width  - w + 1);
+		const uint32_t y = i * 53u % (frame_buffer.height - h + 1);
+		func(i, x, y);
+	}
+}
+
+// Rotate and scale sprite around its center, which is placed at frame buffer center.
+Matrix3 MakeSpriteRotationMatrix(const FrameBuffer frame_buffer, const SpriteHandle sprite, const uint32_t index)
+{
+	const double angle = double(index) * 0.37;
+	const double scale = 0.75 + double(index % 4) * 0.25;
+	const double cos_a = std::cos(angle) / scale;
+	const double sin_a = std::sin(angle) / scale;
+	const double center_x = double(frame_buffer.width ) * 0.5;
+	const double center_y = double(frame_buffer.height) * 0.5;
+	const double sprite_center_x = double(sprite.GetWidth ()) * 0.5;
+	const double sprite_center_y = double(sprite.GetHeight()) * 0.5;
+
+	const auto to_fixed = [](const double d) { return fixed16_t(std::lround(d * double(g_fixed16_one))); };
+
+	Matrix3 matrix;
+	matrix.x = { to_fixed(cos_a), to_fixed(sin_a), to_fixed(sprite_center_x - cos_a * center_x - sin_a * center_y) };
+	matrix.y = { to_fixed(-sin_a), to_fixed(cos_a), to_fixed(sprite_center_y + sin_a * center_x - cos_a * center_y) };
+	return matrix;
+}
+
+// Straightforward transformed drawing - check each frame buffer pixel.
+void DrawSpriteWithAlphaTransformedReference(const FrameBuffer frame_buffer, const SpriteHandle sprite, const Matrix3& tc_matrix)
+{
+	const SpriteAtlas& atlas = SpriteAtlas::GetInstance();
+	const SpriteAtlas::SpriteInfo& info = atlas.GetSpriteInfo(sprite.GetId());
+	const ColorIndex* const pixels = atlas.GetPixels(info);
+	const uint8_t* const alpha_mask = atlas.GetAlphaMask(info);
+
+	for(uint32_t y = 0; y < frame_buffer.height; ++y)
+	{
+		for(uint32_t x = 0; x < frame_buffer.width; ++x)
+		{
+			const int32_t tc_x = Fixed16FloorToInt(int32_t(x) * tc_matrix.x[0] + int32_t(y) * tc_matrix.x[1] + tc_matrix.x[2]);
+			const int32_t tc_y = Fixed16FloorToInt(int32_t(x) * tc_matrix.y[0] + int32_t(y) * tc_matrix.y[1] + tc_matrix.y[2]);
+			if(tc_x >= 0 && tc_y >= 0 && tc_x < int32_t(info.width) && tc_y < int32_t(info.height))
+			{
+				const uint32_t texel_offset = uint32_t(tc_x) + uint32_t(tc_y) * info.width;
+				if(alpha_mask[texel_offset] != 0)
+				{
+					frame_buffer.GetRow(y)[x] = pixels[texel_offset];
+				}
+			}
+		}
+	}
+}
+
+} // namespace
+
+int RunSpriteBenchmark(const int argc, const char* const* const argv)
+{
+	const uint32_t num_iterations =
+		std::max(argc >= 1 ? uint32_t(std::strtoul(argv[0], nullptr, 10)) : g_default_num_iterations, 1u);
+
+	std::vector<ColorIndex> background(g_framebuffer_width * g_framebuffer_height);
+	for(size_t i = 0; i < background.size(); ++i)
+	{
+		background[i] = ColorIndex((i * 2654435761u) >> 24);
+	}
+
+	std::vector<ColorIndex> dst_reference = background;
+	std::vector<ColorIndex> dst = background;
+
+	const FrameBuffer frame_buffer_reference = MakeFrameBuffer(dst_reference.data(), g_framebuffer_width, g_framebuffer_height);
+	const FrameBuffer frame_buffer = MakeFrameBuffer(dst.data(), g_framebuffer_width, g_framebuffer_height);
+
+	// Frame buffer inside larger image, in order to check that stride is respected.
+	const uint32_t padding = 7;
+	std::vector<ColorIndex> dst_padded((g_framebuffer_width + padding * 2) * (g_framebuffer_height + padding * 2));
+	const FrameBuffer frame_buffer_padded =
+		MakeFrameBuffer(dst_padded.data(), g_framebuffer_width + padding * 2, g_framebuffer_height + padding * 2)
+		.GetSubView(padding, padding, g_framebuffer_width, g_framebuffer_height);
+
+	const auto copy_background_to_padded =
+	[&]
+	{
+		for(uint32_t y = 0; y < g_framebuffer_height; ++y)
+		{
+			std::memcpy(
+				frame_buffer_padded.GetRow(y), background.data() + y * g_framebuffer_width, g_framebuffer_width * sizeof(ColorIndex));
+		}
+	};
+
+	const auto padded_is_equal =
+	[&]
+	{
+		for(uint32_t y = 0; y < g_framebuffer_height; ++y)
+		{
+			if(std::memcmp(frame_buffer_padded.GetRow(y), dst.data() + y * g_framebuffer_width, g_framebuffer_width * sizeof(ColorIndex)) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Build atlas first, so that its decoding isn't measured.
+	SpriteAtlas::GetInstance();
+
+	// Keep source BMPs decompressed during benchmark.
+	const uint8_t* sprites_data[size_t(SpriteId::NumSprites)];
+	for(size_t i = 0; i < size_t(SpriteId::NumSprites); ++i)
+	{
+		sprites_data[i] = GetAssetData(GetSpriteAssetId(SpriteId(i))).data;
+	}
+
+	bool all_results_are_equal = true;
+	for(const Orientation& orientation : g_orientations)
+	{
+		dst_reference = background;
+		const double reference_time_s =
+			MeasureTime(
+				num_iterations,
+				[&]
+				{
+					DrawAllSprites(
+						frame_buffer_reference,
+						orientation.is_transposed,
+						[&](const uint32_t index, const uint32_t x, const uint32_t y)
+						{
+							orientation.reference_func(
+								frame_buffer_reference, sprites_data[index], SpriteAtlas::c_transparent_color_index, x, y);
+						});
+				});
+
+		// Generic spans blitter, which is used for sprites without compiled drawing function.
+		dst = background;
+		const double spans_time_s =
+			MeasureTime(
+				num_iterations,
+				[&]
+				{
+					DrawAllSprites(
+						frame_buffer,
+						orientation.is_transposed,
+						[&](const uint32_t index, const uint32_t x, const uint32_t y)
+						{
+							DrawSpriteWithAlphaSpans(frame_buffer, SpriteId(index), orientation.orientation, x, y);
+						});
+				});
+		const bool spans_are_equal = dst == dst_reference;
+
+		// Compiled sprites where available, spans blitter for others.
+		dst = background;
+		const double time_s =
+			MeasureTime(
+				num_iterations,
+				[&]
+				{
+					DrawAllSprites(
+						frame_buffer,
+						orientation.is_transposed,
+						[&](const uint32_t index, const uint32_t x, const uint32_t y)
+						{
+							orientation.func(frame_buffer, SpriteId(index), x, y);
+						});
+				});
+
+		copy_background_to_padded();
+		DrawAllSprites(
+			frame_buffer_padded,
+			orientation.is_transposed,
+			[&](const uint32_t index, const uint32_t x, const uint32_t y)
+			{
+				orientation.func(frame_buffer_padded, SpriteId(index), x, y);
+			});
+
+		const bool is_equal = spans_are_equal && dst == dst_reference && padded_is_equal();
+		all_results_are_equal &= is_equal;
+
+		std::printf(
+			"%-10s BMP %8.3f ms, spans %8.3f ms, compiled %8.3f ms, %6.2fx vs BMP, %6.2fx vs spans%s\n",
+			orientation.name,
+			reference_time_s * 1.0e3,
+			spans_time_s * 1.0e3,
+			time_s * 1.0e3,
+			reference_time_s / time_s,
+			spans_time_s / time_s,
+			is_equal ? "" : " MISMATCH");
+	}
+
+	// Arbitrary rotation and scale.
+	// Reference checks whole frame buffer, so it's measured only once.
+	{
+		dst_reference = background;
+		const double reference_time_s =
+			MeasureTime(
+				1,
+				[&]
+				{
+					for(uint32_t i = 0; i < uint32_t(SpriteId::NumSprites); ++i)
+					{
+						const SpriteHandle sprite = SpriteId(i);
+						DrawSpriteWithAlphaTransformedReference(
+							frame_buffer_reference, sprite, MakeSpriteRotationMatrix(frame_buffer_reference, sprite, i));
+					}
+				});
+
+		// BMP version walks whole bounding box. It uses bottom-up texture coordinates, so only time is compared.
+		dst = background;
+		const double bounding_box_time_s =
+			MeasureTime(
+				num_iterations,
+				[&]
+				{
+					for(uint32_t i = 0; i < uint32_t(SpriteId::NumSprites); ++i)
+					{
+						const SpriteHandle sprite = SpriteId(i);
+						DrawSpriteWithAlphaTransformed(
+							frame_buffer,
+							sprites_data[i],
+							SpriteAtlas::c_transparent_color_index,
+							MakeSpriteRotationMatrix(frame_buffer, sprite, i));
+					}
+				});
+
+		dst = background;
+		const double time_s =
+			MeasureTime(
+				num_iterations,
+				[&]
+				{
+					for(uint32_t i = 0; i < uint32_t(SpriteId::NumSprites); ++i)
+					{
+						const SpriteHandle sprite = SpriteId(i);
+						DrawSpriteWithAlphaTransformed(frame_buffer, sprite, MakeSpriteRotationMatrix(frame_buffer, sprite, i));
+					}
+				});
+
+		copy_background_to_padded();
+		for(uint32_t i = 0; i < uint32_t(SpriteId::NumSprites); ++i)
+		{
+			const SpriteHandle sprite = SpriteId(i);
+			DrawSpriteWithAlphaTransformed(frame_buffer_padded, sprite, MakeSpriteRotationMatrix(frame_buffer_padded, sprite, i));
+		}
+
+		const bool is_equal = dst == dst_reference && padded_is_equal();
+		all_results_are_equal &= is_equal;
+
+		std::printf(
+			"%-10s BMP %8.3f ms, atlas %8.3f ms, %6.2fx%s (all pixels reference %.3f ms)\n",
+			"rotate any",
+			bounding_box_time_s * 1.0e3,
+			time_s * 1.0e3,
+			bounding_box_time_s / time_s,
+			is_equal ? "" : " MISMATCH",
+			reference_time_s * 1.0e3);
+	}
+
+	for(size_t i = 0; i < size_t(SpriteId::NumSprites); ++i)
+	{
+		ReleaseAssetData(GetSpriteAssetId(SpriteId(i)));
+	}
+
+	if(!all_results_are_equal)
+	{
+		std::fprintf(stderr, "Atlas blitters produced results different from BMP blitters\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Measure speed of atlas sprite blitters against BMP blitters on all game sprites and compare results.
+// For orientations atlas spans blitter and compiled sprites are measured separately.
+// Arbitrary transformation is compared against straightforward drawing of each pixel.
+// Atlas blitters are also checked to produce the same result in frame buffer with stride larger than width.
+// Arguments: [number of iterations].
+int RunSpriteBenchmark(int argc, const char* const* argv);
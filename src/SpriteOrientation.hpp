@@ -0,0 +1,60 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+
+// Shared by "SpriteAtlas" and "SpriteCompiler" build tool, so that both produce same pixels for each orientation.
+
+// Sprite transformations which map pixels grid onto itself - mirrorings and rotations by multiples of 90 degrees.
+// Rotations are clockwise.
+enum class SpriteOrientation : uint8_t
+{
+	Identity,
+	MirrorX,
+	MirrorY,
+	Rotate90,
+	Rotate180,
+	Rotate270,
+	NumOrientations,
+};
+
+// Sprites up to this size are stored in all orientations by "SpriteAtlas" and compiled into drawing functions by "SpriteCompiler".
+// Larger sprites (backgrounds, titles, wide blocks) are rarely drawn transformed.
+constexpr const uint32_t c_max_small_sprite_size = 16;
+
+// Width and height are swapped in transposed orientations.
+inline bool IsTransposedOrientation(const SpriteOrientation orientation)
+{
+	return
+		orientation == SpriteOrientation::Rotate90 ||
+		orientation == SpriteOrientation::Rotate270;
+}
+
+// Offset of texel of source sprite with given size, which is placed at (x, y) of sprite with given orientation.
+inline uint32_t GetSourceTexelOffset(
+	const SpriteOrientation orientation,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t x,
+	const uint32_t y)
+{
+	switch(orientation)
+	{
+	case SpriteOrientation::Identity:
+		return x + y * width;
+	case SpriteOrientation::MirrorX:
+		return (width - 1 - x) + y * width;
+	case SpriteOrientation::MirrorY:
+		return x + (height - 1 - y) * width;
+	case SpriteOrientation::Rotate90:
+		return y + (height - 1 - x) * width;
+	case SpriteOrientation::Rotate180:
+		return (width - 1 - x) + (height - 1 - y) * width;
+	case SpriteOrientation::Rotate270:
+		return (width - 1 - y) + x * width;
+	case SpriteOrientation::NumOrientations:
+		break;
+	}
+
+	assert(false);
+	return 0;
+}
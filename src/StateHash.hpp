@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+// Fast non-cryptographic hasher for game state.
+// Used for desync detection in replays, so result must depend only on hashed values, not on memory layout.
+class StateHasher
+{
+public:
+	using HashType = uint64_t;
+
+public:
+	HashType GetHash() const { return hash_; }
+
+	template<typename T>
+	void Add(const T& value)
+	{
+		if constexpr(std::is_integral_v<T> || std::is_enum_v<T>)
+		{
+			AddWord(uint64_t(value));
+		}
+		else
+		{
+			static_assert(std::is_integral_v<T>, "Unsupported type");
+		}
+	}
+
+	template<typename T, size_t N>
+	void Add(const std::array<T, N>& arr)
+	{
+		for(const T& el : arr)
+		{
+			Add(el);
+		}
+	}
+
+	template<typename T, size_t N>
+	void Add(const T (&arr)[N])
+	{
+		for(const T& el : arr)
+		{
+			Add(el);
+		}
+	}
+
+	// Only size of vectors is added. Use it for vectors of structs, which contents are hashed separately.
+	template<typename T>
+	void AddSize(const std::vector<T>& vec)
+	{
+		AddWord(uint64_t(vec.size()));
+	}
+
+	// Adds only presence flag. Use it for optional structs, which contents are hashed separately.
+	template<typename T>
+	void AddPresence(const std::optional<T>& opt)
+	{
+		AddWord(opt == std::nullopt ? 0u : 1u);
+	}
+
+	template<typename T>
+	void Add(const std::optional<T>& opt)
+	{
+		AddPresence(opt);
+		if(opt != std::nullopt)
+		{
+			Add(*opt);
+		}
+	}
+
+	template<typename T>
+	void Add(const std::vector<T>& vec)
+	{
+		AddSize(vec);
+		for(const T& el : vec)
+		{
+			Add(el);
+		}
+	}
+
+	template<typename T0, typename T1, typename ... Tail>
+	void Add(const T0& v0, const T1& v1, const Tail& ... tail)
+	{
+		Add(v0);
+		Add(v1, tail...);
+	}
+
+private:
+	void AddWord(const uint64_t word)
+	{
+		// Rotate, xor and multiply by odd constant (from golden ratio).
+		hash_ = (((hash_ << 5) | (hash_ >> 59)) ^ word) * 0x9E3779B97F4A7C15ull;
+	}
+
+private:
+	HashType hash_ = 0;
+};
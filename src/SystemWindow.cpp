@@ -1,168 +1,36 @@
 #include "SystemWindow.hpp"
+#include "ImageScaling.hpp"
 #include "Strings.hpp"
+#include "Trace.hpp"
 #include <SDL.h>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
 
 namespace
 {
 
-template<uint32_t scale>
-void CopyImageWithScaleImpl(
-	const Color32* src,
-	const uint32_t src_width,
-	const uint32_t src_height,
-	Color32* const dst,
-	const uint32_t dst_stride)
-{
-	for(uint32_t y = 0; y < src_height; ++y)
-	{
-		const Color32* const src_line = src + y * src_width;
-		Color32* dst_start_line = dst + y * scale * dst_stride;
-		for(uint32_t x = 0; x < src_width; ++x)
-		{
-			const Color32 c = src_line[x];
-			Color32* const dst_span_sart = dst_start_line + x * scale;
-			for(uint32_t dy = 0; dy < scale; ++dy)
-			{
-				Color32* const dst_line = dst_span_sart + dy * dst_stride;
-				for(uint32_t dx = 0; dx < scale; ++dx)
-				{
-					dst_line[dx] = c;
-				}
-			}
-		}
-	}
-}
-
-constexpr const uint32_t g_max_scale = 6;
-// This resolution is close to 320x200 from CGA/EGA, but has 1:1 pixel aspect ratio.
-const uint32_t g_framebuffer_width  = 320;
-const uint32_t g_framebuffer_height = 240;
-
-void CopyImageWithScale(
-	const uint32_t scale,
-	const Color32* src,
-	const uint32_t src_width,
-	const uint32_t src_height,
-	Color32* const dst,
-	const uint32_t dst_stride)
-{
-	auto func = CopyImageWithScaleImpl<1>;
-	switch(scale)
-	{
-	case 1: func = CopyImageWithScaleImpl<1>; break;
-	case 2: func = CopyImageWithScaleImpl<2>; break;
-	case 3: func = CopyImageWithScaleImpl<3>; break;
-	case 4: func = CopyImageWithScaleImpl<4>; break;
-	case 5: func = CopyImageWithScaleImpl<5>; break;
-	case 6: func = CopyImageWithScaleImpl<6>; break;
-	default: func = CopyImageWithScaleImpl<g_max_scale>; break;
-	}
-
-	func(src, src_width, src_height, dst, dst_stride);
-}
-
-template<uint32_t scale>
-void CopyImageWithCrtEffect(
-	const Color32* src,
-	const uint32_t src_width,
-	const uint32_t src_height,
-	Color32* const dst,
-	const uint32_t dst_stride)
-{
-	for(uint32_t y = 0; y < src_height; ++y)
-	{
-		const Color32* const src_line = src + src_width * y;
-		const Color32* const src_line_minus = src + src_width * (std::max(1u, y) - 1);
-		const Color32* const src_line_plus  = src + src_width * (std::min(src_height - 2, y) + 1);
-		Color32* dst_start_line = dst + y * scale * dst_stride;
-		for(uint32_t x = 0; x < src_width ; ++x)
-		{
-			const uint32_t x_minus = std::max(1u, x) - 1;
-			const uint32_t x_plus  = std::min(src_width - 2, x) + 1;
-			ColorComponents components = ColorComponentsShiftLeft(UnpackColor(src_line[x]), 4);
-			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(UnpackColor(src_line[x_minus]), 2));
-			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(UnpackColor(src_line[x_plus ]), 2));
-			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(UnpackColor(src_line_minus[x]), 1));
-			components = ColorComponentsAdd(components, ColorComponentsShiftLeft(UnpackColor(src_line_plus [x]), 1));
-			components = ColorComponentsAdd(components, UnpackColor(src_line_minus[x_minus]));
-			components = ColorComponentsAdd(components, UnpackColor(src_line_minus[x_plus ]));
-			components = ColorComponentsAdd(components, UnpackColor(src_line_plus [x_minus]));
-			components = ColorComponentsAdd(components, UnpackColor(src_line_plus [x_plus ]));
-			components = ColorComponentsShiftRight(components, 5);
-
-			for(uint32_t dx = 0; dx < scale; ++dx)
-			{
-				const uint32_t dst_x = x * scale + dx;
-				ColorComponents components_modified = components;
-				switch(dst_x % 3)
-				{
-				case 0:
-					components_modified[3] = components_modified[3] * 3 / 4;
-					components_modified[2] = components_modified[2] * 3 / 4;
-					break;
-				case 1:
-					components_modified[3] = components_modified[3] * 3 / 4;
-					components_modified[1] = components_modified[1] * 3 / 4;
-					break;
-				case 2:
-					components_modified[2] = components_modified[2] * 3 / 4;
-					components_modified[1] = components_modified[1] * 3 / 4;
-					break;
-				}
-
-				const Color32 color_packed = PackColor(components_modified);
-				for(uint32_t dy = 0; dy < scale; ++dy)
-				{
-					dst_start_line[dst_x + dy * dst_stride] = color_packed;
-				} // for dy
-			} // for dx
-		} // for src x
-	} // for src y
-}
-
-void CopyImageWithScaleAndCrtEffect(
-	const uint32_t scale,
-	const Color32* src,
-	const uint32_t src_width,
-	const uint32_t src_height,
-	Color32* const dst,
-	const uint32_t dst_stride)
-{
-	auto func = CopyImageWithScaleImpl<1>;
-	switch(scale)
-	{
-	case 1: func = CopyImageWithCrtEffect<1>; break;
-	case 2: func = CopyImageWithCrtEffect<2>; break;
-	case 3: func = CopyImageWithCrtEffect<3>; break;
-	case 4: func = CopyImageWithCrtEffect<4>; break;
-	case 5: func = CopyImageWithCrtEffect<5>; break;
-	case 6: func = CopyImageWithCrtEffect<6>; break;
-	default: func = CopyImageWithCrtEffect<g_max_scale>; break;
-	}
-
-	func(src, src_width, src_height, dst, dst_stride);
-}
+constexpr const uint32_t g_max_scale = g_max_image_scale;
 
-void SwapColorComponents(Color32* const buffer, const uint32_t stride, const uint32_t height)
+Palette MakePresentationPalette()
 {
+	Palette palette = MakeCGAPalette();
 #ifdef __EMSCRIPTEN__
-	for(uint32_t i= 0; i < stride * height; ++i)
+	// Red and blue components are swapped for canvas.
+	for(Color32& c : palette)
 	{
-		const Color32 c= buffer[i];
-		buffer[i]= (c & 0xFF00FF00) | ((c & 0x00FF0000) >> 16) | ((c & 0x000000FF) << 16);
+		c= (c & 0xFF00FF00) | ((c & 0x00FF0000) >> 16) | ((c & 0x000000FF) << 16);
 	}
-#else
-	(void)buffer;
-	(void)stride;
-	(void)height;
 #endif
+	return palette;
 }
 
 } // namespace
 
-SystemWindow::SystemWindow()
+SystemWindow::SystemWindow(const SystemWindowSettings& settings)
+	: worker_pool_(settings.num_post_process_threads)
+	, palette_(MakePresentationPalette())
 {
 	// TODO - check errors.
 	SDL_Init(SDL_INIT_VIDEO);
@@ -177,24 +45,59 @@ SystemWindow::SystemWindow()
 			SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
 			int(g_framebuffer_width * scale_), int(g_framebuffer_height * scale_),
 			window_flags);
+
+	if(settings.presentation_backend == PresentationBackend::StreamingTexture)
+	{
+		const Uint32 vsync_flag = settings.vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+		renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | vsync_flag);
+		if(renderer_ == nullptr)
+		{
+			// Software renderer works on machines without GPU.
+			renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_SOFTWARE | vsync_flag);
+		}
+
+		if(renderer_ != nullptr)
+		{
+			presentation_backend_ = PresentationBackend::StreamingTexture;
+			SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+			SDL_RenderSetLogicalSize(renderer_, int(g_framebuffer_width), int(g_framebuffer_height));
+			SDL_RenderSetIntegerScale(renderer_, SDL_TRUE);
+			SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+		}
+		else
+		{
+			std::fprintf(stderr, "Can't create renderer: %s, using window surface\n", SDL_GetError());
+		}
+	}
 }
 
 SystemWindow::~SystemWindow()
 {
+	if(texture_ != nullptr)
+	{
+		SDL_DestroyTexture(texture_);
+	}
+	if(renderer_ != nullptr)
+	{
+		SDL_DestroyRenderer(renderer_);
+	}
 	SDL_DestroyWindow(window_);
 }
 
-std::vector<SDL_Event> SystemWindow::GetEvents()
+void SystemWindow::GetInput(InputFrame& input)
 {
-	std::vector<SDL_Event> events;
+	input.Clear();
+
+	// Events which don't fit into input of this tick stay in SDL queue for next ticks.
 	SDL_Event event;
-	while( SDL_PollEvent(&event) != 0 )
+	while(!input.IsFull() && SDL_PollEvent(&event) != 0)
 	{
 		if(event.type == SDL_KEYDOWN)
 		{
 			if(event.key.keysym.scancode == SDL_SCANCODE_BACKSPACE)
 			{
 				use_crt_effect_ = !use_crt_effect_;
+				frame_diff_.Invalidate();
 			}
 			if(event.key.keysym.scancode == SDL_SCANCODE_MINUS && scale_ > 1)
 			{
@@ -207,75 +110,275 @@ std::vector<SDL_Event> SystemWindow::GetEvents()
 				UpdateWindowSize();
 			}
 		}
+		if(event.type == SDL_WINDOWEVENT)
+		{
+			// Window contents may be lost.
+			frame_diff_.Invalidate();
+		}
 
-		events.push_back(event);
+		input.AddEvent(event);
 	}
 
-	return events;
-}
-
-std::vector<bool> SystemWindow::GetKeyboardState()
-{
 	int key_count = 0;
 	const Uint8* const keyboard_state = SDL_GetKeyboardState(&key_count);
 
-	std::vector<bool> result(size_t(key_count), false);
-
-	for(size_t i = 0; i < size_t(key_count); ++i)
+	InputFrame::KeyboardState& result = input.GetKeyboardState();
+	const size_t num_keys = std::min(size_t(key_count), result.size());
+	for(size_t i = 0; i < num_keys; ++i)
 	{
 		result[i] = keyboard_state[i] != 0;
 	}
-
-	return result;
 }
 
 void SystemWindow::BeginFrame()
 {
-	surface_ = SDL_GetWindowSurface(window_);
+	if(presentation_backend_ == PresentationBackend::WindowSurface)
+	{
+		surface_ = SDL_GetWindowSurface(window_);
+	}
 }
 
 FrameBuffer SystemWindow::GetFrameBuffer()
 {
 	FrameBuffer frame_buffer;
-	frame_buffer.width  = uint32_t(surface_->w) / scale_;
-	frame_buffer.height = uint32_t(surface_->h) / scale_;
+	if(presentation_backend_ == PresentationBackend::WindowSurface)
+	{
+		frame_buffer.width  = uint32_t(surface_->w) / scale_;
+		frame_buffer.height = uint32_t(surface_->h) / scale_;
+	}
+	else
+	{
+		frame_buffer.width  = g_framebuffer_width;
+		frame_buffer.height = g_framebuffer_height;
+	}
 
 	frame_buffer_data_.resize(frame_buffer.width * frame_buffer.height, 0);
+	frame_buffer.stride = frame_buffer.width;
 	frame_buffer.data = frame_buffer_data_.data();
 
 	return frame_buffer;
 }
 
-void SystemWindow::EndFrame()
+void SystemWindow::EndFrame(const FrameBuffer frame_buffer)
+{
+	TRACE_ZONE("SystemWindow::EndFrame");
+
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point start_time = Clock::now();
+
+	if(presentation_backend_ == PresentationBackend::WindowSurface)
+	{
+		PostProcessToSurface(frame_buffer);
+	}
+	else
+	{
+		PostProcessToTexture(frame_buffer);
+	}
+
+	const Clock::time_point post_process_end_time = Clock::now();
+
+	if(presentation_backend_ == PresentationBackend::WindowSurface)
+	{
+		if(!update_rects_.empty())
+		{
+			SDL_UpdateWindowSurfaceRects(window_, update_rects_.data(), int(update_rects_.size()));
+		}
+		surface_= nullptr;
+	}
+	else
+	{
+		SDL_RenderPresent(renderer_);
+	}
+
+	const Clock::time_point present_end_time = Clock::now();
+	last_post_process_duration_ns_ =
+		uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(post_process_end_time - start_time).count());
+	last_present_duration_ns_ =
+		uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(present_end_time - post_process_end_time).count());
+}
+
+void SystemWindow::UpdateWindowSize()
+{
+	frame_diff_.Invalidate();
+	SDL_SetWindowSize(window_, int(g_framebuffer_width * scale_), int(g_framebuffer_height * scale_));
+}
+
+void SystemWindow::PostProcessToSurface(const FrameBuffer frame_buffer)
 {
 	if(SDL_MUSTLOCK(surface_))
 	{
 		SDL_LockSurface(surface_);
 	}
 
-	const uint32_t src_width= uint32_t(surface_->w) / scale_;
-	const uint32_t src_height= uint32_t(surface_->h) / scale_;
+	const uint32_t src_width = std::min(frame_buffer.width, uint32_t(surface_->w) / scale_);
+	const uint32_t src_height = std::min(frame_buffer.height, uint32_t(surface_->h) / scale_);
+	const uint32_t src_stride = frame_buffer.stride;
+
+	// Surface keeps its contents between frames, so only changed tiles are processed and updated.
+	frame_diff_.Update(frame_buffer.data, src_width, src_height, src_stride);
+	const std::vector<FrameDiff::Rect>& changed_rects = frame_diff_.GetChangedRects();
+
+	const ColorIndex* const src = frame_buffer.data;
+	Color32* const dst = reinterpret_cast<Color32*>(surface_->pixels);
+	const uint32_t dst_stride = uint32_t(surface_->pitch) / sizeof(Color32);
+	const ImageScalingKernel kernel = GetBestImageScalingKernel();
+
+	update_rects_.clear();
+	if(use_crt_effect_)
+	{
+		// Blur spreads changes to neighbor pixels, so process whole rows, including one row above and one row below.
+		uint32_t y_begin = 0, y_end = 0;
+		const auto flush_rows =
+		[&]
+		{
+			if(y_end > y_begin)
+			{
+				crt_effect_.Apply(kernel, scale_, src, src_width, src_height, src_stride, y_begin, y_end, palette_, dst, dst_stride, worker_pool_);
+				update_rects_.push_back(
+					{0, int(y_begin * scale_), int(src_width * scale_), int((y_end - y_begin) * scale_)});
+			}
+		};
 
-	SwapColorComponents(frame_buffer_data_.data(), src_width, src_height);
+		for(const FrameDiff::Rect& rect : changed_rects)
+		{
+			const uint32_t rect_y_begin = std::max(rect.y, 1u) - 1;
+			const uint32_t rect_y_end = std::min(rect.y + rect.height + 1, src_height);
+			if(rect_y_begin <= y_end && y_end > y_begin)
+			{
+				y_end = std::max(y_end, rect_y_end);
+			}
+			else
+			{
+				flush_rows();
+				y_begin = rect_y_begin;
+				y_end = rect_y_end;
+			}
+		}
+		flush_rows();
+	}
+	else
+	{
+		worker_pool_.ParallelForBands(
+			uint32_t(changed_rects.size()),
+			[&](const uint32_t band_index, const uint32_t rect_begin, const uint32_t rect_end)
+			{
+				(void)band_index;
+				TRACE_ZONE("CopyImageWithScaleBand");
+				for(uint32_t i = rect_begin; i < rect_end; ++i)
+				{
+					const FrameDiff::Rect& rect = changed_rects[i];
+					CopyImageWithScale(
+						kernel,
+						false,
+						scale_,
+						src + rect.y * src_stride + rect.x,
+						rect.width,
+						rect.height,
+						src_stride,
+						palette_,
+						dst + rect.y * scale_ * dst_stride + rect.x * scale_,
+						dst_stride);
+				}
+			});
 
-	(use_crt_effect_ ? CopyImageWithScaleAndCrtEffect : CopyImageWithScale)(
-		scale_,
-		frame_buffer_data_.data(),
-		src_width,
-		src_height,
-		reinterpret_cast<Color32*>(surface_->pixels),
-		uint32_t(surface_->pitch) / sizeof(Color32));
+		for(const FrameDiff::Rect& rect : changed_rects)
+		{
+			update_rects_.push_back(
+				{int(rect.x * scale_), int(rect.y * scale_), int(rect.width * scale_), int(rect.height * scale_)});
+		}
+	}
 
 	if(SDL_MUSTLOCK(surface_))
 	{
 		SDL_UnlockSurface(surface_);
 	}
-
-	SDL_UpdateWindowSurface(window_);
-	surface_= nullptr;
 }
 
-void SystemWindow::UpdateWindowSize()
+void SystemWindow::PostProcessToTexture(const FrameBuffer frame_buffer)
 {
-	SDL_SetWindowSize(window_, int(g_framebuffer_width * scale_), int(g_framebuffer_height * scale_));
+	// Texture has frame buffer size, except with CRT effect, which is applied in window resolution.
+	const uint32_t texture_scale = use_crt_effect_ ? scale_ : 1;
+	if(texture_ == nullptr || texture_scale != texture_scale_)
+	{
+		if(texture_ != nullptr)
+		{
+			SDL_DestroyTexture(texture_);
+		}
+
+		// Use format without alpha in order to avoid blending.
+		texture_ =
+			SDL_CreateTexture(
+				renderer_,
+				SDL_PIXELFORMAT_RGB888,
+				SDL_TEXTUREACCESS_STREAMING,
+				int(g_framebuffer_width * texture_scale),
+				int(g_framebuffer_height * texture_scale));
+		texture_scale_ = texture_scale;
+		frame_diff_.Invalidate();
+	}
+
+	if(texture_ == nullptr)
+	{
+		return;
+	}
+
+	// Texture keeps its contents, so upload only changed tiles.
+	const uint32_t src_width = std::min(frame_buffer.width, g_framebuffer_width);
+	const uint32_t src_height = std::min(frame_buffer.height, g_framebuffer_height);
+	frame_diff_.Update(frame_buffer.data, src_width, src_height, frame_buffer.stride);
+	const std::vector<FrameDiff::Rect>& changed_rects = frame_diff_.GetChangedRects();
+
+	if(use_crt_effect_)
+	{
+		// Contents of locked texture are undefined, so whole texture should be written.
+		void* pixels = nullptr;
+		int pitch = 0;
+		if(!changed_rects.empty() && SDL_LockTexture(texture_, nullptr, &pixels, &pitch) == 0)
+		{
+			crt_effect_.Apply(
+				GetBestImageScalingKernel(),
+				scale_,
+				frame_buffer.data,
+				src_width,
+				src_height,
+				frame_buffer.stride,
+				0,
+				src_height,
+				palette_,
+				reinterpret_cast<Color32*>(pixels),
+				uint32_t(pitch) / sizeof(Color32),
+				worker_pool_);
+
+			SDL_UnlockTexture(texture_);
+		}
+	}
+	else
+	{
+		// Expand changed rects directly into locked texture memory.
+		const ImageScalingKernel kernel = GetBestImageScalingKernel();
+		for(const FrameDiff::Rect& rect : changed_rects)
+		{
+			const SDL_Rect texture_rect{int(rect.x), int(rect.y), int(rect.width), int(rect.height)};
+			void* pixels = nullptr;
+			int pitch = 0;
+			if(SDL_LockTexture(texture_, &texture_rect, &pixels, &pitch) == 0)
+			{
+				CopyImageWithScale(
+					kernel,
+					false,
+					1,
+					frame_buffer.GetRow(rect.y) + rect.x,
+					rect.width,
+					rect.height,
+					frame_buffer.stride,
+					palette_,
+					reinterpret_cast<Color32*>(pixels),
+					uint32_t(pitch) / sizeof(Color32));
+				SDL_UnlockTexture(texture_);
+			}
+		}
+	}
+
+	SDL_RenderClear(renderer_);
+	SDL_RenderCopy(renderer_, texture_, nullptr, nullptr);
 }
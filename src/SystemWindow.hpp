@@ -1,30 +1,75 @@
 #pragma once
+#include "CrtEffect.hpp"
 #include "FrameBuffer.hpp"
+#include "FrameDiff.hpp"
+#include "InputFrame.hpp"
 #include <SDL_video.h>
-#include <SDL_events.h>
 #include <vector>
 
+struct SDL_Renderer;
+struct SDL_Texture;
+
+// Ways to show frame buffer in window.
+enum class PresentationBackend : uint8_t
+{
+	// Upscale frame buffer on CPU into window surface.
+	WindowSurface,
+	// Upload frame buffer into streaming texture and let renderer upscale it.
+	// With CRT effect texture has full window size and effect is still applied on CPU.
+	StreamingTexture,
+};
+
+struct SystemWindowSettings
+{
+	PresentationBackend presentation_backend = PresentationBackend::WindowSurface;
+	// Supported only by streaming texture backend.
+	bool vsync = false;
+	// Post-processing is split between calling thread and this number of worker threads.
+	uint32_t num_post_process_threads = 0;
+};
 
 class SystemWindow
 {
 public:
-	SystemWindow();
+	// Falls back to window surface backend if renderer can't be created.
+	explicit SystemWindow(const SystemWindowSettings& settings);
 	~SystemWindow();
 
-	std::vector<SDL_Event> GetEvents();
-	std::vector<bool> GetKeyboardState();
+	void GetInput(InputFrame& input);
 
 	void BeginFrame();
 	FrameBuffer GetFrameBuffer();
-	void EndFrame();
+	// Given frame buffer may be not the one returned by "GetFrameBuffer".
+	void EndFrame(FrameBuffer frame_buffer);
+
+	// Durations of scaling with effects and presentation in last "EndFrame" call.
+	uint64_t GetLastPostProcessDurationNs() const { return last_post_process_duration_ns_; }
+	uint64_t GetLastPresentDurationNs() const { return last_present_duration_ns_; }
+
+	PresentationBackend GetPresentationBackend() const { return presentation_backend_; }
 
 private:
 	void UpdateWindowSize();
 
+	void PostProcessToSurface(FrameBuffer frame_buffer);
+	void PostProcessToTexture(FrameBuffer frame_buffer);
+
 private:
 	SDL_Window* window_= nullptr;
 	SDL_Surface* surface_= nullptr;
+	PresentationBackend presentation_backend_ = PresentationBackend::WindowSurface;
+	SDL_Renderer* renderer_ = nullptr;
+	SDL_Texture* texture_ = nullptr;
+	uint32_t texture_scale_ = 0;
 	uint32_t scale_ = 1;
 	bool use_crt_effect_ = true;
-	std::vector<Color32> frame_buffer_data_;
+	CrtEffect crt_effect_;
+	FrameDiff frame_diff_;
+	std::vector<SDL_Rect> update_rects_;
+	WorkerPool worker_pool_;
+	std::vector<ColorIndex> frame_buffer_data_;
+	// Frame buffer indices are expanded into colors during post-processing.
+	Palette palette_;
+	uint64_t last_post_process_duration_ns_ = 0;
+	uint64_t last_present_duration_ns_ = 0;
 };
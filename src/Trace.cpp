@@ -0,0 +1,230 @@
+#include "Trace.hpp"
+
+#ifdef ENABLE_TRACING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace
+{
+
+namespace
+{
+
+enum class EventType : uint8_t
+{
+	Zone,
+	Counter,
+	Instant,
+};
+
+struct Event
+{
+	const char* name;
+	uint64_t timestamp_ns;
+	int64_t value; // Duration for zones.
+	EventType type;
+};
+
+// Slot of ring buffer, which may be read by dumping thread while owning thread overwrites it.
+// Protected by sequence lock: sequence is odd during writing and is "2 * (event index + 1)" after writing.
+// Fields are atomic (accessed with relaxed order) in order to avoid data race on torn reads, which are detected and skipped.
+struct EventSlot
+{
+	std::atomic<uint64_t> sequence{0};
+	std::atomic<const char*> name{nullptr};
+	std::atomic<uint64_t> timestamp_ns{0};
+	std::atomic<int64_t> value{0};
+	std::atomic<EventType> type{EventType::Zone};
+};
+
+// Written only by owning thread. Oldest events are overwritten if buffer is full.
+struct ThreadBuffer
+{
+	static constexpr size_t c_capacity = 1 << 15;
+
+	std::array<EventSlot, c_capacity> events;
+	std::atomic<uint64_t> num_written{0};
+	std::atomic<const char*> name{nullptr};
+	uint32_t thread_id = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point g_start_time = Clock::now();
+
+// Buffers are never freed in order to keep events of finished threads.
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+
+thread_local ThreadBuffer* g_thread_buffer = nullptr;
+
+ThreadBuffer& GetThreadBuffer()
+{
+	if(g_thread_buffer == nullptr)
+	{
+		// Lock only once per thread.
+		const std::lock_guard<std::mutex> lock(g_buffers_mutex);
+		g_buffers.push_back(std::make_unique<ThreadBuffer>());
+		g_thread_buffer = g_buffers.back().get();
+		g_thread_buffer->thread_id = uint32_t(g_buffers.size());
+	}
+
+	return *g_thread_buffer;
+}
+
+void AddEvent(const EventType type, const char* const name, const uint64_t timestamp_ns, const int64_t value)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	const uint64_t index = buffer.num_written.load(std::memory_order_relaxed);
+
+	EventSlot& slot = buffer.events[index % ThreadBuffer::c_capacity];
+	slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+	slot.value.store(value, std::memory_order_relaxed);
+	slot.type.store(type, std::memory_order_relaxed);
+	slot.sequence.store(index * 2 + 2, std::memory_order_release);
+
+	buffer.num_written.store(index + 1, std::memory_order_release);
+}
+
+// Returns false if event was overwritten or is being overwritten by owning thread.
+bool ReadEvent(const ThreadBuffer& buffer, const uint64_t index, Event& out_event)
+{
+	const EventSlot& slot = buffer.events[index % ThreadBuffer::c_capacity];
+	const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+	if(sequence != index * 2 + 2)
+	{
+		return false;
+	}
+
+	out_event.name = slot.name.load(std::memory_order_relaxed);
+	out_event.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+	out_event.value = slot.value.load(std::memory_order_relaxed);
+	out_event.type = slot.type.load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+// Write string as JSON string literal.
+void WriteJSONString(std::FILE* const f, const char* const str)
+{
+	std::fputc('"', f);
+	for(const char* c = str; *c != '\0'; ++c)
+	{
+		if(*c == '"' || *c == '\\')
+		{
+			std::fputc('\\', f);
+			std::fputc(*c, f);
+		}
+		else if(uint8_t(*c) < 0x20)
+		{
+			std::fprintf(f, "\\u%04x", uint32_t(uint8_t(*c)));
+		}
+		else
+		{
+			std::fputc(*c, f);
+		}
+	}
+	std::fputc('"', f);
+}
+
+} // namespace
+
+uint64_t GetTimestampNs()
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_start_time).count());
+}
+
+void AddZone(const char* const name, const uint64_t start_ns, const uint64_t end_ns)
+{
+	AddEvent(EventType::Zone, name, start_ns, int64_t(end_ns - start_ns));
+}
+
+void AddCounter(const char* const name, const int64_t value)
+{
+	AddEvent(EventType::Counter, name, GetTimestampNs(), value);
+}
+
+void AddInstant(const char* const name)
+{
+	AddEvent(EventType::Instant, name, GetTimestampNs(), 0);
+}
+
+void SetThreadName(const char* const name)
+{
+	GetThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+bool DumpToFile(const char* const file_name)
+{
+	std::FILE* const f = std::fopen(file_name, "wb");
+	if(f == nullptr)
+	{
+		return false;
+	}
+
+	std::fprintf(f, "{\"traceEvents\":[\n");
+	bool first = true;
+	const auto separator = [&]{ const char* const s = first ? "" : ",\n"; first = false; return s; };
+
+	const std::lock_guard<std::mutex> lock(g_buffers_mutex);
+	for(const auto& buffer : g_buffers)
+	{
+		const uint32_t tid = buffer->thread_id;
+		if(const char* const name = buffer->name.load(std::memory_order_relaxed))
+		{
+			std::fprintf(f, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", separator(), tid);
+			WriteJSONString(f, name);
+			std::fprintf(f, "}}");
+		}
+
+		// Other thread may overwrite oldest events while dumping, such events are skipped.
+		const uint64_t num_written = buffer->num_written.load(std::memory_order_acquire);
+		const uint64_t first_index = num_written > ThreadBuffer::c_capacity ? num_written - ThreadBuffer::c_capacity : 0;
+		for(uint64_t i = first_index; i < num_written; ++i)
+		{
+			Event event;
+			if(!ReadEvent(*buffer, i, event))
+			{
+				continue;
+			}
+
+			const double ts_us = double(event.timestamp_ns) / 1000.0;
+			switch(event.type)
+			{
+			case EventType::Zone:
+				std::fprintf(f, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":", separator(), tid);
+				WriteJSONString(f, event.name);
+				std::fprintf(f, ",\"ts\":%.3f,\"dur\":%.3f}", ts_us, double(event.value) / 1000.0);
+				break;
+			case EventType::Counter:
+				std::fprintf(f, "%s{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"name\":", separator(), tid);
+				WriteJSONString(f, event.name);
+				std::fprintf(f, ",\"ts\":%.3f,\"args\":{\"value\":%" PRId64 "}}", ts_us, event.value);
+				break;
+			case EventType::Instant:
+				std::fprintf(f, "%s{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"name\":", separator(), tid);
+				WriteJSONString(f, event.name);
+				std::fprintf(f, ",\"ts\":%.3f}", ts_us);
+				break;
+			}
+		}
+	}
+
+	std::fprintf(f, "\n]}\n");
+	std::fclose(f);
+	return true;
+}
+
+} // namespace Trace
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+// Lightweight instrumentation - scoped zones, counters and instant events.
+// Events are stored in per-thread lock-free ring buffers and may be dumped as Chrome trace-event JSON,
+// which can be loaded into chrome://tracing or Perfetto.
+// Enabled only if "ENABLE_TRACING" is defined, otherwise all macros expand to nothing.
+// Names must be string literals, since only pointers are stored.
+
+#ifdef ENABLE_TRACING
+
+namespace Trace
+{
+
+uint64_t GetTimestampNs();
+
+void AddZone(const char* name, uint64_t start_ns, uint64_t end_ns);
+void AddCounter(const char* name, int64_t value);
+void AddInstant(const char* name);
+void SetThreadName(const char* name);
+
+// Dump events of all threads. Returns false on failure.
+bool DumpToFile(const char* file_name);
+
+class ScopedZone
+{
+public:
+	explicit ScopedZone(const char* const name)
+		: name_(name), start_ns_(GetTimestampNs())
+	{}
+
+	~ScopedZone()
+	{
+		AddZone(name_, start_ns_, GetTimestampNs());
+	}
+
+	ScopedZone(const ScopedZone&) = delete;
+	ScopedZone& operator=(const ScopedZone&) = delete;
+
+private:
+	const char* const name_;
+	const uint64_t start_ns_;
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#define TRACE_ZONE(name) const Trace::ScopedZone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) Trace::AddCounter(name, int64_t(value))
+#define TRACE_INSTANT(name) Trace::AddInstant(name)
+#define TRACE_THREAD_NAME(name) Trace::SetThreadName(name)
+#define TRACE_DUMP(file_name) Trace::DumpToFile(file_name)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_INSTANT(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_DUMP(file_name) ((void)0)
+
+#endif
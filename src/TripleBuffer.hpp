@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer for passing latest value from one writer thread to one reader thread.
+// Writer and reader never wait for each other. Reader may skip some values if writer is faster.
+template<typename T>
+class TripleBuffer
+{
+public:
+	explicit TripleBuffer(const T& initial_value = T())
+		: buffers_{initial_value, initial_value, initial_value}
+	{}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Writer side. Fill buffer and publish it.
+	T& GetWriteBuffer() { return buffers_[write_index_]; }
+
+	void Publish()
+	{
+		write_index_ = uint8_t(middle_.exchange(uint8_t(write_index_ | c_fresh_flag), std::memory_order_acq_rel) & c_index_mask);
+	}
+
+	// Reader side. Returns true if new value was published since previous call.
+	bool Update()
+	{
+		if((middle_.load(std::memory_order_relaxed) & c_fresh_flag) == 0)
+		{
+			return false;
+		}
+
+		read_index_ = uint8_t(middle_.exchange(read_index_, std::memory_order_acq_rel) & c_index_mask);
+		return true;
+	}
+
+	// Reader may modify its buffer. Writer gets it back later, so writer should overwrite whole value.
+	T& GetReadBuffer() { return buffers_[read_index_]; }
+	const T& GetReadBuffer() const { return buffers_[read_index_]; }
+
+private:
+	static constexpr uint8_t c_index_mask = 3;
+	static constexpr uint8_t c_fresh_flag = 4;
+
+private:
+	std::array<T, 3> buffers_;
+	// Index of buffer between writer and reader and flag, indicating that it contains unread value.
+	std::atomic<uint8_t> middle_{1};
+	uint8_t write_index_ = 0; // Accessed only by writer.
+	uint8_t read_index_ = 2; // Accessed only by reader.
+};
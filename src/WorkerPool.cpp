@@ -0,0 +1,114 @@
+#include "WorkerPool.hpp"
+#include "Trace.hpp"
+
+uint32_t WorkerPool::GetDefaultNumThreads()
+{
+#ifdef __EMSCRIPTEN__
+	return 0;
+#else
+	const uint32_t num_hardware_threads = std::thread::hardware_concurrency();
+	return num_hardware_threads > 1 ? num_hardware_threads - 1 : 0;
+#endif
+}
+
+WorkerPool::WorkerPool(const uint32_t num_threads)
+{
+	threads_.reserve(num_threads);
+	for(uint32_t i = 0; i < num_threads; ++i)
+	{
+		threads_.emplace_back([this]{ ThreadFunc(); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	work_condition_.notify_all();
+
+	for(std::thread& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::Run(const uint32_t num_tasks, const TaskFunc task_func, const void* const context)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		// Threads which woke up too late for previous work may still check task counter. Wait for them before resetting it.
+		done_condition_.wait(lock, [&]{ return num_active_threads_ == 0; });
+
+		++generation_;
+		num_tasks_ = num_tasks;
+		task_func_ = task_func;
+		context_ = context;
+		next_task_.store(0, std::memory_order_relaxed);
+		num_remaining_tasks_.store(num_tasks, std::memory_order_relaxed);
+	}
+	work_condition_.notify_all();
+
+	ProcessTasks(num_tasks, task_func, context);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_condition_.wait(lock, [&]{ return num_remaining_tasks_.load(std::memory_order_acquire) == 0; });
+}
+
+void WorkerPool::ProcessTasks(const uint32_t num_tasks, const TaskFunc task_func, const void* const context)
+{
+	while(true)
+	{
+		const uint32_t task_index = next_task_.fetch_add(1, std::memory_order_relaxed);
+		if(task_index >= num_tasks)
+		{
+			break;
+		}
+
+		task_func(context, task_index);
+
+		if(num_remaining_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			// Take lock in order to avoid notification between predicate check and waiting.
+			const std::lock_guard<std::mutex> lock(mutex_);
+			done_condition_.notify_all();
+		}
+	}
+}
+
+void WorkerPool::ThreadFunc()
+{
+	TRACE_THREAD_NAME("Worker");
+
+	uint64_t last_generation = 0;
+	while(true)
+	{
+		uint32_t num_tasks = 0;
+		TaskFunc task_func = nullptr;
+		const void* context = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			work_condition_.wait(lock, [&]{ return quit_ || generation_ != last_generation; });
+			if(quit_)
+			{
+				break;
+			}
+
+			last_generation = generation_;
+			num_tasks = num_tasks_;
+			task_func = task_func_;
+			context = context_;
+			++num_active_threads_;
+		}
+
+		ProcessTasks(num_tasks, task_func, context);
+
+		{
+			const std::lock_guard<std::mutex> lock(mutex_);
+			--num_active_threads_;
+		}
+		done_condition_.notify_all();
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for data-parallel work. Calling thread participates in work too.
+// With zero threads all work is executed inline.
+class WorkerPool
+{
+public:
+	// Number of hardware threads minus one (for calling thread), zero if hardware has single thread or threads are not available.
+	static uint32_t GetDefaultNumThreads();
+
+	explicit WorkerPool(uint32_t num_threads);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Number of threads (including calling thread) which process work simultaneously.
+	uint32_t GetConcurrency() const { return uint32_t(threads_.size()) + 1; }
+
+	// Split rows [0; num_rows) into at most "GetConcurrency()" horizontal bands and process them in parallel.
+	// Function is called as "func(band_index, y_begin, y_end)". Blocks until all bands are processed.
+	template<typename Func>
+	void ParallelForBands(const uint32_t num_rows, const Func& func)
+	{
+		const uint32_t num_bands = std::min(GetConcurrency(), num_rows);
+		if(num_bands <= 1)
+		{
+			func(0u, 0u, num_rows);
+			return;
+		}
+
+		const auto task_func =
+		[&](const uint32_t band_index)
+		{
+			func(band_index, num_rows * band_index / num_bands, num_rows * (band_index + 1) / num_bands);
+		};
+		Run(
+			num_bands,
+			[](const void* const context, const uint32_t task_index)
+			{
+				(*static_cast<const decltype(task_func)*>(context))(task_index);
+			},
+			&task_func);
+	}
+
+private:
+	using TaskFunc = void(*)(const void* context, uint32_t task_index);
+
+private:
+	void Run(uint32_t num_tasks, TaskFunc task_func, const void* context);
+	void ProcessTasks(uint32_t num_tasks, TaskFunc task_func, const void* context);
+	void ThreadFunc();
+
+private:
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+	std::condition_variable work_condition_;
+	std::condition_variable done_condition_;
+
+	// Protected by mutex.
+	uint64_t generation_ = 0;
+	uint32_t num_tasks_ = 0;
+	TaskFunc task_func_ = nullptr;
+	const void* context_ = nullptr;
+	uint32_t num_active_threads_ = 0;
+	bool quit_ = false;
+
+	std::atomic<uint32_t> next_task_{0};
+	std::atomic<uint32_t> num_remaining_tasks_{0};
+};
@@ -0,0 +1,73 @@
+#pragma once
+// File helpers, shared by build-time tools ("AssetPacker", "SpriteCompiler").
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+inline bool ReadFile(const std::string& path, std::vector<uint8_t>& out_content)
+{
+	std::FILE* const f = std::fopen(path.c_str(), "rb");
+	if(f == nullptr)
+	{
+		return false;
+	}
+
+	out_content.clear();
+	uint8_t buffer[4096];
+	size_t read;
+	while((read = std::fread(buffer, 1, sizeof(buffer), f)) > 0)
+	{
+		out_content.insert(out_content.end(), buffer, buffer + read);
+	}
+
+	std::fclose(f);
+	return true;
+}
+
+// List file contains one path per line, empty lines are skipped.
+inline bool ReadListFile(const std::string& path, std::vector<std::string>& out_paths)
+{
+	std::vector<uint8_t> content;
+	if(!ReadFile(path, content))
+	{
+		return false;
+	}
+
+	out_paths.clear();
+	std::string line;
+	for(const uint8_t c : content)
+	{
+		if(c == '\n' || c == '\r')
+		{
+			if(!line.empty())
+			{
+				out_paths.push_back(line);
+			}
+			line.clear();
+		}
+		else
+		{
+			line.push_back(char(c));
+		}
+	}
+	if(!line.empty())
+	{
+		out_paths.push_back(line);
+	}
+
+	return true;
+}
+
+inline bool WriteFile(const std::string& path, const std::string& content)
+{
+	std::FILE* const f = std::fopen(path.c_str(), "wb");
+	if(f == nullptr)
+	{
+		return false;
+	}
+
+	const bool written = std::fwrite(content.data(), 1, content.size(), f) == content.size();
+	return std::fclose(f) == 0 && written;
+}